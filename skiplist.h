@@ -10,25 +10,53 @@
 #ifndef FILE_SKIPLIST_H_INCLUDED
 #define FILE_SKIPLIST_H_INCLUDED
 
-#include <memory>	// for std::shared_ptr, std::make_shared
+#include <memory>	// for std::shared_ptr, std::make_shared, std::allocate_shared, std::allocator
 #include <limits>	// for std::numeric_limits
 #include <random>	// for std::minstd_rand, std::uniform_real_distribution
+#include <vector>	// for std::vector
+#include <deque>	// for std::deque
+#include <set>		// for std::multiset
+#include <mutex>	// for std::mutex, std::lock_guard
+#include <atomic>	// for std::atomic
+#include <algorithm>	// for std::is_sorted, std::sort, std::min, std::max
+#include <string>	// for std::string
+#include <fstream>	// for std::ifstream
+#include <stdexcept>	// for std::runtime_error, std::invalid_argument
+#include <cstdint>	// for std::uint32_t
+#include <cmath>	// for std::log
+#include <cstring>	// for std::strerror
+#include <cerrno>	// for errno, EINTR
+#include <unistd.h>	// for read, write, pwrite, fsync, close, unlink
+#include <fcntl.h>	// for open
+#include <cstdio>	// for std::rename
+#include <new>		// for ::operator new, ::operator delete, placement new
+#include <thread>	// for std::thread
+#include <utility>	// for std::move, std::swap
+#include <cstddef>	// for std::size_t
 
 // Global Variables
 // Edit these to change the performance of the skip list. Pugh recommends a proportion of 0.25 unless 
 // "the variability of running times is a primary concern" in which case use 0.5.
 const double proportion = 0.25;	// Each level has this proportion of nodes relative to the level below it
 const int MaxLevel = 16;	// MaxLevel for 2^32 nodes with a _proportion of 1/4 is log base 1/(_proportion) 2^16 is 16
+const unsigned long long NoSequence = std::numeric_limits<unsigned long long>::max();	// _endSequence of a node that has not been removed
 
 // struct SkipListNode
-// Skip List int node. SkipListNode objects should be created with std::make_shared and owned by a std::shared_ptr.
+// Skip List int node. SkipListNode objects should be created with std::make_shared or std::allocate_shared
+// and owned by a std::shared_ptr.
 // An empty list consists of the head and tail (NIL in Pugh's paper) nodes with nothing between them.
 //
+// Each node records the write sequence numbers that inserted and removed it. A node is visible
+// to a reader at sequence s when _beginSequence <= s < _endSequence.
+//
 // Invariants:
 //		_key == key
 //		_forwardNodes is an array of nullptr or ptrs to other nodes
+//		_beginSequence < _endSequence
 struct SkipListNode {
 	int _key;
+	unsigned long long _beginSequence;
+	unsigned long long _endSequence;
 	std::shared_ptr<SkipListNode> _forwardNodes[MaxLevel];
 	
 	// Parameterized Constructor
@@ -38,11 +66,12 @@ struct SkipListNode {
 	//		key is not empty
 	// Postconditions:
 	//		_key == key
+	//		Node is visible at every sequence until it is removed
 	// Exceptions: 
 	//		
 	// Strong Guarantee, Exception Neutral
 	explicit SkipListNode(int key)
-		: _key(key)
+		: _key(key), _beginSequence(0), _endSequence(NoSequence)
 	{
 		for (int i = 0; i < MaxLevel; i++)
 			_forwardNodes[i] = nullptr;
@@ -81,18 +110,901 @@ int randomLevel()
 	return level;
 }
 
-// class SkipList
+// enum SkipListOperation
+// The operations an instrumentation policy tells apart.
+enum SkipListOperation { SkipListSearch, SkipListInsert, SkipListRemove, SkipListOperations };
+
+// struct NoInstrumentation
+// The default instrumentation policy of BasicSkipList. Its Probe does nothing but compare, and
+// every member is an empty inline function, so an uninstrumented list compiles to the same code
+// as one with no hooks at all.
+//
+// An instrumentation policy has a nested Probe type, made on the stack for one operation with
+// Probe(policy, operation, key). The list calls probe.less(a, b) and probe.equal(a, b) for every key
+// comparison and probe.hop(level) for every step along a level; the Probe reports to the policy
+// when it is destroyed.
+struct NoInstrumentation {
+	struct Probe {
+		Probe() {}
+		Probe(NoInstrumentation &, SkipListOperation, int) {}
+		bool less(int a, int b) { return a < b; }
+		bool equal(int a, int b) { return a == b; }
+		void hop(int) {}
+	};
+};
+
+// struct SkipListOperationStats
+// What CountingInstrumentation has seen of one kind of operation. Histogram bucket 0 counts
+// operations with no hops or comparisons; bucket b > 0 counts those with [2^(b-1), 2^b) of them.
+struct SkipListOperationStats {
+	static const int HistogramBuckets = 33;
+	unsigned long long operations = 0;
+	unsigned long long hopsByLevel[MaxLevel] = {};			// Hops taken on each level, over all operations
+	unsigned long long startLevels[MaxLevel] = {};			// Operations whose first hop was on each level, 0 if none
+	unsigned long long hopHistogram[HistogramBuckets] = {};
+	unsigned long long comparisonHistogram[HistogramBuckets] = {};
+};
+
+// struct SkipListStats
+// What CountingInstrumentation has seen, by operation.
+struct SkipListStats {
+	SkipListOperationStats search;
+	SkipListOperationStats insert;
+	SkipListOperationStats remove;
+};
+
+// struct SkipListReport
+// The shape and memory use of a list, from BasicSkipList::analyze or an Analyzer.
+// Byte counts for allocator overhead assume each node comes from one make_shared allocation
+// with a two-word control block, rounded up to 16 bytes with an 8-byte header as glibc malloc does.
+struct SkipListReport {
+	unsigned long long nodes = 0;
+	int height = 0;											// Levels in use
+	unsigned long long levelCounts[MaxLevel] = {};			// Nodes linked on each level
+	double expectedLevelCounts[MaxLevel] = {};				// nodes * proportion^level
+	double meanSearchPath = 0.0;							// Steps to find a key, over every key: hops plus moves down a level
+	unsigned long long maxSearchPath = 0;
+	double expectedSearchPath = 0.0;						// Pugh's bound on the mean: log_{1/p}(n) / p + 1 / (1 - p)
+	unsigned long long keyBytes = 0;						// The keys themselves
+	unsigned long long linkBytes = 0;						// Links in use
+	unsigned long long unusedLinkBytes = 0;					// Link slots above each node's height
+	unsigned long long otherNodeBytes = 0;					// Sequence numbers and padding
+	unsigned long long allocatorOverheadBytes = 0;			// Control blocks, malloc headers and rounding
+	unsigned long long totalBytes = 0;
+	double fragmentation = 0.0;								// Share of totalBytes not holding keys or links in use
+};
+
+// class CountingInstrumentation
+// An instrumentation policy that counts, for every search, insert and remove, the hops taken on
+// each level, the key comparisons made and the level of the first hop, and keeps them as the
+// totals and histograms of SkipListStats. Healthy lists take a handful of hops a level and
+// start near level log4(n); a list whose hops pile up on level 0, or whose operations all start
+// low, has degenerate towers.
+//
+// Each Probe counts in local variables and adds its totals to the shared counters once, when the
+// operation ends, with relaxed atomics, so concurrent searches may share one policy.
+//
+// Invariants:
+//		Each counter is the total of the matching SkipListOperationStats field over every finished Probe
+class CountingInstrumentation {
+public:
+	class Probe {
+	private:
+		CountingInstrumentation * _counters;
+		SkipListOperation _operation;
+		unsigned _hopsByLevel[MaxLevel];
+		unsigned long long _comparisons;
+		int _startLevel;
+
+	public:
+		Probe(CountingInstrumentation & counters, SkipListOperation operation, int)
+			: _counters(&counters), _operation(operation), _hopsByLevel(), _comparisons(0), _startLevel(-1)
+		{}
+
+		Probe(const Probe & other) = delete;
+		Probe & operator=(const Probe & other) = delete;
+
+		~Probe()
+		{
+			_counters->record(*this);
+		}
+
+		bool less(int a, int b)
+		{
+			_comparisons++;
+			return a < b;
+		}
+
+		bool equal(int a, int b)
+		{
+			_comparisons++;
+			return a == b;
+		}
+
+		void hop(int level)
+		{
+			if (_startLevel < 0)
+				_startLevel = level;
+			_hopsByLevel[level]++;
+		}
+
+		friend class CountingInstrumentation;
+	};
+
+private:
+	struct Counters {
+		std::atomic<unsigned long long> operations{0};
+		std::atomic<unsigned long long> hopsByLevel[MaxLevel] = {};
+		std::atomic<unsigned long long> startLevels[MaxLevel] = {};
+		std::atomic<unsigned long long> hopHistogram[SkipListOperationStats::HistogramBuckets] = {};
+		std::atomic<unsigned long long> comparisonHistogram[SkipListOperationStats::HistogramBuckets] = {};
+	};
+
+	Counters _counters[SkipListOperations];
+
+public:
+	CountingInstrumentation() = default;
+	CountingInstrumentation(const CountingInstrumentation & other) = delete;
+	CountingInstrumentation & operator=(const CountingInstrumentation & other) = delete;
+
+	// stats
+	// Returns the counts so far. Operations still in progress are not included.
+	//
+	// No-Throw Guarantee
+	SkipListStats stats() const
+	{
+		SkipListStats result;
+		copy(_counters[SkipListSearch], result.search);
+		copy(_counters[SkipListInsert], result.insert);
+		copy(_counters[SkipListRemove], result.remove);
+		return result;
+	}
+
+	// reset
+	// Sets every count back to zero.
+	//
+	// No-Throw Guarantee
+	void reset()
+	{
+		for (auto & counters : _counters)
+		{
+			counters.operations.store(0, std::memory_order_relaxed);
+			for (auto & count : counters.hopsByLevel)
+				count.store(0, std::memory_order_relaxed);
+			for (auto & count : counters.startLevels)
+				count.store(0, std::memory_order_relaxed);
+			for (auto & count : counters.hopHistogram)
+				count.store(0, std::memory_order_relaxed);
+			for (auto & count : counters.comparisonHistogram)
+				count.store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+	// bucket
+	// Returns the histogram bucket of count: 0 for 0, otherwise its number of significant bits.
+	//
+	// No-Throw Guarantee
+	static int bucket(unsigned long long count)
+	{
+		int bits = 0;
+		for (; count && bits < SkipListOperationStats::HistogramBuckets - 1; count >>= 1)
+			bits++;
+		return bits;
+	}
+
+	void record(const Probe & probe)
+	{
+		Counters & counters = _counters[probe._operation];
+		unsigned long long hops = 0;
+		for (int i = 0; i < MaxLevel; i++)
+		{
+			if (probe._hopsByLevel[i] == 0)
+				continue;
+			counters.hopsByLevel[i].fetch_add(probe._hopsByLevel[i], std::memory_order_relaxed);
+			hops += probe._hopsByLevel[i];
+		}
+		counters.operations.fetch_add(1, std::memory_order_relaxed);
+		counters.startLevels[probe._startLevel < 0 ? 0 : probe._startLevel].fetch_add(1, std::memory_order_relaxed);
+		counters.hopHistogram[bucket(hops)].fetch_add(1, std::memory_order_relaxed);
+		counters.comparisonHistogram[bucket(probe._comparisons)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static void copy(const Counters & counters, SkipListOperationStats & stats)
+	{
+		stats.operations = counters.operations.load(std::memory_order_relaxed);
+		for (int i = 0; i < MaxLevel; i++)
+		{
+			stats.hopsByLevel[i] = counters.hopsByLevel[i].load(std::memory_order_relaxed);
+			stats.startLevels[i] = counters.startLevels[i].load(std::memory_order_relaxed);
+		}
+		for (int i = 0; i < SkipListOperationStats::HistogramBuckets; i++)
+		{
+			stats.hopHistogram[i] = counters.hopHistogram[i].load(std::memory_order_relaxed);
+			stats.comparisonHistogram[i] = counters.comparisonHistogram[i].load(std::memory_order_relaxed);
+		}
+	}
+};
+
+// struct AllocationStats
+// What a CountingAllocator has seen: calls to allocate and deallocate, and the bytes they asked for.
+struct AllocationStats {
+	unsigned long long allocations = 0;
+	unsigned long long deallocations = 0;
+	unsigned long long allocatedBytes = 0;					// Every allocation, freed or not
+	unsigned long long liveBytes = 0;						// Allocated and not yet freed
+	unsigned long long peakBytes = 0;						// The most liveBytes has been
+};
+
+// struct AllocationCounters
+// The counters behind AllocationStats, shared by a CountingAllocator and all its rebound copies.
+struct AllocationCounters {
+	std::atomic<unsigned long long> allocations{0};
+	std::atomic<unsigned long long> deallocations{0};
+	std::atomic<unsigned long long> allocatedBytes{0};
+	std::atomic<unsigned long long> liveBytes{0};
+	std::atomic<unsigned long long> peakBytes{0};
+};
+
+// class CountingAllocator
+// An allocator that counts what it hands out and takes back, for BasicSkipList's Allocator
+// parameter. Copies, including the rebound copies that allocate_shared makes for the node and its
+// control block, share one set of counters, so every node of a list counts towards that list's
+// allocator, and a second list made with its own CountingAllocator counts separately.
+// Counters are relaxed atomics; stats() read during an operation on another thread may be a
+// mixture of before and after.
+//
+// Invariants:
+//		_counters is not null
+//		liveBytes == allocatedBytes - bytes of the deallocations, and peakBytes >= liveBytes
+template <typename T>
+class CountingAllocator {
+	template <typename U> friend class CountingAllocator;
+private:
+	std::shared_ptr<AllocationCounters> _counters;
+
+public:
+	typedef T value_type;
+
+	// Default Constructor
+	// Starts a new set of counters at zero.
+	//
+	// Exceptions: Throws if make_shared throws
+	// Strong Guarantee, Exception Neutral
+	CountingAllocator()
+		: _counters(std::make_shared<AllocationCounters>())
+	{}
+
+	// Converting Constructor
+	// Shares the counters of other.
+	//
+	// No-Throw Guarantee
+	template <typename U>
+	CountingAllocator(const CountingAllocator<U> & other) noexcept
+		: _counters(other._counters)
+	{}
+
+	// allocate
+	// Returns uninitialised memory for count objects of type T.
+	//
+	// Exceptions: Throws std::bad_alloc if the memory cannot be had
+	// Strong Guarantee
+	T * allocate(std::size_t count)
+	{
+		const unsigned long long bytes = count * sizeof(T);
+		T * memory = static_cast<T *>(::operator new(count * sizeof(T)));
+		_counters->allocations.fetch_add(1, std::memory_order_relaxed);
+		_counters->allocatedBytes.fetch_add(bytes, std::memory_order_relaxed);
+		unsigned long long live = _counters->liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		unsigned long long peak = _counters->peakBytes.load(std::memory_order_relaxed);
+		while (peak < live && !_counters->peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+			;
+		return memory;
+	}
+
+	// deallocate
+	// Frees memory returned by allocate(count).
+	//
+	// No-Throw Guarantee
+	void deallocate(T * memory, std::size_t count) noexcept
+	{
+		::operator delete(memory);
+		_counters->deallocations.fetch_add(1, std::memory_order_relaxed);
+		_counters->liveBytes.fetch_sub(count * sizeof(T), std::memory_order_relaxed);
+	}
+
+	// stats
+	// Returns the counts so far, shared by every copy of this allocator.
+	//
+	// No-Throw Guarantee
+	AllocationStats stats() const
+	{
+		AllocationStats result;
+		result.allocations = _counters->allocations.load(std::memory_order_relaxed);
+		result.deallocations = _counters->deallocations.load(std::memory_order_relaxed);
+		result.allocatedBytes = _counters->allocatedBytes.load(std::memory_order_relaxed);
+		result.liveBytes = _counters->liveBytes.load(std::memory_order_relaxed);
+		result.peakBytes = _counters->peakBytes.load(std::memory_order_relaxed);
+		return result;
+	}
+
+	template <typename U>
+	bool operator==(const CountingAllocator<U> & other) const noexcept
+	{
+		return _counters == other._counters;
+	}
+
+	template <typename U>
+	bool operator!=(const CountingAllocator<U> & other) const noexcept
+	{
+		return _counters != other._counters;
+	}
+};
+
+// struct DurableFile
+// File helpers shared by the classes that keep a SkipList on disk.
+// Integers are stored little-endian, least significant byte first, so files are the same on every
+// platform. replace writes a file under a temporary name next to it, syncs it, renames it over the
+// target and syncs the directory, so after a crash the target holds its old contents or all of
+// the new ones, never a mix, and a replacement that returned is not undone.
+struct DurableFile {
+	// encodeLittleEndian, appendLittleEndian, decodeLittleEndian
+	// Convert between an unsigned integer and its first bytes bytes, least significant first.
+	//
+	// appendLittleEndian: Strong Guarantee; encodeLittleEndian, decodeLittleEndian: No-Throw Guarantee
+	static void encodeLittleEndian(char * out, unsigned long long value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+			out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+
+	static void appendLittleEndian(std::vector<char> & out, unsigned long long value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+			out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+	}
+
+	static unsigned long long decodeLittleEndian(const char * in, int bytes)
+	{
+		unsigned long long value = 0;
+		for (int i = 0; i < bytes; i++)
+			value |= static_cast<unsigned long long>(static_cast<unsigned char>(in[i])) << (8 * i);
+		return value;
+	}
+
+	// writeAll
+	// Writes size bytes from data to fd, retrying short and interrupted writes.
+	// Returns false, with errno set, if a write fails.
+	//
+	// No-Throw Guarantee
+	static bool writeAll(int fd, const char * data, std::size_t size)
+	{
+		std::size_t done = 0;
+		while (done < size)
+		{
+			ssize_t wrote = ::write(fd, data + done, size - done);
+			if (wrote < 0 && errno == EINTR)
+				continue;
+			if (wrote < 0)
+				return false;
+			done += static_cast<std::size_t>(wrote);
+		}
+		return true;
+	}
+
+	// syncDirectory
+	// Flushes the directory holding path to the disk, so that a file created, renamed or removed
+	// there stays that way after a crash.
+	//
+	// Exceptions: Throws std::runtime_error if the directory cannot be synced
+	// Strong Guarantee, Exception Neutral
+	static void syncDirectory(const std::string & path)
+	{
+		std::string::size_type slash = path.rfind('/');
+		const std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+		int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+		if (fd < 0 || ::fsync(fd) != 0)
+		{
+			int savedErrno = errno;
+			if (fd >= 0)
+				::close(fd);
+			throw std::runtime_error("cannot sync directory " + directory + ": " + std::strerror(savedErrno));
+		}
+		::close(fd);
+	}
+
+	// temporaryPath
+	// Returns the name replace writes path under until it is complete.
+	//
+	// Strong Guarantee
+	static std::string temporaryPath(const std::string & path)
+	{
+		return path + ".tmp";
+	}
+
+	// replace
+	// Creates temporaryPath(path), calls write(fd) with a descriptor open on it for reading and
+	// writing, then syncs the file, renames it over path and syncs the directory. write may also
+	// reopen the temporary by name. If write or any step fails, the descriptor is closed and the
+	// temporary removed, and path is left as it was unless the rename was made.
+	// Error messages start with owner.
+	//
+	// Exceptions: Throws std::runtime_error if the file cannot be written; throws if write throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Write>
+	static void replace(const std::string & path, const std::string & owner, Write write)
+	{
+		const std::string temporary = temporaryPath(path);
+		int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if (fd < 0)
+			throw std::runtime_error(owner + ": cannot create " + temporary + ": " + std::strerror(errno));
+		try {
+			write(fd);
+		}
+		catch (...) {
+			::close(fd);
+			::unlink(temporary.c_str());
+			throw;
+		}
+		const char * failed = ::fsync(fd) != 0 ? "sync" : nullptr;
+		int savedErrno = errno;
+		if (::close(fd) != 0 && !failed)
+		{
+			failed = "close";
+			savedErrno = errno;
+		}
+		if (!failed && std::rename(temporary.c_str(), path.c_str()) != 0)
+		{
+			failed = "rename";
+			savedErrno = errno;
+		}
+		if (failed)
+		{
+			::unlink(temporary.c_str());
+			throw std::runtime_error(owner + ": cannot " + failed + " " + temporary + ": " + std::strerror(savedErrno));
+		}
+		try {
+			syncDirectory(path);
+		}
+		catch (const std::runtime_error & error) {
+			throw std::runtime_error(owner + ": " + error.what());
+		}
+	}
+};
+
+// struct BulkRelease
+// Tells BasicSkipList whether its Allocator can free all of a list's nodes at once, without
+// visiting them. Most allocators cannot, and this default says so. An allocator whose memory
+// goes away with its last copy, such as ArenaAllocator in skiplist_pool.h, specialises it:
+//		exclusive(allocator) is true when destroying allocator frees the memory of every node
+//		forget(allocator) tells an exclusive allocator that the list has dropped its nodes
+//		without destroying or deallocating them, so that destroying it frees their memory at once
+//		renew(allocator) returns the allocator for the list once it is cleared, with memory of its
+//		own if exclusive(allocator)
+template <typename Allocator>
+struct BulkRelease {
+	static bool exclusive(const Allocator &)
+	{
+		return false;
+	}
+
+	static void forget(Allocator &)
+	{}
+
+	static Allocator renew(const Allocator & allocator)
+	{
+		return allocator;
+	}
+};
+
+// class BasicSkipList
 // Uses a SkipList to hold a sorted dataset.
+// Instrumentation is a policy, such as CountingInstrumentation, that watches every key comparison
+// and hop made by search, insert and remove; the default, NoInstrumentation, compiles away.
+// Allocator, such as CountingAllocator<SkipListNode>, provides the memory for every node, which
+// comes from one allocate_shared call holding the node and its shared_ptr control block.
+// SkipList is BasicSkipList<NoInstrumentation, std::allocator<SkipListNode>>.
 // Invariants:
 //		_head is a shared_ptr to a SkipListNode of "negative infinity"
 //		_tail is a shared_ptr to a SkipListNode of "positive infinity"
 //		Nodes are linked
-class SkipList {
+//		_sequence is the sequence number of the most recent insert or remove
+//		Nodes with _endSequence <= _sequence are removed but still linked for an open Snapshot,
+//		and are held in _retiredNodes in order of _endSequence
+template <typename Instrumentation = NoInstrumentation, typename Allocator = std::allocator<SkipListNode>>
+class BasicSkipList {
 // ***** SkipList: Data Members *****
 public:
 	std::shared_ptr<SkipListNode> _head;
 	std::shared_ptr<SkipListNode> _tail;
 
+private:
+	// struct SnapshotRegistry
+	// Sequence numbers of the open Snapshots. Shared with the Snapshots so that they can
+	// unregister from whichever thread destroys them. _open counts them so that writers can
+	// skip the lock while no Snapshot exists.
+	struct SnapshotRegistry {
+		std::mutex _mutex;
+		std::multiset<unsigned long long> _sequences;
+		std::atomic<std::size_t> _open{0};
+	};
+
+	static const unsigned long long SaveFormatVersion = 1;
+	static const unsigned long long SaveHeightsFlag = 1;
+	static const std::size_t SaveChunkBytes = 1 << 16;
+	static const unsigned long long StreamFormatVersion = 1;
+	static const std::size_t StreamChunkKeys = SaveChunkBytes / 4;
+	static const unsigned long long ParallelTeardownNodes = 1 << 20;
+
+	unsigned long long _sequence = 0;
+	std::shared_ptr<SnapshotRegistry> _snapshots = std::make_shared<SnapshotRegistry>();
+	std::deque<std::shared_ptr<SkipListNode>> _retiredNodes;
+	Instrumentation _instrumentation;
+	Allocator _allocator;
+
+// ***** SkipList: Snapshot *****
+public:
+	// class Snapshot
+	// A read view of the list as it was when SkipList::snapshot() was called.
+	// Inserts made after the snapshot are invisible to it, and nodes removed after it stay linked
+	// until every Snapshot that can see them is destroyed, so a scan sees one consistent state
+	// even when the thread running it writes to the list in between, or from inside the visitor.
+	//
+	// Snapshots do not make SkipList thread-safe: reads through a Snapshot must not overlap writes
+	// made by other threads. For scans that run alongside writers on other threads without a lock,
+	// use RcuSkipList in skiplist_rcu.h.
+	// A Snapshot must not be used after its SkipList is destroyed, but may be destroyed afterwards.
+	//
+	// Invariants:
+	//		_registry holds _sequence until the Snapshot is destroyed
+	class Snapshot {
+		friend class BasicSkipList;
+	private:
+		std::shared_ptr<SnapshotRegistry> _registry;
+		std::shared_ptr<SkipListNode> _head;
+		unsigned long long _sequence;
+
+		Snapshot(const std::shared_ptr<SnapshotRegistry> & registry,
+		         const std::shared_ptr<SkipListNode> & head,
+		         unsigned long long sequence)
+			: _registry(registry), _head(head), _sequence(sequence)
+		{}
+
+	public:
+		Snapshot(const Snapshot & other) = delete;
+		Snapshot & operator=(const Snapshot & other) = delete;
+		Snapshot(Snapshot && other) = default;
+
+		// Destructor
+		// Unregisters the snapshot so that nodes only it could see may be collected.
+		//
+		// No-Throw Guarantee
+		~Snapshot()
+		{
+			if (!_registry)
+				return;
+			std::lock_guard<std::mutex> lock(_registry->_mutex);
+			_registry->_sequences.erase(_registry->_sequences.find(_sequence));
+			_registry->_open.store(_registry->_sequences.size(), std::memory_order_release);
+		}
+
+		// sequence
+		// Returns the write sequence number this snapshot reads at.
+		//
+		// No-Throw Guarantee
+		unsigned long long sequence() const
+		{
+			return _sequence;
+		}
+
+		// search
+		// Looks for an item visible to this snapshot and returns a const shared_ptr if it is found, nullptr otherwise
+		//
+		// Preconditions: The SkipList this snapshot was taken from still exists
+		// No-Throw Guarantee
+		const std::shared_ptr<SkipListNode> search(int searchKey) const
+		{
+			NoInstrumentation::Probe probe;
+			return BasicSkipList::findVisible(_head, searchKey, _sequence, probe);
+		}
+
+		// scan
+		// Calls visit(key) for every key in [lowKey, highKey] visible to this snapshot, in sorted order.
+		//
+		// Preconditions: The SkipList this snapshot was taken from still exists
+		// Exceptions: Throws if visit throws
+		// Basic Guarantee, Exception Neutral
+		template <typename Visit>
+		void scan(int lowKey, int highKey, Visit visit) const
+		{
+			BasicSkipList::scanVisible(_head, lowKey, highKey, _sequence, visit);
+		}
+
+		// range
+		// Returns the keys in [lowKey, highKey] visible to this snapshot, in sorted order.
+		//
+		// Preconditions: The SkipList this snapshot was taken from still exists
+		// Exceptions: Throws if std::vector throws
+		// Strong Guarantee, Exception Neutral
+		std::vector<int> range(int lowKey, int highKey) const
+		{
+			std::vector<int> result;
+			scan(lowKey, highKey, [&result](int key) { result.push_back(key); });
+			return result;
+		}
+	};
+
+// ***** SkipList: Builder *****
+public:
+	// class Builder
+	// Fills an empty SkipList from keys that arrive in sorted order, in linear time.
+	// Each key is linked after the last node of every level it reaches, so no searching is done.
+	// Heights are either given by the caller, to reproduce a saved list exactly, or chosen
+	// deterministically so that every (1/proportion)-th node reaches the next level up.
+	//
+	// Invariants:
+	//		_lastNodes[i] is the last node linked on level i
+	//		_count is the number of keys appended
+	class Builder {
+	private:
+		BasicSkipList & _list;
+		std::shared_ptr<SkipListNode> _lastNodes[MaxLevel];
+		unsigned long long _count;
+
+	public:
+		// Parameterized Constructor
+		// Prepares to append to list.
+		//
+		// Preconditions: list is empty and has no open Snapshot
+		// No-Throw Guarantee
+		explicit Builder(BasicSkipList & list)
+			: _list(list), _count(0)
+		{
+			for (int i = 0; i < MaxLevel; i++)
+				_lastNodes[i] = _list._head;
+		}
+
+		// append
+		// Links a new node with the given key and height at the end of the list.
+		//
+		// Preconditions:
+		//		key is not less than the previously appended key
+		//		1 <= height <= MaxLevel
+		// Exceptions:
+		//		Throws std::invalid_argument if a precondition does not hold
+		//		Throws if Allocator throws
+		// Strong Guarantee, Exception Neutral
+		void append(int key, int height)
+		{
+			if (height < 1 || height > MaxLevel)
+				throw std::invalid_argument("SkipList::Builder: height out of range");
+			if (_count > 0 && key < _lastNodes[0]->_key)
+				throw std::invalid_argument("SkipList::Builder: keys must be appended in sorted order");
+
+			auto newNode = _list.makeNode(key);
+			newNode->_beginSequence = ++_list._sequence;
+			for (int i = 0; i < height; i++)
+			{
+				newNode->_forwardNodes[i] = _list._tail;
+				_lastNodes[i]->_forwardNodes[i] = newNode;
+				_lastNodes[i] = newNode;
+			}
+			_count++;
+		}
+
+		// append
+		// Links a new node with the given key at the end of the list. The n-th node appended
+		// (counting from 1) reaches one level higher for each time 1/proportion divides n.
+		//
+		// Preconditions: key is not less than the previously appended key
+		// Exceptions: As append(key, height)
+		// Strong Guarantee, Exception Neutral
+		void append(int key)
+		{
+			const unsigned long long fanout = static_cast<unsigned long long>(1.0 / proportion + 0.5);
+			int height = 1;
+			for (unsigned long long n = _count + 1; n % fanout == 0 && height < MaxLevel; n /= fanout)
+				height++;
+			append(key, height);
+		}
+	};
+
+// ***** SkipList: Exporter *****
+public:
+	// class Exporter
+	// Streams the keys of a list, as of when the Exporter was made, to a file descriptor one chunk
+	// at a time, so a replica can be bootstrapped through a pipe or socket with no temporary file.
+	// The Exporter holds a Snapshot, so the thread that owns the list may go on inserting and removing
+	// between calls to writeChunk; the stream still holds exactly the keys of that one moment.
+	//
+	// Stream layout, little-endian: "SKST", format version (uint32), then chunks of a key count (uint32)
+	// followed by that many keys (int32 each) in sorted order. A chunk with no keys ends the stream.
+	// SkipList::importFrom reads it.
+	//
+	// Invariants:
+	//		_next is the first node not yet considered, or _tail
+	//		_count is the number of keys written
+	class Exporter {
+	private:
+		Snapshot _snapshot;
+		std::shared_ptr<SkipListNode> _next;
+		unsigned long long _count;
+		bool _started;
+
+	public:
+		// Parameterized Constructor
+		// Takes a Snapshot of list to export.
+		//
+		// Preconditions: list outlives the Exporter
+		// Exceptions: Throws if SkipList::snapshot throws
+		// Strong Guarantee, Exception Neutral
+		explicit Exporter(BasicSkipList & list)
+			: _snapshot(list.snapshot()), _next(list._head->_forwardNodes[0]), _count(0), _started(false)
+		{}
+
+		// writeChunk
+		// Writes the stream header if it has not been written, then the next chunk of up to
+		// StreamChunkKeys keys, and the end marker after the last one. Returns true while
+		// there is more to write.
+		//
+		// Preconditions: The SkipList the Exporter was made from still exists
+		// Exceptions: Throws std::runtime_error if fd cannot be written
+		// Basic Guarantee, Exception Neutral
+		bool writeChunk(int fd)
+		{
+			std::vector<char> buffer;
+			buffer.reserve(16 + 4 * StreamChunkKeys);
+			if (!_started)
+			{
+				char header[8] = { 'S', 'K', 'S', 'T' };
+				DurableFile::encodeLittleEndian(header + 4, StreamFormatVersion, 4);
+				buffer.insert(buffer.end(), header, header + sizeof(header));
+			}
+			std::size_t keys = 0;
+			buffer.resize(buffer.size() + 4);
+			for (; _next->_forwardNodes[0] && keys < StreamChunkKeys; _next = _next->_forwardNodes[0])
+			{
+				if (!visibleAt(_next, _snapshot._sequence))
+					continue;
+				char key[4];
+				DurableFile::encodeLittleEndian(key, static_cast<std::uint32_t>(_next->_key), 4);
+				buffer.insert(buffer.end(), key, key + 4);
+				keys++;
+			}
+			DurableFile::encodeLittleEndian(&buffer[buffer.size() - 4 - 4 * keys], keys, 4);
+			bool finished = !_next->_forwardNodes[0];
+			if (finished && keys > 0)
+				buffer.insert(buffer.end(), 4, 0);
+			writeFully(fd, buffer.data(), buffer.size());
+			_started = true;
+			_count += keys;
+			return !finished;
+		}
+
+		// count
+		// Returns the number of keys written so far.
+		//
+		// No-Throw Guarantee
+		unsigned long long count() const
+		{
+			return _count;
+		}
+	};
+
+// ***** SkipList: Analyzer *****
+public:
+	// class Analyzer
+	// Measures the shape and memory use of a list a bounded number of nodes at a time, so a health
+	// check on a large live list never holds up its other work for long. Like Exporter it holds a
+	// Snapshot, so the thread that owns the list may insert and remove between calls to step, and
+	// the report describes the list as it was when the Analyzer was made.
+	//
+	// The search path to each key is measured in the same single pass: _runs[i] counts the nodes on
+	// level i since the last node on level i + 1, which are the hops a search makes on level i to
+	// get past them. As in Pugh's analysis, the path to a key is the search path to the node before
+	// it: the sum of _runs plus one step down for each level in use below the highest.
+	//
+	// Invariants:
+	//		_next is the first node not yet measured, or _tail
+	//		_report holds the counts for the nodes before _next visible to _snapshot
+	//		_pathTotal is the sum of the hops made to find each distinct key before _next
+	class Analyzer {
+	private:
+		Snapshot _snapshot;
+		std::shared_ptr<SkipListNode> _next;
+		unsigned long long _runs[MaxLevel];
+		unsigned long long _pathTotal;
+		unsigned long long _distinctKeys;
+		unsigned long long _linksInUse;
+		bool _haveKey;
+		int _lastKey;
+		SkipListReport _report;
+
+	public:
+		// Parameterized Constructor
+		// Takes a Snapshot of list to analyze.
+		//
+		// Preconditions: list outlives the Analyzer
+		// Exceptions: Throws if BasicSkipList::snapshot throws
+		// Strong Guarantee, Exception Neutral
+		explicit Analyzer(BasicSkipList & list)
+			: _snapshot(list.snapshot()), _next(list._head->_forwardNodes[0]), _runs(), _pathTotal(0),
+			  _distinctKeys(0), _linksInUse(0), _haveKey(false), _lastKey(0)
+		{}
+
+		// step
+		// Measures up to nodes more nodes and returns true while there are more to measure.
+		//
+		// Preconditions: The list the Analyzer was made from still exists
+		// No-Throw Guarantee
+		bool step(std::size_t nodes)
+		{
+			for (std::size_t done = 0; _next->_forwardNodes[0] && done < nodes; _next = _next->_forwardNodes[0], done++)
+			{
+				if (!visibleAt(_next, _snapshot._sequence))
+					continue;
+				int nodeHeight = height(_next);
+				if (!_haveKey || _next->_key != _lastKey)
+				{
+					// A search for the first of equal keys makes the hops counted so far
+					unsigned long long hops = 0;
+					for (int i = 0; i < MaxLevel; i++)
+						hops += _runs[i];
+					_pathTotal += hops;
+					_report.maxSearchPath = std::max(_report.maxSearchPath, hops);
+					_distinctKeys++;
+					_haveKey = true;
+					_lastKey = _next->_key;
+				}
+				for (int i = 0; i < nodeHeight - 1; i++)
+					_runs[i] = 0;
+				_runs[nodeHeight - 1]++;
+				for (int i = 0; i < nodeHeight; i++)
+					_report.levelCounts[i]++;
+				_report.height = std::max(_report.height, nodeHeight);
+				_report.nodes++;
+				_linksInUse += static_cast<unsigned long long>(nodeHeight);
+			}
+			return _next->_forwardNodes[0] != nullptr;
+		}
+
+		// report
+		// Returns the report for the nodes measured so far; once step has returned false, for the whole list.
+		//
+		// No-Throw Guarantee
+		SkipListReport report() const
+		{
+			SkipListReport result = _report;
+			const double nodes = static_cast<double>(result.nodes);
+			double expected = nodes;
+			for (int i = 0; i < MaxLevel; i++, expected *= proportion)
+				result.expectedLevelCounts[i] = expected;
+
+			// Every search also steps down from the highest level in use to level 0
+			if (_distinctKeys > 0)
+			{
+				const int down = result.height - 1;
+				result.meanSearchPath = static_cast<double>(_pathTotal) / static_cast<double>(_distinctKeys) + down;
+				result.maxSearchPath += static_cast<unsigned long long>(down);
+			}
+			if (result.nodes > 1)
+				result.expectedSearchPath = std::log(nodes) / std::log(1.0 / proportion) / proportion + 1.0 / (1.0 - proportion);
+
+			const unsigned long long linkSize = sizeof(std::shared_ptr<SkipListNode>);
+			const unsigned long long allocation = (sizeof(SkipListNode) + 2 * sizeof(void *) + 8 + 15) / 16 * 16;
+			result.keyBytes = result.nodes * sizeof(int);
+			result.linkBytes = _linksInUse * linkSize;
+			result.unusedLinkBytes = result.nodes * MaxLevel * linkSize - result.linkBytes;
+			result.otherNodeBytes = result.nodes * sizeof(SkipListNode) - result.keyBytes - result.linkBytes - result.unusedLinkBytes;
+			result.allocatorOverheadBytes = result.nodes * (allocation - sizeof(SkipListNode));
+			result.totalBytes = result.nodes * allocation;
+			if (result.totalBytes > 0)
+				result.fragmentation = 1.0 - static_cast<double>(result.keyBytes + result.linkBytes) /
+				                             static_cast<double>(result.totalBytes);
+			return result;
+		}
+	};
+
 // ***** SkipList: Constructors and Destructors *****
 public:
 	// Default Constructor
@@ -101,34 +1013,35 @@ public:
 	//
 	// Preconditions: None
 	// Postconditions: SkipList with invariants
-	// Exceptions: Throws if make_shared throws
+	// Exceptions: Throws if Allocator throws
 	//
 	// Strong Guarantee, Exception Neutral
-	SkipList()
+	BasicSkipList()
 	{
-		_tail = std::make_shared<SkipListNode>(std::numeric_limits<int>::max());
-		_head = std::make_shared<SkipListNode>(std::numeric_limits<int>::min());
-		for (int i = MaxLevel-1; i >= 0; i--)
-			_head->_forwardNodes[i] = _tail;
+		link();
+	}
+
+	// Parameterized Constructor
+	// Creates an empty list whose nodes come from allocator, which is moved into the list.
+	//
+	// Preconditions: None
+	// Postconditions: SkipList with invariants
+	// Exceptions: Throws if Allocator throws
+	//
+	// Strong Guarantee, Exception Neutral
+	explicit BasicSkipList(Allocator allocator)
+		: _allocator(std::move(allocator))
+	{
+		link();
 	}
 
 	// Destructor
-	// Moves from _head to _tail setting each element of the _forewardNodes arrays to nullptr.
-	// This decrements the shared_ptr reference counts, eventually deleting the items,
-	// while avoiding the stack overflow errors created with recursive destructor calls.
+	// Frees every node on the calling thread, as releaseNodes does.
 	//
 	// No-Throw Guarantee
-	~SkipList()
+	~BasicSkipList()
 	{
-		std::shared_ptr<SkipListNode> currentNode = _head;
-		std::shared_ptr<SkipListNode> tempNode;
-		while (currentNode->_forwardNodes[0])
-		{
-			tempNode = currentNode->_forwardNodes[0];
-			for (int i = MaxLevel - 1; i >= 0; i--)
-				currentNode->_forwardNodes[i] = nullptr;
-			currentNode = tempNode;
-		}
+		releaseNodes(1);
 	}
 
 // ***** SkipList: Public Member Functions *****
@@ -141,15 +1054,100 @@ public:
 	// Strong Guarantee, Exception Neutral
 	const std::shared_ptr<SkipListNode> search(int searchKey)
 	{
-		std::shared_ptr<SkipListNode> currentNode = _head;
-		for (int i = MaxLevel - 1; i >= 0; i--) {
-			while (currentNode->_forwardNodes[i]->_key < searchKey)
-				currentNode = currentNode->_forwardNodes[i];
+		typename Instrumentation::Probe probe(_instrumentation, SkipListSearch, searchKey);
+		return findVisible(_head, searchKey, _sequence, probe);
+	}
+
+	// stats
+	// Returns what the Instrumentation policy has counted so far. Only lists with a counting
+	// policy, such as BasicSkipList<CountingInstrumentation>, have stats.
+	//
+	// Preconditions: Instrumentation has a stats() member
+	// No-Throw Guarantee
+	SkipListStats stats() const
+	{
+		return _instrumentation.stats();
+	}
+
+	// instrumentation
+	// Returns the Instrumentation policy, for instance to reset its counts.
+	//
+	// No-Throw Guarantee
+	Instrumentation & instrumentation()
+	{
+		return _instrumentation;
+	}
+
+	// allocator
+	// Returns the Allocator the nodes come from, for instance to read a CountingAllocator's stats.
+	//
+	// No-Throw Guarantee
+	const Allocator & allocator() const
+	{
+		return _allocator;
+	}
+
+	// scan
+	// Calls visit(key) for every key in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: visit does not modify the list
+	// Exceptions: Throws if visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit)
+	{
+		scanVisible(_head, lowKey, highKey, _sequence, visit);
+	}
+
+	// range
+	// Returns the keys in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: A SkipList
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<int> range(int lowKey, int highKey)
+	{
+		std::vector<int> result;
+		scan(lowKey, highKey, [&result](int key) { result.push_back(key); });
+		return result;
+	}
+
+	// snapshot
+	// Returns a read view of the list at the current sequence number.
+	// Taking a snapshot copies no nodes; removals made while it is open are deferred instead.
+	//
+	// Preconditions: A SkipList
+	// Exceptions: Throws if std::multiset throws
+	// Strong Guarantee, Exception Neutral
+	Snapshot snapshot()
+	{
+		std::lock_guard<std::mutex> lock(_snapshots->_mutex);
+		_snapshots->_sequences.insert(_sequence);
+		_snapshots->_open.store(_snapshots->_sequences.size(), std::memory_order_release);
+		return Snapshot(_snapshots, _head, _sequence);
+	}
+
+	// collectGarbage
+	// Unlinks removed nodes that no open Snapshot can see any more.
+	// insert and remove call this automatically; call it directly to release memory
+	// promptly after closing a long-lived Snapshot.
+	//
+	// Preconditions: A SkipList
+	// No-Throw Guarantee
+	void collectGarbage()
+	{
+		unsigned long long horizon = NoSequence;
+		if (_snapshots->_open.load(std::memory_order_acquire) > 0)
+		{
+			std::lock_guard<std::mutex> lock(_snapshots->_mutex);
+			if (!_snapshots->_sequences.empty())
+				horizon = *_snapshots->_sequences.begin();
+		}
+		while (!_retiredNodes.empty() && _retiredNodes.front()->_endSequence <= horizon)
+		{
+			unlink(_retiredNodes.front());
+			_retiredNodes.pop_front();
 		}
-		currentNode = currentNode->_forwardNodes[0];
-		if (currentNode->_key == searchKey)
-			return currentNode;
-		return nullptr;
 	}
 
 	// insert
@@ -166,22 +1164,29 @@ public:
 	// Postconditions:
 	//		A new SkipListNode with _key == key inserted immediately after the node with the next-lowest key
 	// Exceptions:
-	//		Throws if make_shared throws
+	//		Throws if Allocator throws
 	// Strong Guarantee, Exception Neutral
 	void insert(int insertKey)
 	{
+		if (!_retiredNodes.empty())
+			collectGarbage();
+
 		// Determine which nodes at each level need to be updated
+		typename Instrumentation::Probe probe(_instrumentation, SkipListInsert, insertKey);
 		std::shared_ptr<SkipListNode> updateNodes[MaxLevel];
 		std::shared_ptr<SkipListNode> currentNode = _head;
 		for (int i = MaxLevel - 1; i >= 0; i--) {
-			while (currentNode->_forwardNodes[i]->_key < insertKey)
+			while (probe.less(currentNode->_forwardNodes[i]->_key, insertKey)) {
 				currentNode = currentNode->_forwardNodes[i];
+				probe.hop(i);
+			}
 			updateNodes[i] = currentNode;
 		}
 
 		// Create a new node and link it
 		int level = randomLevel();
-		auto newNode = std::make_shared<SkipListNode>(insertKey);
+		auto newNode = makeNode(insertKey);
+		newNode->_beginSequence = ++_sequence;
 		for (int i = 0; i < level; i++)
 		{
 			newNode->_forwardNodes[i] = updateNodes[i]->_forwardNodes[i];
@@ -189,38 +1194,707 @@ public:
 		}
 	}
 
+	// insertBatch
+	// Inserts many keys in one sorted pass. The predecessors found for one key are the starting
+	// points for the next, so a batch that lands in one region of the list costs little more
+	// than walking that region once instead of descending from _head for every key.
+	// Every node is allocated before any is linked, so a batch goes in whole or not at all.
+	// The result is the same as calling insert for each key.
+	//
+	// Preconditions:
+	//		A SkipList
+	// Postconditions:
+	//		A new SkipListNode for each element of keys is linked at its sorted position
+	// Exceptions:
+	//		Throws if std::sort, std::vector or Allocator throws
+	// Strong Guarantee, Exception Neutral
+	void insertBatch(std::vector<int> keys)
+	{
+		if (!_retiredNodes.empty())
+			collectGarbage();
+		if (!std::is_sorted(keys.begin(), keys.end()))
+			std::sort(keys.begin(), keys.end());
+		std::vector<std::shared_ptr<SkipListNode>> newNodes;
+		newNodes.reserve(keys.size());
+		for (auto insertKey : keys)
+			newNodes.push_back(makeNode(insertKey));
+
+		std::shared_ptr<SkipListNode> updateNodes[MaxLevel];
+		for (int i = 0; i < MaxLevel; i++)
+			updateNodes[i] = _head;
+		for (auto & newNode : newNodes)
+		{
+			// Resume each level from the previous key's predecessor when it is further along
+			int insertKey = newNode->_key;
+			typename Instrumentation::Probe probe(_instrumentation, SkipListInsert, insertKey);
+			std::shared_ptr<SkipListNode> currentNode = _head;
+			for (int i = MaxLevel - 1; i >= 0; i--) {
+				if (updateNodes[i]->_key > currentNode->_key)
+					currentNode = updateNodes[i];
+				while (probe.less(currentNode->_forwardNodes[i]->_key, insertKey)) {
+					currentNode = currentNode->_forwardNodes[i];
+					probe.hop(i);
+				}
+				updateNodes[i] = currentNode;
+			}
+
+			int level = randomLevel();
+			newNode->_beginSequence = ++_sequence;
+			for (int i = 0; i < level; i++)
+			{
+				newNode->_forwardNodes[i] = updateNodes[i]->_forwardNodes[i];
+				updateNodes[i]->_forwardNodes[i] = newNode;
+			}
+		}
+	}
+
 	// remove
 	// Removes a node from the list by updating the pointers that referenced it
 	// to point at the nodes that it used to point to. This decrements the shared_ptr's
 	// reference count until the node is removed.
+	// While a Snapshot is open, or removed nodes are still waiting to be unlinked, the node is only
+	// marked with its _endSequence and unlinked later by collectGarbage, once no Snapshot can see it.
 	//
 	// Preconditions: A SkipList
 	// Postconditions: If a node with _key == key existed, that node is removed.
 	// Strong Guarantee, Exception-Neutral
 	void remove(int removeKey)
 	{
-		
+		if (!_retiredNodes.empty())
+			collectGarbage();
+
+		// A Snapshot can only be opened by this thread, so a count of zero cannot go stale here. Nodes
+		// collectGarbage left behind are still linked, so unlinking in place could pick one of them;
+		// they also mean a Snapshot was open when it looked, whatever the count reads now.
+		typename Instrumentation::Probe probe(_instrumentation, SkipListRemove, removeKey);
+		if (!_retiredNodes.empty() || _snapshots->_open.load(std::memory_order_acquire) > 0)
+		{
+			auto node = findVisible(_head, removeKey, _sequence, probe);
+			if (node)
+			{
+				_retiredNodes.push_back(node);
+				node->_endSequence = ++_sequence;
+			}
+			return;
+		}
+
 		// Determine which nodes at each level need to be updated
 		std::shared_ptr<SkipListNode> updateNodes[MaxLevel];
 		std::shared_ptr<SkipListNode> currentNode = _head;
 		for (int i = MaxLevel - 1; i >= 0; i--) {
-			while (currentNode->_forwardNodes[i]->_key < removeKey)
+			while (probe.less(currentNode->_forwardNodes[i]->_key, removeKey)) {
 				currentNode = currentNode->_forwardNodes[i];
+				probe.hop(i);
+			}
 			updateNodes[i] = currentNode;
 		}
 		currentNode = currentNode->_forwardNodes[0];
 
-		if (currentNode->_key == removeKey)
+		if (probe.equal(currentNode->_key, removeKey))
 		{
+			++_sequence;
 			for (int i = 0; i < MaxLevel; i++)
 			{
 				if (updateNodes[i]->_forwardNodes[i] != currentNode)
 					break;
 				updateNodes[i]->_forwardNodes[i] = currentNode->_forwardNodes[i];
 			}
-				
+
+		}
+	}
+
+	// clear
+	// Removes every key. The old nodes are freed as by releaseNodes: all at once when the
+	// Allocator allows it and no node is held outside the list, otherwise by threads unlinking
+	// runs of the list side by side. threads is the number of threads to use, 1 by default, or 0
+	// to use one per core for lists of more than about ParallelTeardownNodes nodes and one otherwise.
+	//
+	// Preconditions: None
+	// Postconditions: The list is empty
+	// Exceptions:
+	//		Throws std::runtime_error if a Snapshot of the list is open
+	//		Throws if Allocator throws
+	// Strong Guarantee, Exception Neutral
+	void clear(unsigned threads = 1)
+	{
+		if (_snapshots->_open.load(std::memory_order_acquire) > 0)
+			throw std::runtime_error("SkipList::clear: cannot clear a list with an open Snapshot");
+		BasicSkipList emptied(BulkRelease<Allocator>::renew(_allocator));
+		replaceWith(emptied);
+		std::swap(_allocator, emptied._allocator);
+		emptied.releaseNodes(threads);
+	}
+
+	// save
+	// Writes the list to a file in a compact binary format:
+	//		header:  "SKPL", format version (uint32), flags (uint32), key count (uint64)
+	//		keys:    every key in sorted order (int32 each)
+	//		heights: the height of each key's node (uint8 each), present if flags bit 0 is set
+	// All integers are little-endian. Writing the heights lets load rebuild the same towers.
+	// The file is published with DurableFile::replace, so a crash or a full disk during save
+	// leaves the previous file at path as it was.
+	//
+	// Preconditions: A SkipList
+	// Postconditions: path holds the keys visible to the list
+	// Exceptions: Throws std::runtime_error if the file cannot be written
+	// Strong Guarantee, Exception Neutral
+	void save(const std::string & path, bool saveHeights = true)
+	{
+		unsigned long long count = 0;
+		for (auto node = _head->_forwardNodes[0]; node != _tail; node = node->_forwardNodes[0])
+			if (visibleAt(node, _sequence))
+				count++;
+
+		DurableFile::replace(path, "SkipList::save", [&](int fd) {
+			char header[20] = { 'S', 'K', 'P', 'L' };
+			DurableFile::encodeLittleEndian(header + 4, SaveFormatVersion, 4);
+			DurableFile::encodeLittleEndian(header + 8, saveHeights ? SaveHeightsFlag : 0, 4);
+			DurableFile::encodeLittleEndian(header + 12, count, 8);
+			std::vector<char> buffer(header, header + sizeof(header));
+			buffer.reserve(SaveChunkBytes);
+
+			for (auto node = _head->_forwardNodes[0]; node != _tail; node = node->_forwardNodes[0])
+			{
+				if (!visibleAt(node, _sequence))
+					continue;
+				DurableFile::appendLittleEndian(buffer, static_cast<std::uint32_t>(node->_key), 4);
+				if (buffer.size() >= SaveChunkBytes)
+					writeSavedChunk(fd, buffer, "SkipList::save", path);
+			}
+			if (saveHeights)
+			{
+				for (auto node = _head->_forwardNodes[0]; node != _tail; node = node->_forwardNodes[0])
+				{
+					if (!visibleAt(node, _sequence))
+						continue;
+					buffer.push_back(static_cast<char>(height(node)));
+					if (buffer.size() >= SaveChunkBytes)
+						writeSavedChunk(fd, buffer, "SkipList::save", path);
+				}
+			}
+			writeSavedChunk(fd, buffer, "SkipList::save", path);
+		});
+	}
+
+	// load
+	// Replaces the contents of the list with a file written by save.
+	// The towers are rebuilt in one linear pass with Builder: from the saved heights if present,
+	// otherwise with deterministic heights. No random levels are rolled.
+	//
+	// Preconditions: None
+	// Postconditions: The list holds exactly the keys in path
+	// Exceptions:
+	//		Throws std::runtime_error if a Snapshot of the list is open, since it still reads the old nodes
+	//		Throws std::runtime_error if the file cannot be read or is not a valid saved SkipList
+	// Strong Guarantee, Exception Neutral
+	void load(const std::string & path)
+	{
+		if (_snapshots->_open.load(std::memory_order_acquire) > 0)
+			throw std::runtime_error("SkipList::load: cannot replace a list with an open Snapshot");
+		std::ifstream keys(path, std::ios::binary);
+		if (!keys)
+			throw std::runtime_error("SkipList::load: cannot open " + path);
+		char header[20];
+		if (!keys.read(header, sizeof(header)) || std::string(header, 4) != "SKPL" ||
+		    DurableFile::decodeLittleEndian(header + 4, 4) != SaveFormatVersion)
+			throw std::runtime_error("SkipList::load: " + path + " is not a saved SkipList");
+		bool hasHeights = (DurableFile::decodeLittleEndian(header + 8, 4) & SaveHeightsFlag) != 0;
+		unsigned long long count = DurableFile::decodeLittleEndian(header + 12, 8);
+
+		// Keys and heights are read side by side through two streams
+		std::ifstream heights;
+		if (hasHeights)
+		{
+			heights.open(path, std::ios::binary);
+			heights.seekg(static_cast<std::streamoff>(sizeof(header) + 4 * count));
+			if (!heights)
+				throw std::runtime_error("SkipList::load: cannot open " + path);
+		}
+
+		BasicSkipList loaded(_allocator);
+		Builder builder(loaded);
+		std::vector<char> keyBuffer(SaveChunkBytes);
+		std::vector<char> heightBuffer(SaveChunkBytes / 4);
+		for (unsigned long long done = 0; done < count; )
+		{
+			std::size_t chunk = static_cast<std::size_t>(std::min<unsigned long long>(count - done, SaveChunkBytes / 4));
+			if (!keys.read(keyBuffer.data(), 4 * chunk) || (hasHeights && !heights.read(heightBuffer.data(), chunk)))
+				throw std::runtime_error("SkipList::load: " + path + " is truncated");
+			for (std::size_t i = 0; i < chunk; i++)
+			{
+				int key = static_cast<int>(static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(&keyBuffer[4 * i], 4)));
+				try {
+					if (hasHeights)
+						builder.append(key, static_cast<unsigned char>(heightBuffer[i]));
+					else
+						builder.append(key);
+				}
+				catch (std::invalid_argument & e) {
+					throw std::runtime_error("SkipList::load: " + path + " is corrupt: " + e.what());
+				}
+			}
+			done += chunk;
+		}
+
+		replaceWith(loaded);
+	}
+
+	// readSaved
+	// Calls visit(key) for every key of a file written by save or writeSaved, in sorted order,
+	// without building a list, and returns the number of keys. Heights are skipped.
+	//
+	// Preconditions: None
+	// Exceptions:
+	//		Throws std::runtime_error if the file cannot be read or is not a valid saved SkipList
+	//		Throws if visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	static unsigned long long readSaved(const std::string & path, Visit visit)
+	{
+		std::ifstream keys(path, std::ios::binary);
+		if (!keys)
+			throw std::runtime_error("SkipList::readSaved: cannot open " + path);
+		char header[20];
+		if (!keys.read(header, sizeof(header)) || std::string(header, 4) != "SKPL" ||
+		    DurableFile::decodeLittleEndian(header + 4, 4) != SaveFormatVersion)
+			throw std::runtime_error("SkipList::readSaved: " + path + " is not a saved SkipList");
+		unsigned long long count = DurableFile::decodeLittleEndian(header + 12, 8);
+
+		std::vector<char> keyBuffer(SaveChunkBytes);
+		for (unsigned long long done = 0; done < count; )
+		{
+			std::size_t chunk = static_cast<std::size_t>(std::min<unsigned long long>(count - done, SaveChunkBytes / 4));
+			if (!keys.read(keyBuffer.data(), 4 * chunk))
+				throw std::runtime_error("SkipList::readSaved: " + path + " is truncated");
+			for (std::size_t i = 0; i < chunk; i++)
+				visit(static_cast<int>(static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(&keyBuffer[4 * i], 4))));
+			done += chunk;
+		}
+		return count;
+	}
+
+	// writeSaved
+	// Writes a file that load reads as a list of the keys source passes to emit(key), without heights,
+	// and returns the number of keys. Lets a saved list be rewritten, for instance merged with
+	// changes, in one streaming pass without building it in memory. As with save, the file is
+	// published with DurableFile::replace, so path may be the file source reads from.
+	//
+	// Preconditions: source emits keys in sorted order
+	// Exceptions: Throws std::runtime_error if the file cannot be written; throws if source throws
+	// Strong Guarantee, Exception Neutral
+	template <typename Source>
+	static unsigned long long writeSaved(const std::string & path, Source source)
+	{
+		unsigned long long count = 0;
+		DurableFile::replace(path, "SkipList::writeSaved", [&](int fd) {
+			char header[20] = { 'S', 'K', 'P', 'L' };
+			DurableFile::encodeLittleEndian(header + 4, SaveFormatVersion, 4);
+			std::vector<char> buffer(header, header + sizeof(header));
+			buffer.reserve(SaveChunkBytes);
+			source([&](int key) {
+				DurableFile::appendLittleEndian(buffer, static_cast<std::uint32_t>(key), 4);
+				count++;
+				if (buffer.size() >= SaveChunkBytes)
+					writeSavedChunk(fd, buffer, "SkipList::writeSaved", path);
+			});
+			writeSavedChunk(fd, buffer, "SkipList::writeSaved", path);
+
+			// The count is not known until the end, so it is written into the header last
+			DurableFile::encodeLittleEndian(header + 12, count, 8);
+			if (::pwrite(fd, header + 12, 8, 12) != 8)
+				throw std::runtime_error("SkipList::writeSaved: cannot write " + path + ": " + std::strerror(errno));
+		});
+		return count;
+	}
+
+	// analyze
+	// Returns the shape and memory use of the list: nodes per level against the expected counts,
+	// the mean, longest and expected search paths, and where the bytes go. Takes time in
+	// proportion to the list; to spread that out on a live list, drive an Analyzer instead.
+	//
+	// Preconditions: A SkipList
+	// Exceptions: Throws if BasicSkipList::snapshot throws
+	// Strong Guarantee, Exception Neutral
+	SkipListReport analyze()
+	{
+		Analyzer analyzer(*this);
+		while (analyzer.step(std::numeric_limits<std::size_t>::max()))
+			;
+		return analyzer.report();
+	}
+
+	// exportTo
+	// Writes the list to fd as a stream that importFrom reads, and returns the number of keys.
+	// Chunks are written as they are filled, so memory use does not grow with the list. To go on
+	// writing to the list during a long export, drive an Exporter chunk by chunk instead.
+	//
+	// Preconditions: A SkipList
+	// Exceptions: Throws std::runtime_error if fd cannot be written
+	// Basic Guarantee, Exception Neutral
+	unsigned long long exportTo(int fd)
+	{
+		Exporter exporter(*this);
+		while (exporter.writeChunk(fd))
+			;
+		return exporter.count();
+	}
+
+	// importFrom
+	// Replaces the contents of the list with a stream written by exportTo or an Exporter, read from fd
+	// until its end marker, and returns the number of keys. Keys are linked by Builder as they arrive,
+	// so loading keeps pace with the stream.
+	//
+	// Preconditions: None
+	// Postconditions: The list holds exactly the keys in the stream
+	// Exceptions:
+	//		Throws std::runtime_error if a Snapshot of the list is open, since it still reads the old nodes
+	//		Throws std::runtime_error if fd cannot be read or does not hold a valid stream
+	// Strong Guarantee, Exception Neutral
+	unsigned long long importFrom(int fd)
+	{
+		if (_snapshots->_open.load(std::memory_order_acquire) > 0)
+			throw std::runtime_error("SkipList::importFrom: cannot replace a list with an open Snapshot");
+		char header[8];
+		readFully(fd, header, sizeof(header));
+		if (std::string(header, 4) != "SKST" || DurableFile::decodeLittleEndian(header + 4, 4) != StreamFormatVersion)
+			throw std::runtime_error("SkipList::importFrom: not a SkipList stream");
+
+		BasicSkipList loaded(_allocator);
+		Builder builder(loaded);
+		std::vector<char> keyBuffer(4 * StreamChunkKeys);
+		unsigned long long count = 0;
+		for (;;)
+		{
+			char chunkHeader[4];
+			readFully(fd, chunkHeader, sizeof(chunkHeader));
+			std::size_t keys = static_cast<std::size_t>(DurableFile::decodeLittleEndian(chunkHeader, 4));
+			if (keys == 0)
+				break;
+			if (keys > StreamChunkKeys)
+				throw std::runtime_error("SkipList::importFrom: stream is corrupt: chunk too large");
+			readFully(fd, keyBuffer.data(), 4 * keys);
+			for (std::size_t i = 0; i < keys; i++)
+			{
+				try {
+					builder.append(static_cast<int>(static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(&keyBuffer[4 * i], 4))));
+				}
+				catch (std::invalid_argument & e) {
+					throw std::runtime_error(std::string("SkipList::importFrom: stream is corrupt: ") + e.what());
+				}
+			}
+			count += keys;
+		}
+		replaceWith(loaded);
+		return count;
+	}
+
+// ***** SkipList: Private Member Functions *****
+private:
+	// link
+	// Creates the _head and _tail nodes and links _head to _tail on every level.
+	//
+	// Exceptions: Throws if Allocator throws
+	// Strong Guarantee, Exception Neutral
+	void link()
+	{
+		_tail = makeNode(std::numeric_limits<int>::max());
+		_head = makeNode(std::numeric_limits<int>::min());
+		for (int i = MaxLevel-1; i >= 0; i--)
+			_head->_forwardNodes[i] = _tail;
+	}
+
+	// makeNode
+	// Returns an unlinked node holding key, allocated together with its control block by _allocator.
+	//
+	// Exceptions: Throws if Allocator throws
+	// Strong Guarantee, Exception Neutral
+	std::shared_ptr<SkipListNode> makeNode(int key)
+	{
+		return std::allocate_shared<SkipListNode>(_allocator, key);
+	}
+
+	// releaseNodes
+	// Frees every node and leaves the list without even _head and _tail; only destruction may follow.
+	// When BulkRelease says the Allocator's memory goes with it and nodesShared finds no node held
+	// outside the list, the nodes are forgotten rather than destroyed: the shared_ptrs that own
+	// them are overwritten without touching a reference count, and the memory is freed with
+	// _allocator. Otherwise each node's links are cleared from _head on, so that each node is
+	// freed when its last link goes, or later by whatever still holds it, without recursing down
+	// the list. With more than one thread, level 0 is cut into runs at nodes of a high level and
+	// each run is cleared by a thread of its own: a thread only writes the links of its own nodes
+	// and the reference counts are atomic, so the threads need no lock.
+	//
+	// Preconditions: No other thread is using the list
+	// No-Throw Guarantee
+	void releaseNodes(unsigned threads) noexcept
+	{
+		if (!_head)
+			return;
+		if (BulkRelease<Allocator>::exclusive(_allocator) && !nodesShared())
+		{
+			new (&_head) std::shared_ptr<SkipListNode>();
+			new (&_tail) std::shared_ptr<SkipListNode>();
+			BulkRelease<Allocator>::forget(_allocator);
+			return;
+		}
+
+		std::vector<std::shared_ptr<SkipListNode>> runs;
+		try {
+			runs = teardownRuns(threads);
+		}
+		catch (...) {
+			runs.clear();
+		}
+		std::vector<std::thread> workers;
+		for (std::size_t i = 1; i < runs.size(); i++)
+		{
+			const SkipListNode * end = i + 1 < runs.size() ? runs[i + 1].get() : nullptr;
+			try {
+				workers.emplace_back(&BasicSkipList::unlinkRun, runs[i], end);
+			}
+			catch (...) {
+				unlinkRun(runs[i], end);
+			}
+		}
+		unlinkRun(_head, runs.size() > 1 ? runs[1].get() : nullptr);
+		for (auto & worker : workers)
+			worker.join();
+		_retiredNodes.clear();
+		_head = nullptr;
+		_tail = nullptr;
+	}
+
+	// nodesShared
+	// Returns true if a node may be held by anything but the links of the list: a Snapshot, a
+	// shared_ptr returned by search, or _retiredNodes. A node that is not is owned once for each
+	// level it is linked on, so one pass over level 0 reading each reference count tells, far more
+	// cheaply than freeing the nodes one by one.
+	//
+	// Preconditions: No other thread is using the list
+	// No-Throw Guarantee
+	bool nodesShared() const noexcept
+	{
+		if (_snapshots->_open.load(std::memory_order_acquire) > 0 || _head.use_count() > 1 || !_retiredNodes.empty())
+			return true;
+		for (const SkipListNode * node = _head.get(); node->_forwardNodes[0] != _tail; node = node->_forwardNodes[0].get())
+		{
+			const std::shared_ptr<SkipListNode> & next = node->_forwardNodes[0];
+			if (next.use_count() != height(next))
+				return true;
+		}
+		return false;
+	}
+
+	// teardownRuns
+	// Returns the first node of each run releaseNodes should clear on a thread of its own, starting
+	// with _head, or nothing if one thread will do. The runs start at evenly spaced nodes of the
+	// highest level holding at least one node for each extra thread.
+	//
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<std::shared_ptr<SkipListNode>> teardownRuns(unsigned threads) const
+	{
+		const bool automatic = threads == 0;
+		if (automatic)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::shared_ptr<SkipListNode>> runs;
+		if (threads < 2)
+			return runs;
+
+		std::vector<std::shared_ptr<SkipListNode>> levelNodes;
+		int level = MaxLevel - 1;
+		for (; level > 0; level--)
+		{
+			levelNodes.clear();
+			for (auto node = _head->_forwardNodes[level]; node != _tail; node = node->_forwardNodes[level])
+				levelNodes.push_back(node);
+			if (levelNodes.size() >= threads - 1)
+				break;
+		}
+		if (level == 0 || levelNodes.empty())
+			return runs;
+		if (automatic && static_cast<double>(levelNodes.size()) * std::pow(1.0 / proportion, level) < ParallelTeardownNodes)
+			return runs;
+
+		const std::size_t count = std::min<std::size_t>(threads - 1, levelNodes.size());
+		runs.push_back(_head);
+		for (std::size_t i = 0; i < count; i++)
+			runs.push_back(levelNodes[i * levelNodes.size() / count]);
+		return runs;
+	}
+
+	// unlinkRun
+	// Clears the links of each node from first up to, but not including, end (nullptr for the
+	// end of the list), holding each node while its links are cleared.
+	//
+	// No-Throw Guarantee
+	static void unlinkRun(std::shared_ptr<SkipListNode> first, const SkipListNode * end) noexcept
+	{
+		std::shared_ptr<SkipListNode> currentNode = std::move(first);
+		while (currentNode && currentNode.get() != end)
+		{
+			std::shared_ptr<SkipListNode> nextNode = currentNode->_forwardNodes[0];
+			for (int i = MaxLevel - 1; i >= 0; i--)
+				currentNode->_forwardNodes[i] = nullptr;
+			currentNode = std::move(nextNode);
+		}
+	}
+
+	// replaceWith
+	// Takes the nodes of loaded, leaving it with the old ones, and moves _sequence past both lists'.
+	//
+	// Preconditions: No Snapshot of this list is open
+	// No-Throw Guarantee
+	void replaceWith(BasicSkipList & loaded)
+	{
+		std::swap(_head, loaded._head);
+		std::swap(_tail, loaded._tail);
+		std::swap(_retiredNodes, loaded._retiredNodes);
+		_sequence = std::max(_sequence, loaded._sequence) + 1;
+	}
+
+	// writeFully, readFully
+	// Write or read exactly size bytes on fd, resuming after partial transfers and interrupted calls.
+	// readFully treats end of file as a truncated stream. Writing to a pipe or socket whose reader
+	// has gone raises SIGPIPE unless the process ignores it.
+	//
+	// Exceptions: Throw std::runtime_error if fd reports an error or readFully reaches end of file
+	// Basic Guarantee, Exception Neutral
+	static void writeFully(int fd, const char * data, std::size_t size)
+	{
+		if (!DurableFile::writeAll(fd, data, size))
+			throw std::runtime_error(std::string("SkipList: error writing stream: ") + std::strerror(errno));
+	}
+
+	static void readFully(int fd, char * data, std::size_t size)
+	{
+		while (size > 0)
+		{
+			ssize_t got = ::read(fd, data, size);
+			if (got < 0 && errno == EINTR)
+				continue;
+			if (got < 0)
+				throw std::runtime_error(std::string("SkipList: error reading stream: ") + std::strerror(errno));
+			if (got == 0)
+				throw std::runtime_error("SkipList: stream is truncated");
+			data += got;
+			size -= static_cast<std::size_t>(got);
+		}
+	}
+
+	// writeSavedChunk
+	// Writes buffer to fd for save or writeSaved, then empties it.
+	//
+	// Exceptions: Throws std::runtime_error, naming owner and path, if the write fails
+	// Strong Guarantee
+	static void writeSavedChunk(int fd, std::vector<char> & buffer, const char * owner, const std::string & path)
+	{
+		if (!DurableFile::writeAll(fd, buffer.data(), buffer.size()))
+			throw std::runtime_error(std::string(owner) + ": cannot write " + path + ": " + std::strerror(errno));
+		buffer.clear();
+	}
+
+	// height
+	// Returns the number of levels node is linked on.
+	//
+	// Preconditions: node is linked into a SkipList and is not _tail
+	// No-Throw Guarantee
+	static int height(const std::shared_ptr<SkipListNode> & node)
+	{
+		int result = 0;
+		while (result < MaxLevel && node->_forwardNodes[result])
+			result++;
+		return result;
+	}
+
+	// visibleAt
+	// Returns true if node was inserted at or before sequence and not removed by then.
+	//
+	// No-Throw Guarantee
+	static bool visibleAt(const std::shared_ptr<SkipListNode> & node, unsigned long long sequence)
+	{
+		return node->_beginSequence <= sequence && sequence < node->_endSequence;
+	}
+
+	// findVisible
+	// Returns the first node with _key == searchKey visible at sequence, nullptr if there is none.
+	// Removed duplicates that are still linked are skipped.
+	//
+	// The comparisons and hops made are reported to probe.
+	//
+	// Preconditions: head is the _head of a SkipList
+	// No-Throw Guarantee
+	template <typename Probe>
+	static std::shared_ptr<SkipListNode> findVisible(const std::shared_ptr<SkipListNode> & head,
+	                                                 int searchKey, unsigned long long sequence, Probe & probe)
+	{
+		std::shared_ptr<SkipListNode> currentNode = head;
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			while (probe.less(currentNode->_forwardNodes[i]->_key, searchKey)) {
+				currentNode = currentNode->_forwardNodes[i];
+				probe.hop(i);
+			}
+		}
+		currentNode = currentNode->_forwardNodes[0];
+		while (currentNode->_forwardNodes[0] && probe.equal(currentNode->_key, searchKey))
+		{
+			if (visibleAt(currentNode, sequence))
+				return currentNode;
+			currentNode = currentNode->_forwardNodes[0];
+		}
+		return nullptr;
+	}
+
+	// scanVisible
+	// Calls visit(key) for every node in [lowKey, highKey] visible at sequence, in sorted order.
+	// The current node is held by shared_ptr, so a visitor that writes to the list, and so lets
+	// collectGarbage unlink the node the scan stands on, cannot free it underneath the scan.
+	//
+	// Preconditions: head is the _head of a SkipList
+	// Exceptions: Throws if visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	static void scanVisible(const std::shared_ptr<SkipListNode> & head, int lowKey, int highKey,
+	                        unsigned long long sequence, Visit & visit)
+	{
+		SkipListNode * searchNode = head.get();
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			while (searchNode->_forwardNodes[i]->_key < lowKey)
+				searchNode = searchNode->_forwardNodes[i].get();
+		}
+		std::shared_ptr<SkipListNode> currentNode = searchNode->_forwardNodes[0];
+		while (currentNode->_forwardNodes[0] && currentNode->_key <= highKey)
+		{
+			if (currentNode->_beginSequence <= sequence && sequence < currentNode->_endSequence)
+				visit(currentNode->_key);
+			currentNode = currentNode->_forwardNodes[0];
+		}
+	}
+
+	// unlink
+	// Unlinks one particular node, which may be preceded by other nodes with the same key.
+	//
+	// Preconditions: node is linked into this list
+	// No-Throw Guarantee
+	void unlink(const std::shared_ptr<SkipListNode> & node)
+	{
+		int nodeHeight = height(node);
+		std::shared_ptr<SkipListNode> currentNode = _head;
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			while (currentNode->_forwardNodes[i]->_key < node->_key)
+				currentNode = currentNode->_forwardNodes[i];
+			if (i < nodeHeight) {
+				// Equal keys linked ahead of node on this level also precede it on every lower level
+				while (currentNode->_forwardNodes[i] != node)
+					currentNode = currentNode->_forwardNodes[i];
+				currentNode->_forwardNodes[i] = node->_forwardNodes[i];
+			}
 		}
 	}
 };
 
-#endif // #ifndef FILE_SKIPLIST_H_INCLUDED
\ No newline at end of file
+// SkipList
+// The uninstrumented list.
+typedef BasicSkipList<> SkipList;
+
+#endif // #ifndef FILE_SKIPLIST_H_INCLUDED
@@ -0,0 +1,1254 @@
+// skiplist_bench.cpp
+// 18 Oct 2026
+//
+// Benchmarks for class SkipList
+// Measures insert, search-hit, search-miss, range-scan, churn, remove and teardown throughput, latency
+// percentiles, heap bytes per key, and allocations and data TLB misses per operation over several
+// sizes and key distributions,
+// for SkipList, for SkipLists with pooled, arena-backed and huge-page nodes,
+// and for std::set, std::unordered_set (point operations only) and a B+tree as baselines,
+// and prints one CSV row per measurement. Runs to completion without prompting, so it can be scripted.
+// Requires skiplist.h, skiplist_rcu.h, skiplist_buffered.h, skiplist_pool.h
+//
+// Build: g++ -std=c++17 -O2 -pthread skiplist_bench.cpp -o skiplist_bench
+// Usage: skiplist_bench [--sizes 1000,1000000] [--distributions uniform,sequential,zipfian]
+//                       [--structures skiplist,pooled,arena,hugepages,set,unordered_set,btree]
+//                       [--ops N] [--scan-keys N] [--seed N]
+//        skiplist_bench --ycsb A,B,C,D,E,F [--structures skiplist,rcu,buffered] [--threads 1,2,4]
+//                       [--records N] [--ops N] [--histogram-file PATH] [--seed N]
+// The second form runs the YCSB core workloads at each thread count against the structures that
+// threads can share, for throughput-against-threads curves and latency histograms.
+// Sizes up to 1e8 are accepted; a SkipList takes roughly 300 bytes a key, so 1e8 needs about 30 GB.
+// Comparing the dtlb_misses_per_op of arena and hugepages shows what huge pages save; the column is
+// empty where the kernel gives no TLB counter.
+
+#include "skiplist.h"	// for class SkipList
+#include "skiplist_rcu.h"	// for class RcuSkipList
+#include "skiplist_buffered.h"	// for class BufferedSkipList
+#include "skiplist_pool.h"	// for classes PooledSkipList, ArenaSkipList
+#include <iostream>		// for std::cout, std::cerr
+#include <string>		// for std::string, std::stoull
+#include <set>			// for std::set
+#include <unordered_set>	// for std::unordered_set
+#include <memory>		// for std::unique_ptr
+#include <atomic>		// for std::atomic
+#include <thread>		// for std::thread, std::this_thread::yield
+#include <mutex>		// for std::mutex, std::lock_guard
+#include <fstream>		// for std::ofstream
+#include <limits>		// for std::numeric_limits
+#include <new>			// for std::bad_alloc
+#include <cstdlib>		// for std::malloc, std::free
+#include <malloc.h>		// for malloc_usable_size
+#include <vector>		// for std::vector
+#include <algorithm>	// for std::shuffle, std::nth_element, std::max_element, std::lower_bound, std::copy
+#include <random>		// for std::mt19937_64, std::uniform_int_distribution, std::uniform_real_distribution
+#include <chrono>		// for std::chrono::steady_clock, std::chrono::nanoseconds
+#include <cmath>		// for std::pow
+#include <cstdint>		// for std::uint64_t
+#include <stdexcept>	// for std::invalid_argument
+#include <cstddef>		// for std::size_t
+#include <cstring>		// for std::memset
+#include <linux/perf_event.h>	// for perf_event_attr, PERF_TYPE_HW_CACHE
+#include <sys/syscall.h>	// for SYS_perf_event_open
+#include <unistd.h>		// for syscall, read, close
+
+// *********************************************************************
+// Key Distributions
+// *********************************************************************
+
+// class ZipfianGenerator
+// Draws ranks in [0, n) with P(rank = i) proportional to 1 / (i + 1)^theta, by the method of Gray et al.,
+// "Quickly Generating Billion-Record Synthetic Databases", as used by YCSB. Setting up costs O(n);
+// each draw costs O(1).
+//
+// Invariants:
+//		_zetaN is the sum of 1 / i^theta for i in [1, n]
+class ZipfianGenerator {
+private:
+	std::uint64_t _n;
+	double _theta;
+	double _alpha;
+	double _zetaN;
+	double _eta;
+	std::uniform_real_distribution<double> _uniform;
+
+public:
+	// Parameterized Constructor
+	// Prepares to draw ranks in [0, n) with skew theta; YCSB uses theta = 0.99.
+	//
+	// Preconditions: n >= 2; 0 < theta < 1
+	// No-Throw Guarantee
+	ZipfianGenerator(std::uint64_t n, double theta)
+		: _n(n), _theta(theta), _alpha(1.0 / (1.0 - theta)), _zetaN(zeta(n, theta)), _uniform(0.0, 1.0)
+	{
+		_eta = (1.0 - std::pow(2.0 / static_cast<double>(n), 1.0 - theta)) / (1.0 - zeta(2, theta) / _zetaN);
+	}
+
+	// operator()
+	// Returns the next rank; rank 0 is the most frequent.
+	//
+	// No-Throw Guarantee
+	template <typename Generator>
+	std::uint64_t operator()(Generator & generator)
+	{
+		double u = _uniform(generator);
+		double uz = u * _zetaN;
+		if (uz < 1.0)
+			return 0;
+		if (uz < 1.0 + std::pow(0.5, _theta))
+			return 1;
+		auto rank = static_cast<std::uint64_t>(static_cast<double>(_n) * std::pow(_eta * u - _eta + 1.0, _alpha));
+		return rank < _n ? rank : _n - 1;
+	}
+
+private:
+	static double zeta(std::uint64_t n, double theta)
+	{
+		double sum = 0.0;
+		for (std::uint64_t i = 1; i <= n; i++)
+			sum += 1.0 / std::pow(static_cast<double>(i), theta);
+		return sum;
+	}
+};
+
+// class KeyChooser
+// Picks which of the n keys in a list each lookup touches, by distribution:
+//		sequential: every key in ascending order, wrapping around
+//		uniform:    every key equally likely
+//		zipfian:    a few keys very often, by ZipfianGenerator with theta 0.99; ranks are mapped through
+//		            the shuffled insertion order, so the popular keys are spread over the key space
+//
+// Invariants:
+//		_order holds a permutation of [0, n) when _distribution is zipfian
+class KeyChooser {
+private:
+	std::string _distribution;
+	std::uint64_t _n;
+	std::uint64_t _next;
+	const std::vector<std::uint64_t> & _order;
+	std::uniform_int_distribution<std::uint64_t> _uniform;
+	ZipfianGenerator _zipfian;
+
+public:
+	// Parameterized Constructor
+	// Prepares to choose among n keys, where order is the shuffled order they were inserted in.
+	//
+	// Preconditions: n >= 2; order.size() == n and outlives the KeyChooser
+	// Exceptions: Throws std::invalid_argument if distribution is unknown
+	// Strong Guarantee, Exception Neutral
+	KeyChooser(const std::string & distribution, std::uint64_t n, const std::vector<std::uint64_t> & order)
+		: _distribution(distribution), _n(n), _next(0), _order(order), _uniform(0, n - 1),
+		  _zipfian(distribution == "zipfian" ? n : 2, 0.99)
+	{
+		if (distribution != "sequential" && distribution != "uniform" && distribution != "zipfian")
+			throw std::invalid_argument("unknown distribution " + distribution);
+	}
+
+	// operator()
+	// Returns the index, in [0, n), of the next key to touch.
+	//
+	// No-Throw Guarantee
+	template <typename Generator>
+	std::uint64_t operator()(Generator & generator)
+	{
+		if (_distribution == "sequential")
+			return _next++ % _n;
+		if (_distribution == "uniform")
+			return _uniform(generator);
+		return _order[_zipfian(generator)];
+	}
+};
+
+// *********************************************************************
+// Heap Accounting
+// *********************************************************************
+
+// The global allocation functions are replaced to keep a count of the bytes the heap has handed
+// out and not yet taken back, as malloc_usable_size reports them, so that the bytes per key of
+// each structure include its allocator overhead, and of the calls to operator new and the bytes
+// they asked for, so that each workload can report what it costs the allocator per operation.
+// The counts are only read between measurements.
+std::atomic<long long> heapBytes{0};
+std::atomic<unsigned long long> heapAllocations{0};
+std::atomic<unsigned long long> heapAllocatedBytes{0};
+
+void * operator new(std::size_t size)
+{
+	void * memory = std::malloc(size ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	heapBytes.fetch_add(static_cast<long long>(::malloc_usable_size(memory)), std::memory_order_relaxed);
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	heapAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	return memory;
+}
+
+void * operator new[](std::size_t size)
+{
+	return ::operator new(size);
+}
+
+void operator delete(void * memory) noexcept
+{
+	if (!memory)
+		return;
+	heapBytes.fetch_sub(static_cast<long long>(::malloc_usable_size(memory)), std::memory_order_relaxed);
+	std::free(memory);
+}
+
+void operator delete[](void * memory) noexcept
+{
+	::operator delete(memory);
+}
+
+void operator delete(void * memory, std::size_t) noexcept
+{
+	::operator delete(memory);
+}
+
+void operator delete[](void * memory, std::size_t) noexcept
+{
+	::operator delete(memory);
+}
+
+// *********************************************************************
+// Hardware Counters
+// *********************************************************************
+
+// class DtlbMissCounter
+// Counts the data TLB read misses of the calling thread in user space, with perf_event_open, so
+// that runs with and without huge pages can be compared. Where there is no such counter, as in
+// many containers and virtual machines or with kernel.perf_event_paranoid at 3, available() is
+// false and read() returns 0.
+//
+// Invariants:
+//		_fd is an open, enabled perf event, or -1
+class DtlbMissCounter {
+private:
+	int _fd;
+
+public:
+	DtlbMissCounter()
+	{
+		perf_event_attr attributes;
+		std::memset(&attributes, 0, sizeof(attributes));
+		attributes.size = sizeof(attributes);
+		attributes.type = PERF_TYPE_HW_CACHE;
+		attributes.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+		                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+		attributes.exclude_kernel = 1;
+		attributes.exclude_hv = 1;
+		_fd = static_cast<int>(::syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+	}
+
+	DtlbMissCounter(const DtlbMissCounter & other) = delete;
+	DtlbMissCounter & operator=(const DtlbMissCounter & other) = delete;
+
+	~DtlbMissCounter()
+	{
+		if (_fd >= 0)
+			::close(_fd);
+	}
+
+	bool available() const
+	{
+		return _fd >= 0;
+	}
+
+	unsigned long long read() const
+	{
+		unsigned long long count = 0;
+		if (_fd >= 0 && ::read(_fd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count)))
+			count = 0;
+		return count;
+	}
+};
+
+DtlbMissCounter dtlbMisses;
+
+// *********************************************************************
+// Baselines
+// *********************************************************************
+
+// class BPlusTree
+// A plain B+tree of distinct ints, the cache-friendly baseline for SkipList: keys sit in sorted
+// arrays of up to NodeKeys per node, and the leaves are chained for range scans. remove takes a
+// key out of its leaf without merging underfull nodes, which leaves lookups correct and is how
+// many production trees behave under deletes.
+//
+// Invariants:
+//		Every key in _children[i] of an Inner is >= _keys[i - 1] and < _keys[i]
+//		Leaves are linked through _next in key order
+//		Every leaf is at the same depth
+class BPlusTree {
+private:
+	static const int NodeKeys = 64;
+
+	struct Node {
+		bool _leaf;
+		int _count;
+		int _keys[NodeKeys];
+	};
+
+	struct Leaf : Node {
+		Leaf * _next;
+	};
+
+	struct Inner : Node {
+		Node * _children[NodeKeys + 1];
+	};
+
+	// struct Split
+	// A node's new right sibling, and the smallest key under it, for the parent to link in.
+	struct Split {
+		int _separator;
+		Node * _right;
+	};
+
+	Node * _root;
+
+public:
+	BPlusTree()
+		: _root(newLeaf())
+	{}
+
+	BPlusTree(const BPlusTree & other) = delete;
+	BPlusTree & operator=(const BPlusTree & other) = delete;
+
+	~BPlusTree()
+	{
+		destroy(_root);
+	}
+
+	// insert
+	// Adds key if it is not already present.
+	void insert(int key)
+	{
+		Split split = insertInto(_root, key);
+		if (!split._right)
+			return;
+		Inner * root = new Inner;
+		root->_leaf = false;
+		root->_count = 1;
+		root->_keys[0] = split._separator;
+		root->_children[0] = _root;
+		root->_children[1] = split._right;
+		_root = root;
+	}
+
+	// search
+	// Returns true if key is present.
+	bool search(int key) const
+	{
+		const Leaf * leaf = findLeaf(key);
+		const int * end = leaf->_keys + leaf->_count;
+		const int * found = std::lower_bound(leaf->_keys, end, key);
+		return found != end && *found == key;
+	}
+
+	// remove
+	// Takes key out of its leaf, if it is present.
+	void remove(int key)
+	{
+		Leaf * leaf = findLeaf(key);
+		int * end = leaf->_keys + leaf->_count;
+		int * found = std::lower_bound(leaf->_keys, end, key);
+		if (found == end || *found != key)
+			return;
+		std::copy(found + 1, end, found);
+		leaf->_count--;
+	}
+
+	// scan
+	// Calls visit(key) for every key in [lowKey, highKey], in sorted order.
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) const
+	{
+		const Leaf * leaf = findLeaf(lowKey);
+		const int * key = std::lower_bound(leaf->_keys, leaf->_keys + leaf->_count, lowKey);
+		for (; leaf; leaf = leaf->_next, key = leaf ? leaf->_keys : nullptr)
+			for (; key != leaf->_keys + leaf->_count; ++key)
+			{
+				if (*key > highKey)
+					return;
+				visit(*key);
+			}
+	}
+
+private:
+	static Leaf * newLeaf()
+	{
+		Leaf * leaf = new Leaf;
+		leaf->_leaf = true;
+		leaf->_count = 0;
+		leaf->_next = nullptr;
+		return leaf;
+	}
+
+	static void destroy(Node * node)
+	{
+		if (node->_leaf)
+		{
+			delete static_cast<Leaf *>(node);
+			return;
+		}
+		Inner * inner = static_cast<Inner *>(node);
+		for (int i = 0; i <= inner->_count; i++)
+			destroy(inner->_children[i]);
+		delete inner;
+	}
+
+	// childFor
+	// Returns the index of the child of inner whose range holds key.
+	static int childFor(const Inner * inner, int key)
+	{
+		return static_cast<int>(std::upper_bound(inner->_keys, inner->_keys + inner->_count, key) - inner->_keys);
+	}
+
+	Leaf * findLeaf(int key) const
+	{
+		Node * node = _root;
+		while (!node->_leaf)
+		{
+			Inner * inner = static_cast<Inner *>(node);
+			node = inner->_children[childFor(inner, key)];
+		}
+		return static_cast<Leaf *>(node);
+	}
+
+	// insertInto
+	// Inserts key under node, splitting node if it is full, and returns the split for the
+	// parent to link in, with a null _right if node did not split.
+	static Split insertInto(Node * node, int key)
+	{
+		if (node->_leaf)
+		{
+			Leaf * leaf = static_cast<Leaf *>(node);
+			int * position = std::lower_bound(leaf->_keys, leaf->_keys + leaf->_count, key);
+			if (position != leaf->_keys + leaf->_count && *position == key)
+				return Split{ 0, nullptr };
+			Split split{ 0, nullptr };
+			if (leaf->_count == NodeKeys)
+			{
+				Leaf * right = newLeaf();
+				right->_count = NodeKeys / 2;
+				std::copy(leaf->_keys + NodeKeys / 2, leaf->_keys + NodeKeys, right->_keys);
+				leaf->_count = NodeKeys / 2;
+				right->_next = leaf->_next;
+				leaf->_next = right;
+				split = Split{ right->_keys[0], right };
+				if (key >= split._separator)
+					leaf = right;
+			}
+			insertAt(leaf, key);
+			return split;
+		}
+
+		Inner * inner = static_cast<Inner *>(node);
+		int child = childFor(inner, key);
+		Split below = insertInto(inner->_children[child], key);
+		if (!below._right)
+			return below;
+		if (inner->_count < NodeKeys)
+		{
+			linkChild(inner, child, below);
+			return Split{ 0, nullptr };
+		}
+
+		// Move the upper half to a new sibling; the middle key moves up to the parent
+		const int middle = NodeKeys / 2;
+		Inner * right = new Inner;
+		right->_leaf = false;
+		right->_count = NodeKeys - middle - 1;
+		std::copy(inner->_keys + middle + 1, inner->_keys + NodeKeys, right->_keys);
+		std::copy(inner->_children + middle + 1, inner->_children + NodeKeys + 1, right->_children);
+		inner->_count = middle;
+		Split split{ inner->_keys[middle], right };
+		if (child <= middle)
+			linkChild(inner, child, below);
+		else
+			linkChild(right, child - middle - 1, below);
+		return split;
+	}
+
+	static void insertAt(Leaf * leaf, int key)
+	{
+		int * position = std::lower_bound(leaf->_keys, leaf->_keys + leaf->_count, key);
+		std::copy_backward(position, leaf->_keys + leaf->_count, leaf->_keys + leaf->_count + 1);
+		*position = key;
+		leaf->_count++;
+	}
+
+	// linkChild
+	// Links split in just after child, which it was split from.
+	static void linkChild(Inner * inner, int child, const Split & split)
+	{
+		std::copy_backward(inner->_keys + child, inner->_keys + inner->_count, inner->_keys + inner->_count + 1);
+		std::copy_backward(inner->_children + child + 1, inner->_children + inner->_count + 1,
+		                   inner->_children + inner->_count + 2);
+		inner->_keys[child] = split._separator;
+		inner->_children[child + 1] = split._right;
+		inner->_count++;
+	}
+};
+
+// Targets
+// Each structure the benchmark drives is wrapped in a target with the same five operations.
+// Ordered is false for structures that cannot scan a key range, and the range-scan workload
+// is skipped for them.
+
+struct SkipListTarget {
+	static constexpr const char * Name = "SkipList";
+	static const bool Ordered = true;
+	SkipList _list;
+	void insert(int key) { _list.insert(key); }
+	bool search(int key) { return _list.search(key) != nullptr; }
+	void remove(int key) { _list.remove(key); }
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) { _list.scan(lowKey, highKey, visit); }
+};
+
+struct PooledSkipListTarget {
+	static constexpr const char * Name = "PooledSkipList";
+	static const bool Ordered = true;
+	PooledSkipList _list;
+	void insert(int key) { _list.insert(key); }
+	bool search(int key) { return _list.search(key) != nullptr; }
+	void remove(int key) { _list.remove(key); }
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) { _list.scan(lowKey, highKey, visit); }
+};
+
+struct ArenaSkipListTarget {
+	static constexpr const char * Name = "ArenaSkipList";
+	static const bool Ordered = true;
+	ArenaSkipList _list;
+	void insert(int key) { _list.insert(key); }
+	bool search(int key) { return _list.search(key) != nullptr; }
+	void remove(int key) { _list.remove(key); }
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) { _list.scan(lowKey, highKey, visit); }
+};
+
+struct HugePageSkipListTarget {
+	static constexpr const char * Name = "HugePageSkipList";
+	static const bool Ordered = true;
+	ArenaSkipList _list{ ArenaAllocator<SkipListNode>(hugePageOptions()) };
+	void insert(int key) { _list.insert(key); }
+	bool search(int key) { return _list.search(key) != nullptr; }
+	void remove(int key) { _list.remove(key); }
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) { _list.scan(lowKey, highKey, visit); }
+
+	static PoolOptions hugePageOptions()
+	{
+		PoolOptions options;
+		options.hugePages = true;
+		return options;
+	}
+};
+
+// Slabs a pool maps itself never pass through operator new, so a target whose slabs are mapped
+// reports their bytes here for the bytes per key to count them.
+template <typename Target>
+unsigned long long mappedBytes(const Target &)
+{
+	return 0;
+}
+
+unsigned long long mappedBytes(const HugePageSkipListTarget & target)
+{
+	return target._list.allocator().pool().stats().reservedBytes;
+}
+
+struct SetTarget {
+	static constexpr const char * Name = "std::set";
+	static const bool Ordered = true;
+	std::set<int> _set;
+	void insert(int key) { _set.insert(key); }
+	bool search(int key) { return _set.find(key) != _set.end(); }
+	void remove(int key) { _set.erase(key); }
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit)
+	{
+		for (auto key = _set.lower_bound(lowKey); key != _set.end() && *key <= highKey; ++key)
+			visit(*key);
+	}
+};
+
+struct UnorderedSetTarget {
+	static constexpr const char * Name = "std::unordered_set";
+	static const bool Ordered = false;
+	std::unordered_set<int> _set;
+	void insert(int key) { _set.insert(key); }
+	bool search(int key) { return _set.find(key) != _set.end(); }
+	void remove(int key) { _set.erase(key); }
+	template <typename Visit>
+	void scan(int, int, Visit) {}
+};
+
+struct BPlusTreeTarget {
+	static constexpr const char * Name = "BPlusTree";
+	static const bool Ordered = true;
+	BPlusTree _tree;
+	void insert(int key) { _tree.insert(key); }
+	bool search(int key) { return _tree.search(key); }
+	void remove(int key) { _tree.remove(key); }
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) { _tree.scan(lowKey, highKey, visit); }
+};
+
+// *********************************************************************
+// Measurement
+// *********************************************************************
+
+// struct Options
+// Command-line settings.
+struct Options {
+	std::vector<std::uint64_t> sizes{ 1000, 10000, 100000, 1000000 };
+	std::vector<std::string> distributions{ "uniform", "sequential", "zipfian" };
+	std::vector<std::string> structures{ "skiplist", "pooled", "arena", "hugepages", "set", "unordered_set", "btree" };
+	std::uint64_t ops = 1000000;
+	std::uint64_t scanKeys = 100;
+	std::uint64_t seed = 42;
+	bool structuresGiven = false;
+	std::vector<std::string> ycsb;
+	std::vector<unsigned> threads;
+	std::uint64_t records = 1000000;
+	std::string histogramFile;
+};
+
+// keyAt
+// Returns the index-th key stored in a list of the benchmark: the even numbers, centred on zero,
+// so that the odd numbers between them are guaranteed misses.
+//
+// No-Throw Guarantee
+int keyAt(std::uint64_t index, std::uint64_t n)
+{
+	return static_cast<int>(2 * static_cast<long long>(index) - static_cast<long long>(n));
+}
+
+// struct OperationCost
+// The calls to operator new, the bytes they asked for, and the data TLB misses, during one workload.
+struct OperationCost {
+	unsigned long long allocations;
+	unsigned long long bytes;
+	unsigned long long dtlbMisses;
+};
+
+// report
+// Prints one CSV row: the throughput of latencies.size() operations that took seconds in all,
+// percentiles of the per-operation latencies, in nanoseconds, the heap bytes per key
+// the structure held once it was built, the allocations and allocated bytes per operation, and the
+// data TLB misses per operation, left empty where there is no counter.
+//
+// Preconditions: latencies is not empty
+// Exceptions: Throws if std::cout throws
+void report(const std::string & structure, const std::string & workload, const std::string & distribution,
+            std::uint64_t size, std::vector<std::uint64_t> & latencies, double seconds, double bytesPerKey,
+            OperationCost cost)
+{
+	const double ops = static_cast<double>(latencies.size());
+	auto percentile = [&latencies](double p) {
+		auto nth = latencies.begin() + static_cast<std::ptrdiff_t>(p * static_cast<double>(latencies.size() - 1));
+		std::nth_element(latencies.begin(), nth, latencies.end());
+		return *nth;
+	};
+	std::uint64_t p50 = percentile(0.50);
+	std::uint64_t p90 = percentile(0.90);
+	std::uint64_t p99 = percentile(0.99);
+	std::uint64_t p999 = percentile(0.999);
+	std::cout << structure << ',' << workload << ',' << distribution << ',' << size << ','
+	          << latencies.size() << ',' << seconds << ',' << static_cast<double>(latencies.size()) / seconds << ','
+	          << p50 << ',' << p90 << ',' << p99 << ',' << p999 << ','
+	          << *std::max_element(latencies.begin(), latencies.end()) << ',' << bytesPerKey << ','
+	          << static_cast<double>(cost.allocations) / ops << ',' << static_cast<double>(cost.bytes) / ops << ',';
+	if (dtlbMisses.available())
+		std::cout << static_cast<double>(cost.dtlbMisses) / ops;
+	std::cout << std::endl;
+}
+
+// measure
+// Runs operation(i) for i in [0, latencies.size()), storing the time each call took in latencies,
+// and returns the total time in seconds. The caller allocates latencies, so that measuring
+// allocates nothing of its own, and the allocations and TLB misses of the operations are added to cost.
+//
+// Exceptions: Throws if operation throws
+template <typename Operation>
+double measure(std::vector<std::uint64_t> & latencies, OperationCost & cost, Operation operation)
+{
+	const unsigned long long allocationsBefore = heapAllocations.load(std::memory_order_relaxed);
+	const unsigned long long bytesBefore = heapAllocatedBytes.load(std::memory_order_relaxed);
+	const unsigned long long missesBefore = dtlbMisses.read();
+	using Clock = std::chrono::steady_clock;
+	auto start = Clock::now();
+	auto before = start;
+	for (std::uint64_t i = 0; i < latencies.size(); i++)
+	{
+		operation(i);
+		auto after = Clock::now();
+		latencies[i] = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+		before = after;
+	}
+	cost.allocations += heapAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+	cost.bytes += heapAllocatedBytes.load(std::memory_order_relaxed) - bytesBefore;
+	cost.dtlbMisses += dtlbMisses.read() - missesBefore;
+	return std::chrono::duration<double>(before - start).count();
+}
+
+// benchmark
+// Runs every workload against a Target of size keys, with lookups drawn from distribution:
+// insert builds it (in ascending order for sequential, in shuffled order otherwise), then
+// search-hit, search-miss and range-scan run ops operations each, churn removes and reinserts
+// min(ops, size) keys, one pair per operation, to show the steady-state cost of the allocator,
+// remove takes min(ops, size / 2) keys out, and teardown destroys the structure with the rest,
+// as one operation. Every structure sees the same keys in the same order.
+//
+// Preconditions: size >= 2
+// Exceptions: Throws if Target or std::cout throws
+template <typename Target>
+void benchmark(const Options & options, std::uint64_t size, const std::string & distribution)
+{
+	std::mt19937_64 generator(options.seed);
+	std::vector<std::uint64_t> order(size);
+	for (std::uint64_t i = 0; i < size; i++)
+		order[i] = i;
+	if (distribution != "sequential")
+		std::shuffle(order.begin(), order.end(), generator);
+	KeyChooser chooser(distribution, size, order);
+	std::vector<std::uint64_t> latencies;
+	latencies.reserve(std::max(size, options.ops));
+
+	auto run = [&](const char * workload, std::uint64_t count, double bytesPerKey, auto operation) {
+		latencies.resize(count);
+		OperationCost cost = {0, 0, 0};
+		double seconds = measure(latencies, cost, operation);
+		report(Target::Name, workload, distribution, size, latencies, seconds, bytesPerKey, cost);
+	};
+
+	long long heapBefore = heapBytes.load(std::memory_order_relaxed);
+	std::unique_ptr<Target> target(new Target);
+	latencies.resize(size);
+	OperationCost cost = {0, 0, 0};
+	double seconds = measure(latencies, cost, [&](std::uint64_t i) { target->insert(keyAt(order[i], size)); });
+	double bytesPerKey = static_cast<double>(heapBytes.load(std::memory_order_relaxed) - heapBefore +
+	                                         static_cast<long long>(mappedBytes(*target))) /
+	                     static_cast<double>(size);
+	report(Target::Name, "insert", distribution, size, latencies, seconds, bytesPerKey, cost);
+
+	std::uint64_t found = 0;
+	run("search-hit", options.ops, bytesPerKey,
+	    [&](std::uint64_t) { found += target->search(keyAt(chooser(generator), size)) ? 1 : 0; });
+	run("search-miss", options.ops, bytesPerKey,
+	    [&](std::uint64_t) { found += target->search(keyAt(chooser(generator), size) + 1) ? 1 : 0; });
+	if (Target::Ordered)
+	{
+		std::uint64_t scanned = 0;
+		const int scanWidth = static_cast<int>(2 * options.scanKeys - 1);
+		run("range-scan", options.ops, bytesPerKey,
+		    [&](std::uint64_t) {
+			    int low = keyAt(chooser(generator), size);
+			    target->scan(low, low + scanWidth, [&scanned](int) { scanned++; });
+		    });
+	}
+	run("churn", std::min(options.ops, size), bytesPerKey,
+	    [&](std::uint64_t i) {
+		    target->remove(keyAt(order[i], size));
+		    target->insert(keyAt(order[i], size));
+	    });
+	run("remove", std::min(options.ops, size / 2), bytesPerKey,
+	    [&](std::uint64_t i) { target->remove(keyAt(order[i], size)); });
+	run("teardown", 1, bytesPerKey, [&](std::uint64_t) { target.reset(); });
+	if (found != options.ops)
+		std::cerr << "skiplist_bench: " << Target::Name << ": expected " << options.ops
+		          << " hits and no misses, found " << found << std::endl;
+}
+
+// *********************************************************************
+// YCSB Workloads
+// *********************************************************************
+
+// class LatencyHistogram
+// Counts latencies in buckets a quarter of a power of two wide, so percentiles are exact to within
+// 25% at any scale in a fixed 2 KB, and histograms from several threads can simply be added.
+//
+// Invariants:
+//		_counts[i] is the number of latencies recorded in [low(i), high(i)]
+class LatencyHistogram {
+public:
+	static const int Buckets = 252;
+
+private:
+	std::uint64_t _counts[Buckets] = {};
+	std::uint64_t _total = 0;
+	std::uint64_t _max = 0;
+
+public:
+	void record(std::uint64_t nanoseconds)
+	{
+		_counts[bucket(nanoseconds)]++;
+		_total++;
+		_max = std::max(_max, nanoseconds);
+	}
+
+	void add(const LatencyHistogram & other)
+	{
+		for (int i = 0; i < Buckets; i++)
+			_counts[i] += other._counts[i];
+		_total += other._total;
+		_max = std::max(_max, other._max);
+	}
+
+	std::uint64_t total() const { return _total; }
+	std::uint64_t max() const { return _max; }
+	std::uint64_t count(int index) const { return _counts[index]; }
+
+	// percentile
+	// Returns the upper bound of the bucket holding the p-th fraction of the latencies, at most max().
+	std::uint64_t percentile(double p) const
+	{
+		auto rank = static_cast<std::uint64_t>(p * static_cast<double>(_total - 1));
+		std::uint64_t seen = 0;
+		for (int i = 0; i < Buckets; i++)
+		{
+			seen += _counts[i];
+			if (seen > rank)
+				return std::min(high(i), _max);
+		}
+		return _max;
+	}
+
+	// low, high
+	// Return the smallest and largest latency that falls in bucket index. Values below 4 have
+	// a bucket each; above, each power of two is split into four.
+	static std::uint64_t low(int index)
+	{
+		if (index < 4)
+			return static_cast<std::uint64_t>(index);
+		return static_cast<std::uint64_t>(4 + index % 4) << (index / 4 - 1);
+	}
+
+	static std::uint64_t high(int index)
+	{
+		return index + 1 < Buckets ? low(index + 1) - 1 : std::numeric_limits<std::uint64_t>::max();
+	}
+
+private:
+	static int bucket(std::uint64_t value)
+	{
+		if (value < 4)
+			return static_cast<int>(value);
+		int top = 63;
+		while (!(value >> top))
+			top--;
+		return 4 * (top - 1) + static_cast<int>((value >> (top - 2)) & 3);
+	}
+};
+
+// struct YcsbMix
+// The operation mix of one of the YCSB core workloads, in percent of operations:
+//		A: update heavy      50 read, 50 update
+//		B: read mostly       95 read, 5 update
+//		C: read only         100 read
+//		D: read latest       95 read, 5 insert; reads favour the newest records
+//		E: short ranges      95 scan of 1 to 100 records, 5 insert
+//		F: read-modify-write 50 read, 50 read-modify-write
+// In each mix the operations not listed are read-modify-writes. Records are ints, so an update
+// rewrites a record as a remove and an insert of the same key.
+struct YcsbMix {
+	int read;
+	int update;
+	int insert;
+	int scan;
+	bool latest;
+};
+
+// Operations a YCSB thread performs, indexing its histograms
+enum YcsbOperation { Read, Update, Insert, Scan, ReadModifyWrite, YcsbOperations };
+const char * const YcsbOperationNames[YcsbOperations] = { "read", "update", "insert", "scan", "read-modify-write" };
+
+// ycsbMix
+// Returns the mix of workload, one of "A" to "F".
+//
+// Exceptions: Throws std::invalid_argument for any other name
+YcsbMix ycsbMix(const std::string & workload)
+{
+	if (workload == "A") return YcsbMix{ 50, 50, 0, 0, false };
+	if (workload == "B") return YcsbMix{ 95, 5, 0, 0, false };
+	if (workload == "C") return YcsbMix{ 100, 0, 0, 0, false };
+	if (workload == "D") return YcsbMix{ 95, 0, 5, 0, true };
+	if (workload == "E") return YcsbMix{ 0, 0, 5, 95, false };
+	if (workload == "F") return YcsbMix{ 50, 0, 0, 0, false };
+	throw std::invalid_argument("unknown YCSB workload " + workload);
+}
+
+// Concurrent targets
+// The structures that threads can share. SkipList is not safe to share, so it is driven
+// behind one mutex, the baseline the concurrent variants have to beat.
+
+struct LockedSkipListTarget {
+	static constexpr const char * Name = "SkipList+mutex";
+	SkipList _list;
+	std::mutex _mutex;
+	void insert(int key) { std::lock_guard<std::mutex> lock(_mutex); _list.insert(key); }
+	bool search(int key) { std::lock_guard<std::mutex> lock(_mutex); return _list.search(key) != nullptr; }
+	void remove(int key) { std::lock_guard<std::mutex> lock(_mutex); _list.remove(key); }
+	std::size_t scan(int lowKey, int highKey)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		std::size_t count = 0;
+		_list.scan(lowKey, highKey, [&count](int) { count++; });
+		return count;
+	}
+};
+
+struct RcuSkipListTarget {
+	static constexpr const char * Name = "RcuSkipList";
+	RcuSkipList _list;
+	void insert(int key) { _list.insert(key); }
+	bool search(int key) { return _list.search(key); }
+	void remove(int key) { _list.remove(key); }
+	std::size_t scan(int lowKey, int highKey)
+	{
+		std::size_t count = 0;
+		_list.scan(lowKey, highKey, [&count](int) { count++; });
+		return count;
+	}
+};
+
+struct BufferedSkipListTarget {
+	static constexpr const char * Name = "BufferedSkipList";
+	BufferedSkipList _list;
+	void insert(int key) { _list.insert(key); }
+	bool search(int key) { return _list.search(key); }
+	void remove(int key) { _list.remove(key); }
+	std::size_t scan(int lowKey, int highKey) { return _list.range(lowKey, highKey).size(); }
+};
+
+// ycsbKey
+// Returns the key of record number record. Records are spread over the key space by a
+// multiplicative hash, as YCSB hashes its record numbers, so that inserts do not all land
+// at the end of the list.
+//
+// No-Throw Guarantee
+int ycsbKey(std::uint64_t record)
+{
+	return static_cast<int>(static_cast<std::uint32_t>(record * 2654435761u));
+}
+
+// runYcsb
+// Loads options.records records into a fresh Target, then runs options.ops operations of
+// workload split over threads threads, and prints one CSV row for all operations together
+// and one for each kind of operation. Appends the latency histograms to histograms, if open.
+//
+// Preconditions: threads >= 1
+// Exceptions: Throws if Target, std::thread or std::cout throws
+template <typename Target>
+void runYcsb(const Options & options, const std::string & workload, unsigned threads, std::ostream * histograms)
+{
+	YcsbMix mix = ycsbMix(workload);
+	std::unique_ptr<Target> target(new Target);
+	{
+		std::vector<std::uint64_t> order(options.records);
+		for (std::uint64_t i = 0; i < options.records; i++)
+			order[i] = i;
+		std::mt19937_64 generator(options.seed);
+		std::shuffle(order.begin(), order.end(), generator);
+		for (auto record : order)
+			target->insert(ycsbKey(record));
+	}
+
+	// Requests pick records by Zipfian rank: scrambled over the records for most workloads,
+	// counted back from the newest record for D
+	std::atomic<std::uint64_t> nextRecord{options.records};
+	const ZipfianGenerator zipfian(options.records, 0.99);
+	std::vector<std::vector<LatencyHistogram>> perThread(threads, std::vector<LatencyHistogram>(YcsbOperations));
+	std::atomic<unsigned> ready{0};
+	std::atomic<bool> go{false};
+	auto worker = [&](unsigned thread) {
+		std::mt19937_64 generator(options.seed + 1 + thread);
+		ZipfianGenerator ranks = zipfian;
+		std::uniform_int_distribution<int> percent(0, 99);
+		std::uniform_int_distribution<int> scanLength(1, 100);
+		std::vector<LatencyHistogram> & mine = perThread[thread];
+		auto chooseKey = [&]() {
+			std::uint64_t rank = ranks(generator);
+			if (mix.latest)
+			{
+				std::uint64_t newest = nextRecord.load(std::memory_order_relaxed) - 1;
+				return ycsbKey(rank <= newest ? newest - rank : 0);
+			}
+			return ycsbKey((rank * 0x9E3779B97F4A7C15ull >> 20) % options.records);
+		};
+		std::uint64_t operations = options.ops / threads + (thread < options.ops % threads ? 1 : 0);
+
+		ready.fetch_add(1);
+		while (!go.load(std::memory_order_acquire))
+			std::this_thread::yield();
+		auto before = std::chrono::steady_clock::now();
+		for (std::uint64_t i = 0; i < operations; i++)
+		{
+			int roll = percent(generator);
+			YcsbOperation operation;
+			if (roll < mix.read)
+			{
+				operation = Read;
+				target->search(chooseKey());
+			}
+			else if (roll < mix.read + mix.update)
+			{
+				operation = Update;
+				int key = chooseKey();
+				target->remove(key);
+				target->insert(key);
+			}
+			else if (roll < mix.read + mix.update + mix.insert)
+			{
+				operation = Insert;
+				target->insert(ycsbKey(nextRecord.fetch_add(1)));
+			}
+			else if (roll < mix.read + mix.update + mix.insert + mix.scan)
+			{
+				operation = Scan;
+				int low = chooseKey();
+				// Records are spread evenly, so a key span of length * 2^32 / records holds about length of them
+				long long span = static_cast<long long>(scanLength(generator)) * (1ll << 32) /
+				                 static_cast<long long>(nextRecord.load(std::memory_order_relaxed));
+				target->scan(low, static_cast<int>(std::min<long long>(low + span, std::numeric_limits<int>::max())));
+			}
+			else
+			{
+				operation = ReadModifyWrite;
+				int key = chooseKey();
+				if (target->search(key))
+				{
+					target->remove(key);
+					target->insert(key);
+				}
+			}
+			auto after = std::chrono::steady_clock::now();
+			mine[operation].record(static_cast<std::uint64_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count()));
+			before = after;
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for (unsigned thread = 0; thread < threads; thread++)
+		workers.emplace_back(worker, thread);
+	while (ready.load() < threads)
+		std::this_thread::yield();
+	auto start = std::chrono::steady_clock::now();
+	go.store(true, std::memory_order_release);
+	for (auto & thread : workers)
+		thread.join();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	LatencyHistogram all;
+	std::vector<LatencyHistogram> byOperation(YcsbOperations);
+	for (const auto & threadHistograms : perThread)
+		for (int operation = 0; operation < YcsbOperations; operation++)
+		{
+			byOperation[operation].add(threadHistograms[operation]);
+			all.add(threadHistograms[operation]);
+		}
+	auto print = [&](const char * operation, const LatencyHistogram & histogram) {
+		if (histogram.total() == 0)
+			return;
+		std::cout << Target::Name << ',' << workload << ',' << threads << ',' << operation << ','
+		          << histogram.total() << ',' << seconds << ',' << static_cast<double>(histogram.total()) / seconds << ','
+		          << histogram.percentile(0.50) << ',' << histogram.percentile(0.99) << ','
+		          << histogram.percentile(0.999) << ',' << histogram.max() << std::endl;
+		if (!histograms)
+			return;
+		for (int i = 0; i < LatencyHistogram::Buckets; i++)
+			if (histogram.count(i) > 0)
+				*histograms << Target::Name << ',' << workload << ',' << threads << ',' << operation << ','
+				            << LatencyHistogram::low(i) << ',' << LatencyHistogram::high(i) << ','
+				            << histogram.count(i) << '\n';
+	};
+	print("all", all);
+	for (int operation = 0; operation < YcsbOperations; operation++)
+		print(YcsbOperationNames[operation], byOperation[operation]);
+}
+
+// splitList
+// Returns the comma-separated parts of text.
+//
+// Exceptions: Throws if std::string or std::vector throws
+std::vector<std::string> splitList(const std::string & text)
+{
+	std::vector<std::string> parts;
+	std::string::size_type start = 0;
+	for (std::string::size_type comma; (comma = text.find(',', start)) != std::string::npos; start = comma + 1)
+		parts.push_back(text.substr(start, comma - start));
+	parts.push_back(text.substr(start));
+	return parts;
+}
+
+// parseOptions
+// Reads the command line into options.
+//
+// Exceptions: Throws std::invalid_argument on an unknown or malformed option
+Options parseOptions(int argc, char *argv[])
+{
+	Options options;
+	for (int i = 1; i < argc; i++)
+	{
+		std::string flag = argv[i];
+		if (i + 1 >= argc)
+			throw std::invalid_argument("missing value for " + flag);
+		std::string value = argv[++i];
+		if (flag == "--sizes")
+		{
+			options.sizes.clear();
+			for (const auto & size : splitList(value))
+				options.sizes.push_back(static_cast<std::uint64_t>(std::stod(size)));
+		}
+		else if (flag == "--distributions")
+			options.distributions = splitList(value);
+		else if (flag == "--structures")
+		{
+			options.structures = splitList(value);
+			options.structuresGiven = true;
+		}
+		else if (flag == "--ycsb")
+			options.ycsb = splitList(value);
+		else if (flag == "--threads")
+		{
+			for (const auto & threads : splitList(value))
+				options.threads.push_back(static_cast<unsigned>(std::stoul(threads)));
+		}
+		else if (flag == "--records")
+			options.records = static_cast<std::uint64_t>(std::stod(value));
+		else if (flag == "--histogram-file")
+			options.histogramFile = value;
+		else if (flag == "--ops")
+			options.ops = std::stoull(value);
+		else if (flag == "--scan-keys")
+			options.scanKeys = std::stoull(value);
+		else if (flag == "--seed")
+			options.seed = std::stoull(value);
+		else
+			throw std::invalid_argument("unknown option " + flag);
+	}
+	for (auto size : options.sizes)
+		if (size < 2 || size > 100000000)
+			throw std::invalid_argument("sizes must be between 2 and 1e8");
+	if (!options.ycsb.empty())
+	{
+		if (!options.structuresGiven)
+			options.structures = { "skiplist", "rcu", "buffered" };
+		if (options.threads.empty())
+			for (unsigned threads = 1; threads <= std::max(1u, std::thread::hardware_concurrency()); threads *= 2)
+				options.threads.push_back(threads);
+		for (const auto & workload : options.ycsb)
+			ycsbMix(workload);
+		for (auto threads : options.threads)
+			if (threads == 0)
+				throw std::invalid_argument("--threads must be positive");
+		if (options.records < 2 || options.records > 100000000)
+			throw std::invalid_argument("--records must be between 2 and 1e8");
+	}
+	for (const auto & structure : options.structures)
+		if (options.ycsb.empty() ? structure != "skiplist" && structure != "pooled" && structure != "arena" &&
+		                           structure != "hugepages" && structure != "set" &&
+		                           structure != "unordered_set" && structure != "btree"
+		                         : structure != "skiplist" && structure != "rcu" && structure != "buffered")
+			throw std::invalid_argument("unknown structure " + structure);
+	if (options.ops == 0 || options.scanKeys == 0)
+		throw std::invalid_argument("--ops and --scan-keys must be positive");
+	return options;
+}
+
+// runAllYcsb
+// Runs every YCSB workload against every concurrent structure at every thread count, printing
+// throughput against threads, and writes the latency histograms to options.histogramFile if set.
+//
+// Exceptions: Throws std::runtime_error if the histogram file cannot be written; throws if runYcsb throws
+void runAllYcsb(const Options & options)
+{
+	std::ofstream histogramFile;
+	if (!options.histogramFile.empty())
+	{
+		histogramFile.open(options.histogramFile);
+		if (!histogramFile)
+			throw std::runtime_error("cannot write " + options.histogramFile);
+		histogramFile << "structure,workload,threads,operation,low_ns,high_ns,count\n";
+	}
+	std::ostream * histograms = histogramFile.is_open() ? &histogramFile : nullptr;
+
+	std::cout << "structure,workload,threads,operation,ops,seconds,ops_per_sec,p50_ns,p99_ns,p999_ns,max_ns" << std::endl;
+	for (const auto & workload : options.ycsb)
+		for (const auto & structure : options.structures)
+			for (auto threads : options.threads)
+			{
+				if (structure == "skiplist")
+					runYcsb<LockedSkipListTarget>(options, workload, threads, histograms);
+				else if (structure == "rcu")
+					runYcsb<RcuSkipListTarget>(options, workload, threads, histograms);
+				else
+					runYcsb<BufferedSkipListTarget>(options, workload, threads, histograms);
+			}
+	if (histograms && !histogramFile.flush())
+		throw std::runtime_error("error writing " + options.histogramFile);
+}
+
+// Main program
+// Parses the options, prints the CSV header and runs every size, distribution and structure,
+// or with --ycsb, every YCSB workload, structure and thread count.
+int main(int argc, char *argv[])
+{
+	Options options;
+	try {
+		options = parseOptions(argc, argv);
+	}
+	catch (const std::exception & e) {
+		std::cerr << "skiplist_bench: " << e.what() << std::endl
+		          << "usage: skiplist_bench [--sizes 1000,1e6] [--distributions uniform,sequential,zipfian]"
+		          << " [--structures skiplist,pooled,arena,hugepages,set,unordered_set,btree] [--ops N] [--scan-keys N] [--seed N]" << std::endl
+		          << "       skiplist_bench --ycsb A,B,C,D,E,F [--structures skiplist,rcu,buffered] [--threads 1,2,4]"
+		          << " [--records N] [--ops N] [--histogram-file PATH] [--seed N]" << std::endl;
+		return 2;
+	}
+	if (!options.ycsb.empty())
+	{
+		try {
+			runAllYcsb(options);
+		}
+		catch (const std::exception & e) {
+			std::cerr << "skiplist_bench: " << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+
+	std::cout << "structure,workload,distribution,size,ops,seconds,ops_per_sec,p50_ns,p90_ns,p99_ns,p999_ns,max_ns,bytes_per_key,"
+	          << "allocs_per_op,alloc_bytes_per_op,dtlb_misses_per_op" << std::endl;
+	try {
+		for (auto size : options.sizes)
+			for (const auto & distribution : options.distributions)
+				for (const auto & structure : options.structures)
+				{
+					if (structure == "skiplist")
+						benchmark<SkipListTarget>(options, size, distribution);
+					else if (structure == "pooled")
+						benchmark<PooledSkipListTarget>(options, size, distribution);
+					else if (structure == "arena")
+						benchmark<ArenaSkipListTarget>(options, size, distribution);
+					else if (structure == "hugepages")
+						benchmark<HugePageSkipListTarget>(options, size, distribution);
+					else if (structure == "set")
+						benchmark<SetTarget>(options, size, distribution);
+					else if (structure == "unordered_set")
+						benchmark<UnorderedSetTarget>(options, size, distribution);
+					else
+						benchmark<BPlusTreeTarget>(options, size, distribution);
+				}
+	}
+	catch (const std::exception & e) {
+		std::cerr << "skiplist_bench: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,388 @@
+// skiplist_buffered.h
+// 18 Oct 2026
+//
+// Header for class BufferedSkipList
+// A write-combining layer over class SkipList: each thread inserts into its own small sorted
+// buffer and a background thread merges the buffers into the shared list in batches.
+// Requires skiplist.h
+
+#ifndef FILE_SKIPLIST_BUFFERED_H_INCLUDED
+#define FILE_SKIPLIST_BUFFERED_H_INCLUDED
+
+#include "skiplist.h"			// for class SkipList
+#include <mutex>				// for std::mutex, std::lock_guard, std::unique_lock
+#include <condition_variable>	// for std::condition_variable
+#include <thread>				// for std::thread, std::this_thread::get_id
+#include <atomic>				// for std::atomic
+#include <chrono>				// for std::chrono::milliseconds
+#include <vector>				// for std::vector
+#include <algorithm>			// for std::lower_bound, std::upper_bound, std::binary_search, std::merge, std::inplace_merge
+#include <iterator>				// for std::back_inserter
+#include <memory>				// for std::shared_ptr, std::make_shared
+#include <string>				// for std::string
+#include <stdexcept>			// for std::runtime_error
+
+// class BufferedSkipList
+// Sorted multiset of ints for bursty multi-threaded ingest.
+// insert only touches the calling thread's WriteBuffer, so writers no longer fight over the
+// upper-level predecessors in SkipList::insert. The merger thread drains every buffer into _list
+// with SkipList::insertBatch when a buffer fills up and at least every mergeInterval.
+//
+// A thread always sees its own writes. Keys buffered by other threads become visible once merged;
+// call flush() to merge everything immediately. A merge that fails puts its keys back in their
+// buffer, so no write is lost; a failure in the merger thread is reported by the next insert or
+// flush, on whichever thread calls it first, and the merger tries again at its next interval.
+//
+// Invariants:
+//		Every key inserted and not removed is in _list or in exactly one WriteBuffer
+//		Each WriteBuffer's _keys is sorted
+//		Lock order is _listMutex, then _buffersMutex or a WriteBuffer's _mutex, never both
+class BufferedSkipList {
+// ***** BufferedSkipList: Types *****
+private:
+	// struct WriteBuffer
+	// One thread's keys that have not been merged yet.
+	struct WriteBuffer {
+		std::mutex _mutex;
+		std::vector<int> _keys;
+		std::thread::id _owner;
+	};
+
+// ***** BufferedSkipList: Data Members *****
+private:
+	SkipList _list;
+	std::mutex _listMutex;
+	std::vector<std::shared_ptr<WriteBuffer>> _buffers;
+	std::mutex _buffersMutex;				// Guards _buffers, _stopping, _mergeRequested and _mergeError
+	std::condition_variable _mergeWanted;
+	bool _stopping;
+	bool _mergeRequested;
+	std::atomic<bool> _mergeFailed;			// _mergeError is set; lets insert check without a lock
+	std::string _mergeError;				// Why the merger thread's last merge failed, not yet reported
+	std::size_t _bufferCapacity;
+	std::chrono::milliseconds _mergeInterval;
+	unsigned long long _id;					// Distinguishes this list in each thread's buffer cache
+	std::thread _merger;
+
+// ***** BufferedSkipList: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Creates an empty list and starts the merger thread.
+	//
+	// Preconditions: bufferCapacity > 0
+	// Postconditions: An empty list with a running merger
+	// Exceptions: Throws if SkipList() or std::thread throws
+	// Strong Guarantee, Exception Neutral
+	explicit BufferedSkipList(std::size_t bufferCapacity = 64,
+	                          std::chrono::milliseconds mergeInterval = std::chrono::milliseconds(10))
+		: _stopping(false), _mergeRequested(false), _mergeFailed(false),
+		  _bufferCapacity(bufferCapacity), _mergeInterval(mergeInterval), _id(nextId())
+	{
+		_merger = std::thread(&BufferedSkipList::runMerger, this);
+	}
+
+	BufferedSkipList(const BufferedSkipList & other) = delete;
+	BufferedSkipList & operator=(const BufferedSkipList & other) = delete;
+
+	// Destructor
+	// Stops the merger thread after a final merge.
+	//
+	// Preconditions: No other thread is using the list
+	// No-Throw Guarantee
+	~BufferedSkipList()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			_stopping = true;
+		}
+		_mergeWanted.notify_one();
+		_merger.join();
+	}
+
+// ***** BufferedSkipList: Public Member Functions *****
+public:
+	// insert
+	// Adds a key to the calling thread's buffer and wakes the merger when the buffer is full.
+	// A thread that gets far ahead of the merger merges its own buffer instead of growing it.
+	//
+	// Preconditions: None
+	// Exceptions:
+	//		Throws std::runtime_error, without inserting key, if a merge by the merger thread failed
+	//		Throws if std::vector or SkipList::insertBatch throws; key is then buffered
+	// Basic Guarantee, Exception Neutral
+	void insert(int key)
+	{
+		throwMergeError();
+		WriteBuffer & buffer = localBuffer();
+		std::size_t size;
+		{
+			std::lock_guard<std::mutex> lock(buffer._mutex);
+			buffer._keys.insert(std::upper_bound(buffer._keys.begin(), buffer._keys.end(), key), key);
+			size = buffer._keys.size();
+		}
+		if (size >= 4 * _bufferCapacity)
+			mergeBuffer(buffer);
+		else if (size >= _bufferCapacity)
+			requestMerge();
+	}
+
+	// remove
+	// Removes one copy of key: from the calling thread's buffer if it is there, otherwise from
+	// another thread's buffer, otherwise from the list. Other buffers must be checked, or a key
+	// inserted by another thread and not merged yet would come back after this remove.
+	//
+	// Preconditions: None
+	// Postconditions: If a node with _key == key was inserted and not removed, one is removed.
+	// Strong Guarantee, Exception Neutral
+	void remove(int key)
+	{
+		WriteBuffer & ownBuffer = localBuffer();
+		if (eraseFrom(ownBuffer, key))
+			return;
+
+		// Holding _listMutex keeps the merger from moving a key out of a buffer we have not checked yet
+		std::lock_guard<std::mutex> listLock(_listMutex);
+		std::vector<std::shared_ptr<WriteBuffer>> buffers;
+		{
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			buffers = _buffers;
+		}
+		for (auto & buffer : buffers)
+		{
+			if (buffer.get() != &ownBuffer && eraseFrom(*buffer, key))
+				return;
+		}
+		_list.remove(key);
+	}
+
+	// search
+	// Returns true if key is in the calling thread's buffer or in the merged list.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws on this thread's first access
+	// Strong Guarantee, Exception Neutral
+	bool search(int key)
+	{
+		WriteBuffer & buffer = localBuffer();
+		{
+			std::lock_guard<std::mutex> lock(buffer._mutex);
+			if (std::binary_search(buffer._keys.begin(), buffer._keys.end(), key))
+				return true;
+		}
+		// A merge that took our key out of the buffer holds _listMutex until the key is linked
+		std::lock_guard<std::mutex> lock(_listMutex);
+		return static_cast<bool>(_list.search(key));
+	}
+
+	// range
+	// Returns the merged keys in [lowKey, highKey] together with the calling thread's buffered keys,
+	// in sorted order.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<int> range(int lowKey, int highKey)
+	{
+		WriteBuffer & buffer = localBuffer();
+		std::lock_guard<std::mutex> listLock(_listMutex);
+		std::lock_guard<std::mutex> bufferLock(buffer._mutex);
+		std::vector<int> merged = _list.range(lowKey, highKey);
+		std::vector<int> result;
+		result.reserve(merged.size());
+		std::merge(merged.begin(), merged.end(),
+		           std::lower_bound(buffer._keys.begin(), buffer._keys.end(), lowKey),
+		           std::upper_bound(buffer._keys.begin(), buffer._keys.end(), highKey),
+		           std::back_inserter(result));
+		return result;
+	}
+
+	// flush
+	// Merges every thread's buffer into the list before returning.
+	//
+	// Preconditions: None
+	// Exceptions:
+	//		Throws std::runtime_error if a merge by the merger thread failed
+	//		Throws if std::vector or SkipList::insertBatch throws; the keys not merged stay buffered
+	// Basic Guarantee, Exception Neutral
+	void flush()
+	{
+		throwMergeError();
+		mergeAll();
+	}
+
+// ***** BufferedSkipList: Private Member Functions *****
+private:
+	// mergeAll
+	// Merges every thread's buffer into the list.
+	//
+	// Exceptions: Throws if std::vector or SkipList::insertBatch throws
+	// Basic Guarantee, Exception Neutral
+	void mergeAll()
+	{
+		std::vector<std::shared_ptr<WriteBuffer>> buffers;
+		{
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			buffers = _buffers;
+		}
+		for (auto & buffer : buffers)
+			mergeBuffer(*buffer);
+	}
+
+	// throwMergeError
+	// Throws the merger thread's unreported failure, if there is one, as reported.
+	//
+	// Exceptions: Throws std::runtime_error if a merge by the merger thread failed
+	// Strong Guarantee
+	void throwMergeError()
+	{
+		if (!_mergeFailed.load(std::memory_order_acquire))
+			return;
+		std::string error;
+		{
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			error.swap(_mergeError);
+			_mergeFailed.store(false, std::memory_order_release);
+		}
+		if (!error.empty())
+			throw std::runtime_error(error);
+	}
+
+	// nextId
+	// Returns a number never returned before, so a thread's cached buffer can't be mistaken
+	// for one belonging to a later list at the same address.
+	//
+	// No-Throw Guarantee
+	static unsigned long long nextId()
+	{
+		static std::atomic<unsigned long long> counter(0);
+		return ++counter;
+	}
+
+	// localBuffer
+	// Returns the calling thread's WriteBuffer for this list, creating it on first use.
+	// The last buffer used is cached per thread so the common case takes no lock.
+	//
+	// Exceptions: Throws if make_shared or std::vector throws
+	// Strong Guarantee, Exception Neutral
+	WriteBuffer & localBuffer()
+	{
+		thread_local unsigned long long cachedId = 0;
+		thread_local WriteBuffer * cachedBuffer = nullptr;
+		if (cachedId == _id)
+			return *cachedBuffer;
+
+		std::lock_guard<std::mutex> lock(_buffersMutex);
+		auto self = std::this_thread::get_id();
+		WriteBuffer * buffer = nullptr;
+		for (auto & candidate : _buffers)
+		{
+			if (candidate->_owner == self)
+				buffer = candidate.get();
+		}
+		if (!buffer)
+		{
+			auto created = std::make_shared<WriteBuffer>();
+			created->_owner = self;
+			created->_keys.reserve(_bufferCapacity);
+			_buffers.push_back(created);
+			buffer = created.get();
+		}
+		cachedId = _id;
+		cachedBuffer = buffer;
+		return *buffer;
+	}
+
+	// eraseFrom
+	// Removes one copy of key from buffer and returns true, or returns false if it has none.
+	//
+	// No-Throw Guarantee
+	static bool eraseFrom(WriteBuffer & buffer, int key)
+	{
+		std::lock_guard<std::mutex> lock(buffer._mutex);
+		auto it = std::lower_bound(buffer._keys.begin(), buffer._keys.end(), key);
+		if (it == buffer._keys.end() || *it != key)
+			return false;
+		buffer._keys.erase(it);
+		return true;
+	}
+
+	// requestMerge
+	// Wakes the merger thread.
+	//
+	// No-Throw Guarantee
+	void requestMerge()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_buffersMutex);
+			_mergeRequested = true;
+		}
+		_mergeWanted.notify_one();
+	}
+
+	// mergeBuffer
+	// Moves buffer's keys into the list in one batch.
+	// _listMutex is held from taking the keys until they are linked, so a reader that misses a key
+	// in the buffer finds it in the list. If the batch fails the keys go back into the buffer,
+	// merged with any its owner added meanwhile. The owner adds at most 4 * _bufferCapacity before
+	// it waits for _listMutex itself, so keys is given room for those up front, and putting the
+	// keys back allocates nothing and cannot fail.
+	//
+	// Exceptions: Throws if std::vector or SkipList::insertBatch throws; buffer then holds its keys
+	// Strong Guarantee, Exception Neutral
+	void mergeBuffer(WriteBuffer & buffer)
+	{
+		std::vector<int> keys;
+		std::lock_guard<std::mutex> listLock(_listMutex);
+		{
+			std::lock_guard<std::mutex> bufferLock(buffer._mutex);
+			if (buffer._keys.empty())
+				return;
+			keys.reserve(buffer._keys.size() + 4 * _bufferCapacity);
+			keys.assign(buffer._keys.begin(), buffer._keys.end());
+			buffer._keys.clear();
+		}
+		try {
+			_list.insertBatch(keys);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> bufferLock(buffer._mutex);
+			std::size_t taken = keys.size();
+			keys.insert(keys.end(), buffer._keys.begin(), buffer._keys.end());
+			std::inplace_merge(keys.begin(), keys.begin() + taken, keys.end());
+			buffer._keys.swap(keys);
+			throw;
+		}
+	}
+
+	// runMerger
+	// Body of the merger thread: merges all buffers whenever asked or every _mergeInterval,
+	// and once more before stopping.
+	//
+	// No-Throw Guarantee
+	void runMerger()
+	{
+		while (true)
+		{
+			bool stopping;
+			{
+				std::unique_lock<std::mutex> lock(_buffersMutex);
+				_mergeWanted.wait_for(lock, _mergeInterval, [this]() { return _stopping || _mergeRequested; });
+				_mergeRequested = false;
+				stopping = _stopping;
+			}
+			try {
+				mergeAll();
+			}
+			catch (std::exception & e) {
+				// The keys are back in their buffers; report the failure and try again later
+				std::lock_guard<std::mutex> lock(_buffersMutex);
+				_mergeError = std::string("BufferedSkipList: merge failed: ") + e.what();
+				_mergeFailed.store(true, std::memory_order_release);
+			}
+			if (stopping)
+				return;
+		}
+	}
+};
+
+#endif // #ifndef FILE_SKIPLIST_BUFFERED_H_INCLUDED
@@ -0,0 +1,395 @@
+// skiplist_checkpoint.h
+// 18 Oct 2026
+//
+// Header for class CheckpointedSkipList
+// A SkipList checkpointed to a directory incrementally: each checkpoint writes only the keys
+// changed since the previous one, so its cost follows the rate of change, not the size of the list.
+// Requires skiplist.h and a POSIX system (open, fsync, rename, unlink, opendir)
+
+#ifndef FILE_SKIPLIST_CHECKPOINT_H_INCLUDED
+#define FILE_SKIPLIST_CHECKPOINT_H_INCLUDED
+
+#include "skiplist.h"			// for class SkipList, struct DurableFile
+#include <string>				// for std::string
+#include <vector>				// for std::vector
+#include <set>					// for std::set
+#include <map>					// for std::map
+#include <utility>				// for std::pair
+#include <mutex>				// for std::mutex, std::lock_guard
+#include <algorithm>			// for std::sort
+#include <stdexcept>			// for std::runtime_error
+#include <fstream>				// for std::ifstream
+#include <iterator>				// for std::istreambuf_iterator
+#include <cstring>				// for std::strerror, std::memcmp
+#include <cstdint>				// for std::uint32_t, std::uint64_t
+#include <cstdio>				// for std::snprintf, std::sscanf
+#include <cerrno>				// for errno
+#include <unistd.h>				// for unlink
+#include <dirent.h>				// for opendir, readdir, closedir
+#include <sys/stat.h>			// for mkdir
+
+// class CheckpointedSkipList
+// A SkipList, safe to use from several threads like DurableSkipList, that is checkpointed to
+// a directory incrementally.
+//
+// The directory holds a base file, base-N.skpl in the format of SkipList::save, and delta files
+// delta-M.ckpt for M > N. Every insert and remove adds its key to a dirty set. checkpoint() takes
+// the set and records how many copies of each dirty key the list holds, under the list lock, which
+// costs time in proportion to the keys changed; it then writes them to the next delta file without
+// the lock, so writers never wait for I/O. Opening the directory loads the newest base and applies
+// the deltas after it in order.
+//
+// Once the deltas hold ConsolidateEntries entries and more than half as many as the base, or there are
+// MaxDeltas of them, checkpoint folds them into a new base. That streams the old base and merges
+// the deltas in, again without the list lock. It happens only after changes amounting to half
+// the list, so the cost per change stays constant.
+//
+// Every file is written with DurableFile::replace: under a temporary name, synced, renamed and
+// the directory synced. A new base is durably in place before the files it replaces are deleted,
+// and opening deletes bases and deltas that a newer base covers, and temporary files a crash left
+// behind, so a crash at any point leaves the last completed checkpoint. A consolidation that fails
+// leaves the deltas as they were, and the next checkpoint tries again.
+//
+// Delta file layout, little-endian: "SKCK", version (uint32), entry count (uint64), then for each
+// changed key, in increasing order: key (int32) and the number of copies present (uint32).
+//
+// Invariants:
+//		Loading base _baseNumber and applying deltas _baseNumber + 1 through _lastDelta gives _list,
+//		except for the keys in _dirty
+//		_baseKeys is the key count of base _baseNumber, 0 if _baseNumber is 0 (no base yet)
+//		_deltaEntries is the number of entries in deltas _baseNumber + 1 through _lastDelta
+//		Lock order is _checkpointMutex, then _listMutex
+class CheckpointedSkipList {
+// ***** CheckpointedSkipList: Constants *****
+public:
+	static const unsigned long long MaxDeltas = 16;
+	static const unsigned long long ConsolidateEntries = 4096;
+
+private:
+	static const std::uint32_t DeltaFormatVersion = 1;
+	static const std::size_t DeltaHeaderBytes = 16;
+	static const std::size_t DeltaEntryBytes = 8;
+
+// ***** CheckpointedSkipList: Data Members *****
+private:
+	std::string _directory;
+	SkipList _list;
+	std::set<int> _dirty;
+	std::mutex _listMutex;				// Guards _list and _dirty
+	std::mutex _checkpointMutex;		// Guards the rest; held for a whole checkpoint
+	unsigned long long _baseNumber;
+	unsigned long long _lastDelta;
+	unsigned long long _baseKeys;
+	unsigned long long _deltaEntries;
+
+// ***** CheckpointedSkipList: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Restores the list from the last checkpoint in directory, creating the directory if needed,
+	// and deletes files left over from a consolidation or a file write that a crash interrupted.
+	//
+	// Preconditions: No other CheckpointedSkipList uses directory
+	// Exceptions: Throws std::runtime_error if the directory or a checkpoint file cannot be read
+	// Strong Guarantee, Exception Neutral
+	explicit CheckpointedSkipList(const std::string & directory)
+		: _directory(directory), _baseNumber(0), _lastDelta(0), _baseKeys(0), _deltaEntries(0)
+	{
+		if (::mkdir(directory.c_str(), 0755) == 0)
+			DurableFile::syncDirectory(directory);
+		DIR * listing = ::opendir(directory.c_str());
+		if (!listing)
+			throw std::runtime_error("CheckpointedSkipList: cannot open " + directory + ": " + std::strerror(errno));
+		std::vector<unsigned long long> bases;
+		std::vector<unsigned long long> deltas;
+		std::vector<std::string> temporaries;
+		while (dirent * entry = ::readdir(listing))
+		{
+			unsigned long long number;
+			int end = 0;
+			if ((std::sscanf(entry->d_name, "base-%llu.skpl%n", &number, &end) == 1 && end > 0) ||
+			    (std::sscanf(entry->d_name, "delta-%llu.ckpt%n", &number, &end) == 1 && end > 0))
+			{
+				const char * suffix = entry->d_name + end;
+				if (!*suffix)
+					(entry->d_name[0] == 'b' ? bases : deltas).push_back(number);
+				else if (DurableFile::temporaryPath("") == suffix)
+					temporaries.push_back(_directory + "/" + entry->d_name);
+			}
+		}
+		::closedir(listing);
+		std::sort(bases.begin(), bases.end());
+		std::sort(deltas.begin(), deltas.end());
+
+		if (!bases.empty())
+		{
+			_baseNumber = bases.back();
+			SkipList::Builder builder(_list);
+			_baseKeys = SkipList::readSaved(basePath(_baseNumber), [&builder](int key) { builder.append(key); });
+		}
+		_lastDelta = _baseNumber;
+		for (auto number : deltas)
+		{
+			if (number <= _baseNumber)
+				continue;
+			if (number != _lastDelta + 1)
+				throw std::runtime_error("CheckpointedSkipList: " + deltaPath(_lastDelta + 1) + " is missing");
+			readDelta(deltaPath(number), [this](int key, std::uint32_t count) {
+				setCount(key, count);
+				_deltaEntries++;
+			});
+			_lastDelta = number;
+		}
+
+		for (std::size_t i = 0; i + 1 < bases.size(); i++)
+			::unlink(basePath(bases[i]).c_str());
+		for (auto number : deltas)
+			if (number <= _baseNumber)
+				::unlink(deltaPath(number).c_str());
+		for (auto & path : temporaries)
+			::unlink(path.c_str());
+	}
+
+	CheckpointedSkipList(const CheckpointedSkipList & other) = delete;
+	CheckpointedSkipList & operator=(const CheckpointedSkipList & other) = delete;
+
+	~CheckpointedSkipList() = default;
+
+// ***** CheckpointedSkipList: Public Member Functions *****
+public:
+	// insert, remove
+	// Apply the operation to the list and mark key as changed since the last checkpoint.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if SkipList or std::set throws
+	// Basic Guarantee, Exception Neutral
+	void insert(int key)
+	{
+		std::lock_guard<std::mutex> lock(_listMutex);
+		_dirty.insert(key);
+		_list.insert(key);
+	}
+
+	void remove(int key)
+	{
+		std::lock_guard<std::mutex> lock(_listMutex);
+		_dirty.insert(key);
+		_list.remove(key);
+	}
+
+	// search
+	// Returns true if key is in the list.
+	//
+	// Preconditions: None
+	// No-Throw Guarantee
+	bool search(int key)
+	{
+		std::lock_guard<std::mutex> lock(_listMutex);
+		return static_cast<bool>(_list.search(key));
+	}
+
+	// range
+	// Returns the keys in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<int> range(int lowKey, int highKey)
+	{
+		std::lock_guard<std::mutex> lock(_listMutex);
+		return _list.range(lowKey, highKey);
+	}
+
+	// checkpoint
+	// Makes every change made so far durable by writing the changed keys to a new delta file,
+	// folding the deltas into a new base once they are large, and returns the number of keys written
+	// to the delta. Writers are held up only while the changed keys are counted, not during I/O.
+	// The changes are durable once the delta is written, so a failure to fold the deltas is not
+	// reported: they stay as they are and the next checkpoint folds them.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the delta cannot be written; the changes are kept for
+	//             the next checkpoint
+	// Basic Guarantee, Exception Neutral
+	unsigned long long checkpoint()
+	{
+		std::lock_guard<std::mutex> checkpointLock(_checkpointMutex);
+		std::vector<std::pair<int, std::uint32_t>> changes;
+		{
+			std::lock_guard<std::mutex> lock(_listMutex);
+			changes.reserve(_dirty.size());
+			for (int key : _dirty)
+			{
+				std::uint32_t count = 0;
+				_list.scan(key, key, [&count](int) { count++; });
+				changes.emplace_back(key, count);
+			}
+			_dirty.clear();
+		}
+		if (changes.empty())
+			return 0;
+
+		try {
+			writeDelta(deltaPath(_lastDelta + 1), changes);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(_listMutex);
+			for (auto & change : changes)
+				_dirty.insert(change.first);
+			throw;
+		}
+		_lastDelta++;
+		_deltaEntries += changes.size();
+
+		if (_lastDelta - _baseNumber >= MaxDeltas ||
+		    (_deltaEntries >= ConsolidateEntries && _deltaEntries > _baseKeys / 2))
+		{
+			try {
+				consolidate();
+			}
+			catch (...) {
+				// Strong Guarantee: the deltas are still in place and the next checkpoint retries
+			}
+		}
+		return changes.size();
+	}
+
+	// dirtyCount, deltaCount
+	// Number of keys changed since the last checkpoint, and of delta files on top of the base.
+	//
+	// No-Throw Guarantee
+	std::size_t dirtyCount()
+	{
+		std::lock_guard<std::mutex> lock(_listMutex);
+		return _dirty.size();
+	}
+
+	unsigned long long deltaCount()
+	{
+		std::lock_guard<std::mutex> lock(_checkpointMutex);
+		return _lastDelta - _baseNumber;
+	}
+
+// ***** CheckpointedSkipList: Private Member Functions *****
+private:
+	// basePath, deltaPath
+	// Return the paths of the base and delta files with the given number.
+	//
+	// Exceptions: Throws if std::string throws
+	std::string basePath(unsigned long long number) const
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "base-%08llu.skpl", number);
+		return _directory + "/" + name;
+	}
+
+	std::string deltaPath(unsigned long long number) const
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "delta-%08llu.ckpt", number);
+		return _directory + "/" + name;
+	}
+
+	// setCount
+	// Makes the list hold exactly count copies of key.
+	//
+	// Preconditions: Caller has _list to itself
+	// Exceptions: Throws if SkipList::insert throws
+	// Basic Guarantee, Exception Neutral
+	void setCount(int key, std::uint32_t count)
+	{
+		while (_list.search(key))
+			_list.remove(key);
+		for (std::uint32_t i = 0; i < count; i++)
+			_list.insert(key);
+	}
+
+	// consolidate
+	// Writes base _lastDelta by merging base _baseNumber with the deltas after it, in one pass
+	// over the old base, then deletes the files it replaces.
+	//
+	// Preconditions: Caller holds _checkpointMutex
+	// Exceptions: Throws std::runtime_error if a file cannot be read or written
+	// Strong Guarantee, Exception Neutral
+	void consolidate()
+	{
+		std::map<int, std::uint32_t> changes;
+		for (unsigned long long number = _baseNumber + 1; number <= _lastDelta; number++)
+			readDelta(deltaPath(number), [&changes](int key, std::uint32_t count) { changes[key] = count; });
+
+		const std::string path = basePath(_lastDelta);
+		unsigned long long keys = SkipList::writeSaved(path, [&](auto emit) {
+			auto change = changes.begin();
+			auto emitChangesBefore = [&](int key, bool all) {
+				for (; change != changes.end() && (all || change->first < key); ++change)
+					for (std::uint32_t i = 0; i < change->second; i++)
+						emit(change->first);
+			};
+			if (_baseNumber > 0)
+				SkipList::readSaved(basePath(_baseNumber), [&](int key) {
+					emitChangesBefore(key, false);
+					// Copies of a changed key come from its change, emitted once the merge passes it
+					if (change == changes.end() || change->first != key)
+						emit(key);
+				});
+			emitChangesBefore(0, true);
+		});
+
+		// writeSaved synced the directory, so the new base outlives a crash before the old files go
+		if (_baseNumber > 0)
+			::unlink(basePath(_baseNumber).c_str());
+		for (unsigned long long number = _baseNumber + 1; number <= _lastDelta; number++)
+			::unlink(deltaPath(number).c_str());
+		_baseNumber = _lastDelta;
+		_baseKeys = keys;
+		_deltaEntries = 0;
+	}
+
+	// writeDelta
+	// Writes changes, sorted by key, to a delta file at path.
+	//
+	// Exceptions: Throws std::runtime_error if the file cannot be written
+	// Strong Guarantee, Exception Neutral
+	static void writeDelta(const std::string & path, const std::vector<std::pair<int, std::uint32_t>> & changes)
+	{
+		std::vector<char> bytes;
+		bytes.reserve(DeltaHeaderBytes + changes.size() * DeltaEntryBytes);
+		bytes.insert(bytes.end(), { 'S', 'K', 'C', 'K' });
+		DurableFile::appendLittleEndian(bytes, DeltaFormatVersion, 4);
+		DurableFile::appendLittleEndian(bytes, changes.size(), 8);
+		for (auto & change : changes)
+		{
+			DurableFile::appendLittleEndian(bytes, static_cast<std::uint32_t>(change.first), 4);
+			DurableFile::appendLittleEndian(bytes, change.second, 4);
+		}
+
+		DurableFile::replace(path, "CheckpointedSkipList", [&](int fd) {
+			if (!DurableFile::writeAll(fd, bytes.data(), bytes.size()))
+				throw std::runtime_error("CheckpointedSkipList: cannot write " + path + ": " + std::strerror(errno));
+		});
+	}
+
+	// readDelta
+	// Calls visit(key, count) for each entry of the delta file at path, in key order.
+	//
+	// Exceptions: Throws std::runtime_error if the file cannot be read or is not a delta file;
+	//             throws if visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	static void readDelta(const std::string & path, Visit visit)
+	{
+		std::ifstream in(path, std::ios::binary);
+		if (!in)
+			throw std::runtime_error("CheckpointedSkipList: cannot read " + path);
+		std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (bytes.size() < DeltaHeaderBytes || std::memcmp(bytes.data(), "SKCK", 4) != 0 ||
+		    DurableFile::decodeLittleEndian(&bytes[4], 4) != DeltaFormatVersion ||
+		    (bytes.size() - DeltaHeaderBytes) / DeltaEntryBytes != DurableFile::decodeLittleEndian(&bytes[8], 8) ||
+		    (bytes.size() - DeltaHeaderBytes) % DeltaEntryBytes != 0)
+			throw std::runtime_error("CheckpointedSkipList: " + path + " is not a delta file");
+		for (std::size_t offset = DeltaHeaderBytes; offset < bytes.size(); offset += DeltaEntryBytes)
+			visit(static_cast<int>(static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(&bytes[offset], 4))),
+			      static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(&bytes[offset + 4], 4)));
+	}
+};
+
+#endif // #ifndef FILE_SKIPLIST_CHECKPOINT_H_INCLUDED
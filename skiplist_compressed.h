@@ -0,0 +1,417 @@
+// skiplist_compressed.h
+// 18 Oct 2026
+//
+// Header for class CompressedSkipList
+// A SkipList whose cold key ranges can be frozen into delta-encoded, varint-compressed blocks
+// while hot ranges stay in ordinary nodes, so rarely touched keys cost a byte or two each.
+// Requires skiplist.h
+
+#ifndef FILE_SKIPLIST_COMPRESSED_H_INCLUDED
+#define FILE_SKIPLIST_COMPRESSED_H_INCLUDED
+
+#include "skiplist.h"	// for class SkipList
+#include <vector>		// for std::vector
+#include <algorithm>	// for std::lower_bound, std::merge
+#include <iterator>		// for std::back_inserter
+#include <cstddef>		// for std::size_t
+#include <cstdint>		// for std::uint32_t, std::int64_t
+#include <type_traits>	// for std::is_nothrow_move_constructible
+
+// class CompressedSkipList
+// A sorted multiset of ints held in two tiers. Hot keys live in a SkipList. freeze(lowKey, highKey)
+// moves the hot keys in a range into the cold tier, and thaw(lowKey, highKey) moves cold keys back;
+// the caller decides which ranges are cold, for example from their age or from how often they are read.
+//
+// The cold tier is a vector of blocks in key order, each holding up to BlockKeys keys. A block keeps
+// its first and last key uncompressed, so a search decodes at most the one or two blocks that can
+// hold the key, and stores the gaps between consecutive keys as LEB128 varints: 7 bits a byte, high
+// bit set on every byte but the last. Keys a few apart take one byte each, against the hundreds of
+// bytes of a SkipListNode, and any two ints still differ by less than 2^32, so a gap takes at most
+// five bytes.
+//
+// A key inserted into a frozen range goes to the hot tier and stays there until the range is
+// frozen again; search, scan and range merge the two tiers. Removing a cold key decodes and
+// re-encodes its one block. Like SkipList, a CompressedSkipList is not safe to use from several
+// threads at once.
+//
+// Invariants:
+//		_cold is ordered by key: each block's _lastKey <= the next block's _firstKey
+//		Each block holds 1 to BlockKeys keys, _count of them, the first being _firstKey and the last _lastKey
+//		_hotCount is the number of keys in _hot; _coldCount is the sum of the blocks' _count
+class CompressedSkipList {
+// ***** CompressedSkipList: Constants *****
+public:
+	static const std::size_t BlockKeys = 128;
+
+// ***** CompressedSkipList: Cold Blocks *****
+private:
+	// struct ColdBlock
+	// BlockKeys or fewer sorted keys: the first raw, the rest as varint gaps from the one before.
+	struct ColdBlock {
+		int _firstKey;
+		int _lastKey;
+		std::uint32_t _count;
+		std::vector<unsigned char> _gaps;
+	};
+
+// ***** CompressedSkipList: Data Members *****
+private:
+	SkipList _hot;
+	std::vector<ColdBlock> _cold;
+	std::size_t _hotCount;
+	std::size_t _coldCount;
+
+// ***** CompressedSkipList: Constructors and Destructors *****
+public:
+	// Default Constructor
+	// Creates an empty list with nothing frozen
+	//
+	// Preconditions: None
+	// Exceptions: Throws if SkipList throws
+	// Strong Guarantee, Exception Neutral
+	CompressedSkipList()
+		: _hotCount(0), _coldCount(0)
+	{}
+
+	CompressedSkipList(const CompressedSkipList & other) = delete;
+	CompressedSkipList & operator=(const CompressedSkipList & other) = delete;
+
+	~CompressedSkipList() = default;
+
+// ***** CompressedSkipList: Public Member Functions *****
+public:
+	// insert
+	// Inserts key into the hot tier, whether or not its range is frozen.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if SkipList::insert throws
+	// Strong Guarantee, Exception Neutral
+	void insert(int insertKey)
+	{
+		_hot.insert(insertKey);
+		_hotCount++;
+	}
+
+	// remove
+	// Removes one copy of key, if there is one: from the hot tier if it is there, otherwise from
+	// the cold block that holds it, which is decoded and encoded again.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	void remove(int removeKey)
+	{
+		if (_hot.search(removeKey))
+		{
+			_hot.remove(removeKey);
+			_hotCount--;
+			return;
+		}
+		for (auto block = firstBlock(removeKey); block != _cold.end() && block->_firstKey <= removeKey; ++block)
+		{
+			std::vector<int> keys = decode(*block);
+			auto found = std::lower_bound(keys.begin(), keys.end(), removeKey);
+			if (found == keys.end() || *found != removeKey)
+				continue;
+			keys.erase(found);
+			if (keys.empty())
+				_cold.erase(block);
+			else
+				*block = encode(keys.data(), keys.size());
+			_coldCount--;
+			return;
+		}
+	}
+
+	// search
+	// Returns true if key is in either tier. Decodes only the blocks whose bounds admit key.
+	//
+	// Preconditions: None
+	// Exceptions: None
+	// Strong Guarantee, Exception Neutral
+	bool search(int searchKey)
+	{
+		if (_hot.search(searchKey))
+			return true;
+		for (auto block = firstBlock(searchKey); block != _cold.end() && block->_firstKey <= searchKey; ++block)
+		{
+			bool found = false;
+			forEachKey(*block, [&found, searchKey](int key) {
+				found = found || key == searchKey;
+				return key < searchKey;
+			});
+			if (found)
+				return true;
+		}
+		return false;
+	}
+
+	// scan
+	// Calls visit(key) for every key of both tiers in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: visit does not modify the list
+	// Exceptions: Throws if std::vector or visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit)
+	{
+		std::vector<int> hotKeys = _hot.range(lowKey, highKey);
+		auto hot = hotKeys.begin();
+		for (auto block = firstBlock(lowKey); block != _cold.end() && block->_firstKey <= highKey; ++block)
+			forEachKey(*block, [&](int key) {
+				if (key < lowKey)
+					return true;
+				if (key > highKey)
+					return false;
+				for (; hot != hotKeys.end() && *hot <= key; ++hot)
+					visit(*hot);
+				visit(key);
+				return true;
+			});
+		for (; hot != hotKeys.end(); ++hot)
+			visit(*hot);
+	}
+
+	// range
+	// Returns the keys of both tiers in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<int> range(int lowKey, int highKey)
+	{
+		std::vector<int> result;
+		scan(lowKey, highKey, [&result](int key) { result.push_back(key); });
+		return result;
+	}
+
+	// freeze
+	// Moves the hot keys in [lowKey, highKey] into the cold tier and returns how many moved.
+	// Blocks that overlap the range are decoded, merged with the moved keys and encoded again,
+	// so freezing a range twice packs its keys as tightly as freezing it once. The new blocks are
+	// encoded before any key leaves the hot tier and spliced in after, which cannot fail.
+	//
+	// Preconditions: lowKey <= highKey
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::size_t freeze(int lowKey, int highKey)
+	{
+		std::vector<int> hotKeys = _hot.range(lowKey, highKey);
+		if (hotKeys.empty())
+			return 0;
+
+		// Blocks overlapping [front, back] are rebuilt; all others are kept as they are
+		auto first = firstBlock(hotKeys.front());
+		auto last = first;
+		std::vector<int> coldKeys;
+		for (; last != _cold.end() && last->_firstKey <= hotKeys.back(); ++last)
+			forEachKey(*last, [&coldKeys](int key) { coldKeys.push_back(key); return true; });
+		std::vector<int> keys;
+		keys.reserve(coldKeys.size() + hotKeys.size());
+		std::merge(coldKeys.begin(), coldKeys.end(), hotKeys.begin(), hotKeys.end(), std::back_inserter(keys));
+		std::vector<ColdBlock> blocks = encodeBlocks(keys);
+		std::vector<ColdBlock> cold = reserveBlocks(first, last, blocks);
+
+		// _hot holds no Snapshot, so each remove unlinks its node at once and cannot throw
+		for (int key : hotKeys)
+			_hot.remove(key);
+		_hotCount -= hotKeys.size();
+		replaceBlocks(first, last, blocks, cold);
+		_coldCount += hotKeys.size();
+		return hotKeys.size();
+	}
+
+	// thaw
+	// Moves the cold keys in [lowKey, highKey] back into the hot tier and returns how many moved.
+	// The keys outside the range of any block that straddles a bound stay cold. The blocks that
+	// keep them are encoded before the hot tier is touched and spliced in after, which cannot fail.
+	//
+	// Preconditions: lowKey <= highKey
+	// Exceptions: Throws if std::vector or SkipList::insertBatch throws
+	// Strong Guarantee, Exception Neutral
+	std::size_t thaw(int lowKey, int highKey)
+	{
+		auto first = firstBlock(lowKey);
+		auto last = first;
+		std::vector<int> thawed;
+		std::vector<int> kept;
+		for (; last != _cold.end() && last->_firstKey <= highKey; ++last)
+			forEachKey(*last, [&](int key) {
+				(key < lowKey || key > highKey ? kept : thawed).push_back(key);
+				return true;
+			});
+		if (thawed.empty())
+			return 0;
+		std::vector<ColdBlock> blocks = encodeBlocks(kept);
+		std::vector<ColdBlock> cold = reserveBlocks(first, last, blocks);
+
+		_hot.insertBatch(thawed);
+		_hotCount += thawed.size();
+		replaceBlocks(first, last, blocks, cold);
+		_coldCount -= thawed.size();
+		return thawed.size();
+	}
+
+	// size
+	// Returns the number of keys in both tiers.
+	//
+	// No-Throw Guarantee
+	std::size_t size() const
+	{
+		return _hotCount + _coldCount;
+	}
+
+	// hotCount
+	// Returns the number of keys held in SkipList nodes.
+	//
+	// No-Throw Guarantee
+	std::size_t hotCount() const
+	{
+		return _hotCount;
+	}
+
+	// coldCount
+	// Returns the number of keys held in compressed blocks.
+	//
+	// No-Throw Guarantee
+	std::size_t coldCount() const
+	{
+		return _coldCount;
+	}
+
+	// coldBytes
+	// Returns the memory taken by the cold tier: the blocks themselves and their encoded gaps.
+	//
+	// No-Throw Guarantee
+	std::size_t coldBytes() const
+	{
+		std::size_t bytes = _cold.capacity() * sizeof(ColdBlock);
+		for (const auto & block : _cold)
+			bytes += block._gaps.capacity();
+		return bytes;
+	}
+
+// ***** CompressedSkipList: Private Member Functions *****
+private:
+	// firstBlock
+	// Returns the first block whose last key is at least key: the first that may hold key
+	// or anything after it.
+	//
+	// No-Throw Guarantee
+	std::vector<ColdBlock>::iterator firstBlock(int key)
+	{
+		return std::lower_bound(_cold.begin(), _cold.end(), key,
+		                        [](const ColdBlock & block, int k) { return block._lastKey < k; });
+	}
+
+	// encodeBlocks
+	// Returns blocks encoding keys, which must be sorted, BlockKeys to a block.
+	//
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	static std::vector<ColdBlock> encodeBlocks(const std::vector<int> & keys)
+	{
+		std::vector<ColdBlock> blocks;
+		blocks.reserve((keys.size() + BlockKeys - 1) / BlockKeys);
+		for (std::size_t i = 0; i < keys.size(); i += BlockKeys)
+			blocks.push_back(encode(keys.data() + i, std::min(keys.size() - i, std::size_t(BlockKeys))));
+		return blocks;
+	}
+
+	// reserveBlocks
+	// Returns an empty vector with room for _cold once replaceBlocks has put blocks in place of
+	// [first, last).
+	//
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<ColdBlock> reserveBlocks(std::vector<ColdBlock>::iterator first, std::vector<ColdBlock>::iterator last,
+	                                     const std::vector<ColdBlock> & blocks) const
+	{
+		std::vector<ColdBlock> cold;
+		cold.reserve(_cold.size() - static_cast<std::size_t>(last - first) + blocks.size());
+		return cold;
+	}
+
+	// replaceBlocks
+	// Replaces the blocks [first, last) with blocks, whose keys must fall between the blocks before
+	// first and from last on, building the new _cold in cold, which reserveBlocks sized for it.
+	// Moving a ColdBlock cannot throw and cold never grows, so neither can this.
+	//
+	// No-Throw Guarantee
+	void replaceBlocks(std::vector<ColdBlock>::iterator first, std::vector<ColdBlock>::iterator last,
+	                   std::vector<ColdBlock> & blocks, std::vector<ColdBlock> & cold) noexcept
+	{
+		static_assert(std::is_nothrow_move_constructible<ColdBlock>::value, "ColdBlock moves must not throw");
+		std::move(_cold.begin(), first, std::back_inserter(cold));
+		std::move(blocks.begin(), blocks.end(), std::back_inserter(cold));
+		std::move(last, _cold.end(), std::back_inserter(cold));
+		_cold.swap(cold);
+	}
+
+	// encode
+	// Returns a block holding the count sorted keys at keys.
+	//
+	// Preconditions: 1 <= count <= BlockKeys; keys is sorted
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	static ColdBlock encode(const int * keys, std::size_t count)
+	{
+		ColdBlock block;
+		block._firstKey = keys[0];
+		block._lastKey = keys[count - 1];
+		block._count = static_cast<std::uint32_t>(count);
+		block._gaps.reserve(count - 1);
+		for (std::size_t i = 1; i < count; i++)
+		{
+			auto gap = static_cast<std::uint32_t>(static_cast<std::int64_t>(keys[i]) - keys[i - 1]);
+			for (; gap >= 0x80; gap >>= 7)
+				block._gaps.push_back(static_cast<unsigned char>(gap | 0x80));
+			block._gaps.push_back(static_cast<unsigned char>(gap));
+		}
+		block._gaps.shrink_to_fit();
+		return block;
+	}
+
+	// decode
+	// Returns the keys of block, in order.
+	//
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	static std::vector<int> decode(const ColdBlock & block)
+	{
+		std::vector<int> keys;
+		keys.reserve(block._count);
+		forEachKey(block, [&keys](int key) { keys.push_back(key); return true; });
+		return keys;
+	}
+
+	// forEachKey
+	// Calls visit(key) for the keys of block in order until visit returns false.
+	//
+	// Exceptions: Throws if visit throws
+	// Strong Guarantee, Exception Neutral
+	template <typename Visit>
+	static void forEachKey(const ColdBlock & block, Visit visit)
+	{
+		std::int64_t key = block._firstKey;
+		if (!visit(block._firstKey))
+			return;
+		const unsigned char * gaps = block._gaps.data();
+		for (std::uint32_t i = 1; i < block._count; i++)
+		{
+			std::uint32_t gap = 0;
+			for (int shift = 0; ; shift += 7)
+			{
+				unsigned char byte = *gaps++;
+				gap |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+				if (!(byte & 0x80))
+					break;
+			}
+			key += gap;
+			if (!visit(static_cast<int>(key)))
+				return;
+		}
+	}
+};
+
+#endif // FILE_SKIPLIST_COMPRESSED_H_INCLUDED
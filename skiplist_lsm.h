@@ -0,0 +1,1540 @@
+// skiplist_lsm.h
+// 18 Oct 2026
+//
+// Header for classes Memtable, SortedRun, MergingIterator, RateLimiter and LsmStore
+// Uses SkipList as the in-memory component of a log-structured merge store in the manner of LevelDB:
+// writes go to an active memtable, full memtables are frozen and flushed to sorted run files,
+// range scans merge all of them in one pass, and runs are compacted in the background.
+// Requires skiplist.h, skiplist_pool.h and a POSIX system (open, pread, rename, unlink, opendir)
+
+#ifndef FILE_SKIPLIST_LSM_H_INCLUDED
+#define FILE_SKIPLIST_LSM_H_INCLUDED
+
+#include "skiplist.h"			// for struct SkipListNode, struct DurableFile
+#include "skiplist_pool.h"		// for class ArenaSkipList
+#include <string>				// for std::string
+#include <vector>				// for std::vector
+#include <deque>				// for std::deque
+#include <memory>				// for std::shared_ptr, std::make_shared
+#include <mutex>				// for std::mutex, std::lock_guard, std::unique_lock
+#include <condition_variable>	// for std::condition_variable
+#include <thread>				// for std::thread, std::this_thread::sleep_for
+#include <atomic>				// for std::atomic
+#include <chrono>				// for std::chrono::steady_clock, std::chrono::duration
+#include <algorithm>			// for std::upper_bound, std::sort, std::find, std::make_heap, std::push_heap, std::pop_heap
+#include <utility>				// for std::pair, std::move
+#include <stdexcept>			// for std::runtime_error
+#include <cstring>				// for std::strerror, std::memcmp
+#include <cstdint>				// for std::uint32_t, std::uint64_t
+#include <limits>				// for std::numeric_limits
+#include <cstdio>				// for std::snprintf, std::sscanf
+#include <cerrno>				// for errno
+#include <fcntl.h>				// for open
+#include <unistd.h>				// for pread, close, unlink
+#include <dirent.h>				// for opendir, readdir, closedir
+#include <sys/stat.h>			// for mkdir
+
+// enum class LsmEntry
+// What the newest version of a key says.
+//		Absent:  this source knows nothing about the key
+//		Present: the key was put
+//		Deleted: the key was erased; older sources must not be consulted
+enum class LsmEntry : unsigned char { Absent = 0, Present = 1, Deleted = 2 };
+
+// class LsmCursor
+// Walks the entries of one source of the store, a memtable or a run, in increasing key order.
+// A cursor starts at the first entry of its range; once valid() is false, key, entry and next
+// must not be called.
+class LsmCursor {
+public:
+	virtual ~LsmCursor() {}
+
+	virtual bool valid() const = 0;
+	virtual int key() const = 0;
+	virtual LsmEntry entry() const = 0;
+	virtual void next() = 0;
+};
+
+// class Memtable
+// The in-memory part of the store: one SkipList of present keys and one of tombstones.
+// Each key is in at most one of the two, so the newest write to a key always wins.
+// Both lists keep their nodes in arenas of their own, so a flushed memtable is freed a few
+// slabs at a time rather than node by node, and rotating memtables costs next to nothing.
+//
+// Invariants:
+//		No key is in both _puts and _tombstones, and none is in either twice
+//		_entries is the number of keys in _puts plus _tombstones
+class Memtable {
+// ***** Memtable: Data Members *****
+private:
+	ArenaSkipList _puts;
+	ArenaSkipList _tombstones;
+	std::size_t _entries;
+
+// ***** Memtable: Constructors and Destructors *****
+public:
+	// Default Constructor
+	// Creates an empty memtable.
+	//
+	// Exceptions: Throws if SkipList() throws
+	// Strong Guarantee, Exception Neutral
+	Memtable()
+		: _entries(0)
+	{}
+
+	Memtable(const Memtable & other) = delete;
+	Memtable & operator=(const Memtable & other) = delete;
+
+// ***** Memtable: Cursor *****
+public:
+	// class Memtable::Cursor
+	// Walks the keys and tombstones with key in [lowKey, highKey] by following level 0 of both
+	// lists side by side. The memtable must outlive the cursor and not be modified while it is used.
+	class Cursor : public LsmCursor {
+	private:
+		const SkipListNode * _put;
+		const SkipListNode * _tombstone;
+		const SkipListNode * _current;	// _put or _tombstone, whichever is smaller; null at the end
+		int _highKey;
+
+	public:
+		// Parameterized Constructor
+		// Positions the cursor at the first entry with key >= lowKey.
+		//
+		// No-Throw Guarantee
+		Cursor(const Memtable & memtable, int lowKey, int highKey)
+			: _put(firstAtLeast(memtable._puts, lowKey)), _tombstone(firstAtLeast(memtable._tombstones, lowKey)),
+			  _current(nullptr), _highKey(highKey)
+		{
+			settle();
+		}
+
+		bool valid() const override
+		{
+			return _current != nullptr;
+		}
+
+		int key() const override
+		{
+			return _current->_key;
+		}
+
+		LsmEntry entry() const override
+		{
+			return _current == _put ? LsmEntry::Present : LsmEntry::Deleted;
+		}
+
+		void next() override
+		{
+			if (_current == _put)
+				_put = _put->_forwardNodes[0].get();
+			else
+				_tombstone = _tombstone->_forwardNodes[0].get();
+			settle();
+		}
+
+	private:
+		// settle
+		// Points _current at the smaller of the two list positions still in range.
+		//
+		// No-Throw Guarantee
+		void settle()
+		{
+			bool putLeft = _put->_forwardNodes[0] && _put->_key <= _highKey;
+			bool tombstoneLeft = _tombstone->_forwardNodes[0] && _tombstone->_key <= _highKey;
+			if (putLeft && (!tombstoneLeft || _put->_key < _tombstone->_key))
+				_current = _put;
+			else if (tombstoneLeft)
+				_current = _tombstone;
+			else
+				_current = nullptr;
+		}
+	};
+
+// ***** Memtable: Public Member Functions *****
+public:
+	// put, erase
+	// Record that key is present, or that it has been deleted.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if SkipList::insert throws
+	// Strong Guarantee, Exception Neutral
+	void put(int key)
+	{
+		move(key, _tombstones, _puts);
+	}
+
+	void erase(int key)
+	{
+		move(key, _puts, _tombstones);
+	}
+
+	// lookup
+	// Returns what this memtable says about key.
+	//
+	// Preconditions: None
+	// No-Throw Guarantee
+	LsmEntry lookup(int key)
+	{
+		if (_puts.search(key))
+			return LsmEntry::Present;
+		if (_tombstones.search(key))
+			return LsmEntry::Deleted;
+		return LsmEntry::Absent;
+	}
+
+	// entries, approximateBytes
+	// Number of keys and tombstones held, and the memory they use: the bytes of the nodes in use in
+	// the two arenas, head and tail nodes included. The slabs behind them are not counted, since
+	// they grow NodePool::SlabBytes at a time, far more than a small memtable holds.
+	//
+	// No-Throw Guarantee
+	std::size_t entries() const
+	{
+		return _entries;
+	}
+
+	std::size_t approximateBytes() const
+	{
+		return static_cast<std::size_t>(_puts.allocator().pool().stats().bytesInUse +
+		                                _tombstones.allocator().pool().stats().bytesInUse);
+	}
+
+	// forEach
+	// Calls visit(key, entry) for every key and tombstone with key in [lowKey, highKey], in key order.
+	//
+	// Preconditions: The memtable is not being modified
+	// Exceptions: Throws if visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	void forEach(Visit visit, int lowKey = std::numeric_limits<int>::min(),
+	             int highKey = std::numeric_limits<int>::max()) const
+	{
+		for (Cursor cursor(*this, lowKey, highKey); cursor.valid(); cursor.next())
+			visit(cursor.key(), cursor.entry());
+	}
+
+// ***** Memtable: Private Member Functions *****
+private:
+	// move
+	// Makes key present in to and absent from from.
+	//
+	// Exceptions: Throws if SkipList::insert throws
+	// Strong Guarantee, Exception Neutral
+	void move(int key, ArenaSkipList & from, ArenaSkipList & to)
+	{
+		if (!to.search(key))
+		{
+			to.insert(key);
+			_entries++;
+		}
+		if (from.search(key))
+		{
+			from.remove(key);
+			_entries--;
+		}
+	}
+
+	// firstAtLeast
+	// Returns the first node of list with _key >= key; list's _tail if there is none.
+	//
+	// No-Throw Guarantee
+	static const SkipListNode * firstAtLeast(const ArenaSkipList & list, int key)
+	{
+		const SkipListNode * currentNode = list._head.get();
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			while (currentNode->_forwardNodes[i]->_key < key && currentNode->_forwardNodes[i] != list._tail)
+				currentNode = currentNode->_forwardNodes[i].get();
+		}
+		return currentNode->_forwardNodes[0].get();
+	}
+};
+
+// class SortedRun
+// An immutable run file holding a flushed memtable, and a reader for it.
+//
+// File layout, little-endian:
+//		data blocks: up to BlockEntries entries of key (int32) and LsmEntry (uint8), in key order
+//		index:       for each block, its first key (int32), file offset (uint64) and entry count (uint32)
+//		filter:      Bloom filter bits over every key, tombstones included; may be empty
+//		footer:      index offset (uint64), block count (uint64), entry count (uint64),
+//		             filter bytes (uint32), filter hash count (uint32), "SKRN", version (uint32)
+//
+// The index is sparse, one entry per block, and is kept in memory with the filter, so a lookup reads
+// at most one block, and none for most keys the run does not hold. The filter probes use double
+// hashing as in LevelDB: probe i is bit (h + i * delta) mod the filter size.
+//
+// Invariants:
+//		_fd is open on _path
+//		_index describes every block of the file, in key order
+//		_filter is empty, or has every key of the run set under _filterHashes probes
+class SortedRun {
+// ***** SortedRun: Types and Constants *****
+public:
+	static const std::size_t BlockEntries = 512;
+	static const std::size_t EntryBytes = 5;
+	static const std::size_t IndexEntryBytes = 16;
+	static const std::size_t FooterBytes = 40;
+	static const std::uint32_t FormatVersion = 1;
+	static const unsigned DefaultBitsPerKey = 10;	// About 1% false positives
+
+private:
+	struct BlockHandle {
+		int _firstKey;
+		std::uint64_t _offset;
+		std::uint32_t _count;
+	};
+
+// ***** SortedRun: Data Members *****
+private:
+	std::string _path;
+	int _fd;
+	std::vector<BlockHandle> _index;
+	std::uint64_t _entries;
+	std::vector<unsigned char> _filter;
+	std::uint32_t _filterHashes;
+
+// ***** SortedRun: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Opens the run file at path and loads its index.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the file cannot be read or is not a run file
+	// Strong Guarantee, Exception Neutral
+	explicit SortedRun(const std::string & path)
+		: _path(path), _fd(-1), _entries(0), _filterHashes(0)
+	{
+		_fd = ::open(path.c_str(), O_RDONLY);
+		if (_fd < 0)
+			throw std::runtime_error("SortedRun: cannot open " + path + ": " + std::strerror(errno));
+		try {
+			loadIndex();
+		}
+		catch (...) {
+			::close(_fd);
+			throw;
+		}
+	}
+
+	SortedRun(const SortedRun & other) = delete;
+	SortedRun & operator=(const SortedRun & other) = delete;
+
+	// Destructor
+	// Closes the file.
+	//
+	// No-Throw Guarantee
+	~SortedRun()
+	{
+		::close(_fd);
+	}
+
+// ***** SortedRun: Cursor *****
+public:
+	// class SortedRun::Cursor
+	// Walks the entries with key in [lowKey, highKey], reading one block at a time.
+	// The run must outlive the cursor.
+	class Cursor : public LsmCursor {
+	private:
+		const SortedRun & _run;
+		std::size_t _block;			// Index of the block in _bytes; _run._index.size() at the end
+		std::size_t _position;		// Entry within the block
+		std::vector<char> _bytes;
+		int _highKey;
+		std::uint64_t _bytesRead;
+
+	public:
+		// Parameterized Constructor
+		// Positions the cursor at the first entry with key >= lowKey, reading its block.
+		//
+		// Exceptions: Throws std::runtime_error if the block cannot be read
+		// Strong Guarantee, Exception Neutral
+		Cursor(const SortedRun & run, int lowKey, int highKey)
+			: _run(run), _block(run._index.size()), _position(0), _highKey(highKey), _bytesRead(0)
+		{
+			auto block = _run.findBlock(lowKey);
+			if (block == _run._index.end())
+				block = _run._index.begin();
+			if (block == _run._index.end() || block->_firstKey > highKey)
+				return;
+			_block = static_cast<std::size_t>(block - _run._index.begin());
+			_bytes = _run.readBlock(*block);
+			_bytesRead += _bytes.size();
+			_position = lowerBound(_bytes, block->_count, lowKey);
+			settle();
+		}
+
+		bool valid() const override
+		{
+			return _block < _run._index.size();
+		}
+
+		int key() const override
+		{
+			return keyAt(_bytes, _position);
+		}
+
+		LsmEntry entry() const override
+		{
+			return static_cast<LsmEntry>(_bytes[_position * EntryBytes + 4]);
+		}
+
+		// next
+		// Exceptions: Throws std::runtime_error if the next block cannot be read
+		// Basic Guarantee, Exception Neutral
+		void next() override
+		{
+			++_position;
+			settle();
+		}
+
+		// bytesRead
+		// Returns the number of bytes of blocks read from the file so far.
+		//
+		// No-Throw Guarantee
+		std::uint64_t bytesRead() const
+		{
+			return _bytesRead;
+		}
+
+	private:
+		// settle
+		// Moves on to the next block once this one is used up, and ends the walk past _highKey.
+		//
+		// Exceptions: Throws std::runtime_error if a block cannot be read
+		// Basic Guarantee, Exception Neutral
+		void settle()
+		{
+			const std::size_t blocks = _run._index.size();
+			if (_position == _run._index[_block]._count)
+			{
+				_position = 0;
+				if (++_block < blocks && _run._index[_block]._firstKey <= _highKey)
+				{
+					_bytes = _run.readBlock(_run._index[_block]);
+					_bytesRead += _bytes.size();
+				}
+				else
+					_block = blocks;
+			}
+			if (_block < blocks && keyAt(_bytes, _position) > _highKey)
+				_block = blocks;
+		}
+	};
+
+// ***** SortedRun: Public Member Functions *****
+public:
+	// write
+	// Writes a run file at path from a source that calls visit(key, entry) in key order, with a Bloom
+	// filter of bitsPerKey bits per key, or none if bitsPerKey is 0. The file is written with
+	// DurableFile::replace, so a crash never leaves a partial run under path, and a failed write,
+	// including one thrown by source, leaves no descriptor open and no temporary file behind.
+	//
+	// Preconditions: source visits keys in strictly increasing order
+	// Exceptions: Throws std::runtime_error if the file cannot be written; throws if source throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Source>
+	static void write(const std::string & path, Source source, unsigned bitsPerKey = DefaultBitsPerKey)
+	{
+		DurableFile::replace(path, "SortedRun", [&](int fd) {
+			std::vector<char> block;
+			std::vector<char> index;
+			std::vector<std::uint32_t> hashes;
+			block.reserve(BlockEntries * EntryBytes);
+			std::uint64_t offset = 0;
+			std::uint64_t blocks = 0;
+			std::uint64_t entries = 0;
+			std::uint32_t inBlock = 0;
+			int firstKey = 0;
+
+			auto writeAll = [&](const std::vector<char> & bytes) {
+				if (!DurableFile::writeAll(fd, bytes.data(), bytes.size()))
+					throw std::runtime_error("SortedRun: cannot write " + path + ": " + std::strerror(errno));
+				offset += bytes.size();
+			};
+			auto finishBlock = [&]() {
+				if (inBlock == 0)
+					return;
+				DurableFile::appendLittleEndian(index, static_cast<std::uint32_t>(firstKey), 4);
+				DurableFile::appendLittleEndian(index, offset, 8);
+				DurableFile::appendLittleEndian(index, inBlock, 4);
+				writeAll(block);
+				block.clear();
+				blocks++;
+				inBlock = 0;
+			};
+
+			source([&](int key, LsmEntry entry) {
+				if (inBlock == 0)
+					firstKey = key;
+				DurableFile::appendLittleEndian(block, static_cast<std::uint32_t>(key), 4);
+				block.push_back(static_cast<char>(entry));
+				if (bitsPerKey > 0)
+					hashes.push_back(filterHash(key));
+				entries++;
+				if (++inBlock == BlockEntries)
+					finishBlock();
+			});
+			finishBlock();
+
+			std::uint64_t indexOffset = offset;
+			writeAll(index);
+
+			std::uint32_t filterHashes = 0;
+			std::size_t filterBytes = 0;
+			if (bitsPerKey > 0)
+			{
+				// k = bitsPerKey * ln 2 probes minimises false positives
+				filterHashes = static_cast<std::uint32_t>(bitsPerKey * 69 / 100);
+				filterHashes = filterHashes < 1 ? 1 : filterHashes > 30 ? 30 : filterHashes;
+				std::size_t bits = hashes.size() * bitsPerKey;
+				std::vector<char> filter((bits < 64 ? 64 : bits + 7) / 8);
+				for (std::uint32_t hash : hashes)
+					forEachProbe(hash, filterHashes, filter.size() * 8, [&filter](std::size_t bit) {
+						filter[bit / 8] = static_cast<char>(filter[bit / 8] | (1 << (bit % 8)));
+						return true;
+					});
+				writeAll(filter);
+				filterBytes = filter.size();
+			}
+
+			std::vector<char> footer;
+			DurableFile::appendLittleEndian(footer, indexOffset, 8);
+			DurableFile::appendLittleEndian(footer, blocks, 8);
+			DurableFile::appendLittleEndian(footer, entries, 8);
+			DurableFile::appendLittleEndian(footer, filterBytes, 4);
+			DurableFile::appendLittleEndian(footer, filterHashes, 4);
+			footer.insert(footer.end(), { 'S', 'K', 'R', 'N' });
+			DurableFile::appendLittleEndian(footer, FormatVersion, 4);
+			writeAll(footer);
+		});
+	}
+
+	// lookup
+	// Returns what this run says about key, reading at most one block.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the block cannot be read
+	// Strong Guarantee, Exception Neutral
+	LsmEntry lookup(int key) const
+	{
+		if (!mayContain(key))
+			return LsmEntry::Absent;
+		auto block = findBlock(key);
+		if (block == _index.end())
+			return LsmEntry::Absent;
+
+		std::vector<char> bytes = readBlock(*block);
+		std::size_t position = lowerBound(bytes, block->_count, key);
+		if (position == block->_count || keyAt(bytes, position) != key)
+			return LsmEntry::Absent;
+		return static_cast<LsmEntry>(bytes[position * EntryBytes + 4]);
+	}
+
+	// mayContain
+	// Returns false if the Bloom filter shows that key is not in the run, true otherwise,
+	// including when the run has no filter.
+	//
+	// No-Throw Guarantee
+	bool mayContain(int key) const
+	{
+		if (_filter.empty())
+			return true;
+		return forEachProbe(filterHash(key), _filterHashes, _filter.size() * 8, [this](std::size_t bit) {
+			return (_filter[bit / 8] & (1 << (bit % 8))) != 0;
+		});
+	}
+
+	// path, entries
+	// The file this run reads, and the number of entries in it.
+	//
+	// No-Throw Guarantee
+	const std::string & path() const
+	{
+		return _path;
+	}
+
+	std::uint64_t entries() const
+	{
+		return _entries;
+	}
+
+// ***** SortedRun: Private Member Functions *****
+private:
+	// loadIndex
+	// Reads and checks the footer, then reads the sparse index and the filter.
+	//
+	// Exceptions: Throws std::runtime_error if the file is not a run file
+	// Strong Guarantee, Exception Neutral
+	void loadIndex()
+	{
+		const std::runtime_error notRunFile("SortedRun: " + _path + " is not a run file");
+		struct stat status;
+		if (::fstat(_fd, &status) != 0 || status.st_size < static_cast<off_t>(FooterBytes))
+			throw notRunFile;
+		std::uint64_t size = static_cast<std::uint64_t>(status.st_size);
+		std::vector<char> footer = readAt(size - FooterBytes, FooterBytes);
+		if (std::memcmp(&footer[32], "SKRN", 4) != 0 || DurableFile::decodeLittleEndian(&footer[36], 4) != FormatVersion)
+			throw notRunFile;
+
+		std::uint64_t indexOffset = DurableFile::decodeLittleEndian(&footer[0], 8);
+		std::uint64_t blocks = DurableFile::decodeLittleEndian(&footer[8], 8);
+		_entries = DurableFile::decodeLittleEndian(&footer[16], 8);
+		std::uint64_t filterBytes = DurableFile::decodeLittleEndian(&footer[24], 4);
+		_filterHashes = static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(&footer[28], 4));
+		if (indexOffset > size || blocks > size / IndexEntryBytes ||
+		    indexOffset + blocks * IndexEntryBytes + filterBytes + FooterBytes != size ||
+		    (filterBytes > 0 && (_filterHashes < 1 || _filterHashes > 30)))
+			throw notRunFile;
+
+		std::vector<char> index = readAt(indexOffset, static_cast<std::size_t>(blocks * IndexEntryBytes));
+		_index.reserve(static_cast<std::size_t>(blocks));
+		for (std::uint64_t i = 0; i < blocks; i++)
+		{
+			const char * entry = &index[static_cast<std::size_t>(i * IndexEntryBytes)];
+			BlockHandle handle;
+			handle._firstKey = static_cast<int>(static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(entry, 4)));
+			handle._offset = DurableFile::decodeLittleEndian(entry + 4, 8);
+			handle._count = static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(entry + 12, 4));
+			_index.push_back(handle);
+		}
+
+		std::vector<char> filter = readAt(indexOffset + blocks * IndexEntryBytes, static_cast<std::size_t>(filterBytes));
+		_filter.assign(filter.begin(), filter.end());
+	}
+
+	// findBlock
+	// Returns the block that would hold key: the last whose first key is <= key; _index.end() if none.
+	//
+	// No-Throw Guarantee
+	std::vector<BlockHandle>::const_iterator findBlock(int key) const
+	{
+		auto block = std::upper_bound(_index.begin(), _index.end(), key,
+		                              [](int searchKey, const BlockHandle & handle) { return searchKey < handle._firstKey; });
+		return block == _index.begin() ? _index.end() : block - 1;
+	}
+
+	// readBlock, readAt
+	// Read one data block, or size bytes at offset.
+	//
+	// Exceptions: Throws std::runtime_error if the read fails or comes up short
+	// Strong Guarantee, Exception Neutral
+	std::vector<char> readBlock(const BlockHandle & block) const
+	{
+		return readAt(block._offset, block._count * EntryBytes);
+	}
+
+	std::vector<char> readAt(std::uint64_t offset, std::size_t size) const
+	{
+		std::vector<char> bytes(size);
+		std::size_t done = 0;
+		while (done < size)
+		{
+			ssize_t got = ::pread(_fd, bytes.data() + done, size - done, static_cast<off_t>(offset + done));
+			if (got < 0 && errno == EINTR)
+				continue;
+			if (got <= 0)
+				throw std::runtime_error("SortedRun: cannot read " + _path);
+			done += static_cast<std::size_t>(got);
+		}
+		return bytes;
+	}
+
+	// keyAt
+	// Returns the key of entry i of a block read with readBlock.
+	//
+	// No-Throw Guarantee
+	static int keyAt(const std::vector<char> & block, std::size_t i)
+	{
+		return static_cast<int>(static_cast<std::uint32_t>(DurableFile::decodeLittleEndian(&block[i * EntryBytes], 4)));
+	}
+
+	// lowerBound
+	// Returns the first entry of a block of count entries with key >= key; count if there is none.
+	//
+	// No-Throw Guarantee
+	static std::size_t lowerBound(const std::vector<char> & block, std::size_t count, int key)
+	{
+		std::size_t low = 0;
+		std::size_t high = count;
+		while (low < high)
+		{
+			std::size_t middle = (low + high) / 2;
+			if (keyAt(block, middle) < key)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return low;
+	}
+
+	// filterHash, forEachProbe
+	// The hash of a key for the Bloom filter (the MurmurHash3 finaliser), and the filter bits it sets:
+	// forEachProbe calls probe(bit) for each of hashes bits out of bits, stopping early if probe
+	// returns false, and returns whether every call returned true.
+	//
+	// No-Throw Guarantee if probe does not throw
+	static std::uint32_t filterHash(int key)
+	{
+		std::uint32_t hash = static_cast<std::uint32_t>(key) + 0x9E3779B9u;
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6Bu;
+		hash ^= hash >> 13;
+		hash *= 0xC2B2AE35u;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	template <typename Probe>
+	static bool forEachProbe(std::uint32_t hash, std::uint32_t hashes, std::size_t bits, Probe probe)
+	{
+		const std::uint32_t delta = (hash >> 17) | (hash << 15);
+		for (std::uint32_t i = 0; i < hashes; i++)
+		{
+			if (!probe(static_cast<std::size_t>(hash % bits)))
+				return false;
+			hash += delta;
+		}
+		return true;
+	}
+};
+
+// class MergingIterator
+// Presents several cursors, given newest first, as one ordered view: each key appears once, with the
+// entry of the newest source that has it. Tombstones are returned, so that a caller can tell a deleted
+// key from one never written; LsmStore::scan skips them.
+//
+// The sources are kept in a binary heap ordered by (key, age), so each step costs O(log n) in the
+// number of sources and a range scan is a single streaming pass over all of them.
+//
+// Invariants:
+//		_heap holds the indices of the valid sources other than _current, as a heap on (key, index)
+//		When valid, _sources[_current] holds the smallest key, and no source in _heap holds that key
+class MergingIterator {
+// ***** MergingIterator: Data Members *****
+private:
+	std::vector<std::unique_ptr<LsmCursor>> _sources;
+	std::vector<std::size_t> _heap;
+	std::size_t _current;			// _sources.size() once the view is used up
+
+// ***** MergingIterator: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Positions the view at its smallest key.
+	//
+	// Preconditions: sources are ordered newest first
+	// Exceptions: Throws if std::vector or a cursor throws
+	// Basic Guarantee, Exception Neutral
+	explicit MergingIterator(std::vector<std::unique_ptr<LsmCursor>> sources)
+		: _sources(std::move(sources)), _current(_sources.size())
+	{
+		_heap.reserve(_sources.size());
+		for (std::size_t i = 0; i < _sources.size(); i++)
+			if (_sources[i]->valid())
+				_heap.push_back(i);
+		std::make_heap(_heap.begin(), _heap.end(), laterFirst());
+		settle();
+	}
+
+// ***** MergingIterator: Public Member Functions *****
+public:
+	// valid, key, entry
+	// Whether the view has an entry left, and its key and newest entry.
+	//
+	// Preconditions: valid() for key and entry
+	// No-Throw Guarantee
+	bool valid() const
+	{
+		return _current < _sources.size();
+	}
+
+	int key() const
+	{
+		return _sources[_current]->key();
+	}
+
+	LsmEntry entry() const
+	{
+		return _sources[_current]->entry();
+	}
+
+	// next
+	// Moves to the next key.
+	//
+	// Preconditions: valid()
+	// Exceptions: Throws if a cursor throws
+	// Basic Guarantee, Exception Neutral
+	void next()
+	{
+		advance(_current);
+		settle();
+	}
+
+// ***** MergingIterator: Private Member Functions *****
+private:
+	// struct LaterFirst, laterFirst
+	// Heap order, and a comparator using it: source a comes after source b if its key is larger,
+	// or equal and a is older, so the heap's front is the newest source holding the smallest key.
+	//
+	// No-Throw Guarantee
+	struct LaterFirst {
+		const MergingIterator * _merge;
+
+		bool operator()(std::size_t a, std::size_t b) const
+		{
+			int aKey = _merge->_sources[a]->key();
+			int bKey = _merge->_sources[b]->key();
+			return aKey > bKey || (aKey == bKey && a > b);
+		}
+	};
+
+	LaterFirst laterFirst() const
+	{
+		return LaterFirst{ this };
+	}
+
+	// advance
+	// Moves source on to its next entry and puts it back in the heap if it has one.
+	//
+	// Exceptions: Throws if the cursor throws
+	// Basic Guarantee, Exception Neutral
+	void advance(std::size_t source)
+	{
+		_sources[source]->next();
+		if (_sources[source]->valid())
+		{
+			_heap.push_back(source);
+			std::push_heap(_heap.begin(), _heap.end(), laterFirst());
+		}
+	}
+
+	// settle
+	// Takes the newest source holding the smallest key as _current, and moves every older source
+	// holding that key past it, since its entries are shadowed.
+	//
+	// Exceptions: Throws if a cursor throws
+	// Basic Guarantee, Exception Neutral
+	void settle()
+	{
+		if (_heap.empty())
+		{
+			_current = _sources.size();
+			return;
+		}
+		std::pop_heap(_heap.begin(), _heap.end(), laterFirst());
+		_current = _heap.back();
+		_heap.pop_back();
+		const int key = _sources[_current]->key();
+		while (!_heap.empty() && _sources[_heap.front()]->key() == key)
+		{
+			std::pop_heap(_heap.begin(), _heap.end(), laterFirst());
+			std::size_t shadowed = _heap.back();
+			_heap.pop_back();
+			advance(shadowed);
+		}
+	}
+};
+
+// class RateLimiter
+// A token bucket: acquire(bytes) returns once bytes tokens have accumulated at bytesPerSecond,
+// holding at most one second's worth, so that background I/O is spread out rather than bursty.
+// A rate of 0 means unlimited. Not thread-safe; each limiter belongs to one thread.
+//
+// Invariants:
+//		_tokens <= _bytesPerSecond; it is negative while a caller sleeps off a debt
+class RateLimiter {
+// ***** RateLimiter: Data Members *****
+private:
+	double _bytesPerSecond;
+	double _tokens;
+	std::chrono::steady_clock::time_point _refilled;
+
+// ***** RateLimiter: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Creates an empty bucket.
+	//
+	// No-Throw Guarantee
+	explicit RateLimiter(std::uint64_t bytesPerSecond)
+		: _bytesPerSecond(static_cast<double>(bytesPerSecond)), _tokens(0),
+		  _refilled(std::chrono::steady_clock::now())
+	{}
+
+// ***** RateLimiter: Public Member Functions *****
+public:
+	// acquire
+	// Takes bytes tokens, first sleeping until the bucket would hold them.
+	//
+	// Preconditions: None
+	// No-Throw Guarantee
+	void acquire(std::uint64_t bytes)
+	{
+		if (_bytesPerSecond <= 0)
+			return;
+		auto now = std::chrono::steady_clock::now();
+		_tokens += _bytesPerSecond * std::chrono::duration<double>(now - _refilled).count();
+		if (_tokens > _bytesPerSecond)
+			_tokens = _bytesPerSecond;
+		_refilled = now;
+		_tokens -= static_cast<double>(bytes);
+		if (_tokens < 0)
+			std::this_thread::sleep_for(std::chrono::duration<double>(-_tokens / _bytesPerSecond));
+	}
+};
+
+// class LsmStore
+// A set of ints stored as an active Memtable, frozen Memtables waiting to be flushed, and sorted runs.
+//
+// Writes go to the active memtable under _mutex. When it grows past memtableBytes it is frozen:
+// moved to the front of _frozen and replaced by an empty one, which is a pointer swap, so writers
+// never wait for I/O. The flush thread writes the oldest frozen memtable to a new run file and
+// only then drops it from _frozen. Lookups consult the active memtable, then the frozen ones and
+// then the runs, newest first, and stop at the first that knows the key; a run's Bloom filter
+// usually answers for keys it does not hold without reading a block. Range scans merge all of
+// them with a MergingIterator; only the part of the active memtable in range is copied, under _mutex.
+//
+// Writers stall only if MaxFrozenMemtables memtables are already waiting to be flushed.
+//
+// Compaction is size-tiered: runs fall into tiers by size, each TierRatio times larger than the last,
+// and once CompactionFanIn consecutive runs share a tier the compaction thread merges them into one.
+// The merge keeps only the newest version of each key, and drops tombstones when the oldest run is
+// among its inputs, since nothing older is left for them to hide. It reads runs without _mutex, so
+// lookups never wait for it, and its reads and writes go through a RateLimiter so that it leaves
+// disk bandwidth for them.
+//
+// A flushed run file is named run-N.sst; a merged one is named run-O-N.sst, where O and N are the
+// oldest and newest flush numbers it covers. The merged file is renamed into place before its inputs
+// are removed, so after a crash in between, opening the store deletes runs that another file covers.
+//
+// Invariants:
+//		_frozen and _runs are ordered newest first
+//		Every write is in _active, a memtable in _frozen, or a run in _runs
+//		The flush numbers covered by the runs in _runs are disjoint and decrease along _runs,
+//		and _nextRun is above all of them
+//		Only the flush thread adds to _runs, always at the front; only the compaction thread removes
+class LsmStore {
+// ***** LsmStore: Constants *****
+public:
+	static const std::size_t MaxFrozenMemtables = 4;
+	static const std::size_t CompactionFanIn = 4;
+	static const std::uint64_t TierRatio = 4;
+
+private:
+	// struct CompactionAbandoned
+	// Thrown out of a merge's SortedRun::write when the store begins shutting down, so that
+	// DurableFile::replace discards the partial file instead of publishing it.
+	struct CompactionAbandoned {};
+
+// ***** LsmStore: Data Members *****
+private:
+	std::string _directory;
+	std::size_t _memtableBytes;
+	unsigned _bitsPerKey;
+	std::shared_ptr<Memtable> _active;
+	std::deque<std::shared_ptr<Memtable>> _frozen;
+	std::vector<std::shared_ptr<SortedRun>> _runs;
+	unsigned long long _nextRun;
+	std::mutex _mutex;
+	std::condition_variable _flushWanted;
+	std::condition_variable _flushDone;
+	bool _stopping;
+	std::string _flushError;
+	std::condition_variable _compactionWanted;
+	std::condition_variable _compactionDone;
+	bool _fullCompactionWanted;
+	std::string _compactionError;
+	std::atomic<bool> _abandonCompaction;	// Set with _stopping, read by a merge in progress
+	RateLimiter _compactionLimiter;			// Used only by the compaction thread
+	std::thread _flusher;
+	std::thread _compactor;
+
+// ***** LsmStore: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Opens the store kept in directory, creating the directory if needed and picking up the run
+	// files already in it, less any left behind by an interrupted compaction, and starts the flush
+	// and compaction threads. New runs get Bloom filters of bitsPerKey bits per key, or none if it
+	// is 0. Compaction reads and writes at most compactionBytesPerSecond, or without limit if it is 0.
+	// A memtable is frozen once Memtable::approximateBytes reaches memtableBytes.
+	//
+	// Preconditions: memtableBytes is larger than the four head and tail nodes of an empty memtable
+	// Exceptions: Throws std::runtime_error if the directory or a run file cannot be read
+	// Strong Guarantee, Exception Neutral
+	LsmStore(const std::string & directory, std::size_t memtableBytes,
+	         unsigned bitsPerKey = SortedRun::DefaultBitsPerKey, std::uint64_t compactionBytesPerSecond = 0)
+		: _directory(directory), _memtableBytes(memtableBytes), _bitsPerKey(bitsPerKey),
+		  _active(std::make_shared<Memtable>()), _nextRun(1), _stopping(false), _fullCompactionWanted(false),
+		  _abandonCompaction(false), _compactionLimiter(compactionBytesPerSecond)
+	{
+		if (::mkdir(directory.c_str(), 0755) == 0)
+			DurableFile::syncDirectory(directory);
+		DIR * listing = ::opendir(directory.c_str());
+		if (!listing)
+			throw std::runtime_error("LsmStore: cannot open " + directory + ": " + std::strerror(errno));
+		std::vector<std::pair<unsigned long long, unsigned long long>> files;	// (newest, oldest)
+		while (dirent * entry = ::readdir(listing))
+		{
+			unsigned long long oldest;
+			unsigned long long newest;
+			if (parseRunName(entry->d_name, oldest, newest))
+				files.emplace_back(newest, oldest);
+		}
+		::closedir(listing);
+		std::sort(files.rbegin(), files.rend());
+		for (std::size_t i = 0; i < files.size(); i++)
+		{
+			// Files are sorted by newest number, so a file covering this one comes before it
+			bool covered = false;
+			for (std::size_t j = 0; j < i && !covered; j++)
+				covered = files[j].second <= files[i].second && files[i].first <= files[j].first;
+			if (covered)
+				::unlink(runPath(files[i].second, files[i].first).c_str());
+			else
+				_runs.push_back(std::make_shared<SortedRun>(runPath(files[i].second, files[i].first)));
+		}
+		if (!files.empty())
+			_nextRun = files.front().first + 1;
+
+		_flusher = std::thread(&LsmStore::runFlusher, this);
+		_compactor = std::thread(&LsmStore::runCompactor, this);
+	}
+
+	LsmStore(const LsmStore & other) = delete;
+	LsmStore & operator=(const LsmStore & other) = delete;
+
+	// Destructor
+	// Flushes every memtable, including the active one, and stops the flush and compaction threads,
+	// as close does. A failure cannot be reported from here: if the active memtable cannot be frozen,
+	// or a flush fails, the writes it held are lost. Call close first to learn of it.
+	//
+	// Preconditions: No other thread is using the store
+	// No-Throw Guarantee
+	~LsmStore()
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			if (_active->entries() > 0)
+			{
+				try {
+					freeze();
+				}
+				catch (...) {
+					// Nowhere to report it; close is the way to find out
+				}
+			}
+		}
+		stop();
+	}
+
+// ***** LsmStore: Public Member Functions *****
+public:
+	// put, erase
+	// Record that key is present, or deleted, in the active memtable, freezing it if it is full.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if an earlier flush failed; throws if Memtable throws
+	// Strong Guarantee, Exception Neutral
+	void put(int key)
+	{
+		write(key, false);
+	}
+
+	void erase(int key)
+	{
+		write(key, true);
+	}
+
+	// contains
+	// Returns true if the newest version of key says it is present.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if a run file cannot be read
+	// Strong Guarantee, Exception Neutral
+	bool contains(int key)
+	{
+		std::deque<std::shared_ptr<Memtable>> frozen;
+		std::vector<std::shared_ptr<SortedRun>> runs;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			LsmEntry entry = _active->lookup(key);
+			if (entry != LsmEntry::Absent)
+				return entry == LsmEntry::Present;
+			frozen = _frozen;
+			runs = _runs;
+		}
+		// Frozen memtables and runs never change, so they are read without the lock
+		for (auto & memtable : frozen)
+		{
+			LsmEntry entry = memtable->lookup(key);
+			if (entry != LsmEntry::Absent)
+				return entry == LsmEntry::Present;
+		}
+		for (auto & run : runs)
+		{
+			LsmEntry entry = run->lookup(key);
+			if (entry != LsmEntry::Absent)
+				return entry == LsmEntry::Present;
+		}
+		return false;
+	}
+
+	// scan, range
+	// scan calls visit(key) for every present key in [lowKey, highKey], in key order, merging the
+	// memtables and runs in one pass; range returns those keys.
+	// Writes made during the scan may or may not be seen.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if a run file cannot be read; throws if visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	void scan(Visit visit, int lowKey = std::numeric_limits<int>::min(),
+	          int highKey = std::numeric_limits<int>::max())
+	{
+		std::vector<std::unique_ptr<LsmCursor>> sources;
+		std::deque<std::shared_ptr<Memtable>> frozen;
+		std::vector<std::shared_ptr<SortedRun>> runs;
+		std::unique_ptr<CopiedCursor> active(new CopiedCursor);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_active->forEach([&active](int key, LsmEntry entry) {
+				active->_entries.emplace_back(key, entry);
+			}, lowKey, highKey);
+			frozen = _frozen;
+			runs = _runs;
+		}
+		sources.reserve(1 + frozen.size() + runs.size());
+		sources.push_back(std::move(active));
+		// Frozen memtables and runs never change, and the copies above keep them alive
+		for (auto & memtable : frozen)
+			sources.emplace_back(new Memtable::Cursor(*memtable, lowKey, highKey));
+		for (auto & run : runs)
+			sources.emplace_back(new SortedRun::Cursor(*run, lowKey, highKey));
+
+		for (MergingIterator merged(std::move(sources)); merged.valid(); merged.next())
+			if (merged.entry() == LsmEntry::Present)
+				visit(merged.key());
+	}
+
+	std::vector<int> range(int lowKey, int highKey)
+	{
+		std::vector<int> keys;
+		scan([&keys](int key) { keys.push_back(key); }, lowKey, highKey);
+		return keys;
+	}
+
+	// flush
+	// Freezes the active memtable and waits until every frozen memtable is in a run file.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if a flush fails
+	// Basic Guarantee, Exception Neutral
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (_active->entries() > 0)
+			freeze();
+		_flushDone.wait(lock, [this]() { return _frozen.empty() || !_flushError.empty(); });
+		if (!_flushError.empty())
+			throw std::runtime_error(_flushError);
+	}
+
+	// close
+	// Flushes every memtable, including the active one, then stops the flush and compaction threads,
+	// which stop either way. A compaction in progress is abandoned; its inputs stay as they are.
+	// Unlike the destructor, reports a failure to flush, so the caller knows the writes it held are
+	// not in the store. Nothing but destruction may follow.
+	//
+	// Preconditions: No other thread is using the store
+	// Exceptions: Throws std::runtime_error if a flush fails; throws if freezing the active memtable throws
+	// Basic Guarantee, Exception Neutral
+	void close()
+	{
+		try {
+			flush();
+		}
+		catch (...) {
+			stop();
+			throw;
+		}
+		stop();
+	}
+
+	// compact
+	// Flushes every memtable, then merges every run into one, dropping shadowed versions and all
+	// tombstones, and waits for the merge. Leaves no run at all if nothing is present.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if a flush or a compaction fails
+	// Basic Guarantee, Exception Neutral
+	void compact()
+	{
+		flush();
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (!_compactionError.empty())
+			throw std::runtime_error(_compactionError);
+		_fullCompactionWanted = true;
+		_compactionWanted.notify_all();
+		_compactionDone.wait(lock, [this]() { return !_fullCompactionWanted || !_compactionError.empty(); });
+		if (!_compactionError.empty())
+			throw std::runtime_error(_compactionError);
+	}
+
+	// runCount, frozenCount
+	// Number of run files and of memtables waiting to be flushed.
+	//
+	// No-Throw Guarantee
+	std::size_t runCount()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _runs.size();
+	}
+
+	std::size_t frozenCount()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _frozen.size();
+	}
+
+// ***** LsmStore: Private Types *****
+private:
+	// struct CopiedCursor
+	// Walks entries copied out of the active memtable, which may change while a scan is running.
+	struct CopiedCursor : public LsmCursor {
+		std::vector<std::pair<int, LsmEntry>> _entries;
+		std::size_t _position = 0;
+
+		bool valid() const override
+		{
+			return _position < _entries.size();
+		}
+
+		int key() const override
+		{
+			return _entries[_position].first;
+		}
+
+		LsmEntry entry() const override
+		{
+			return _entries[_position].second;
+		}
+
+		void next() override
+		{
+			++_position;
+		}
+	};
+
+// ***** LsmStore: Private Member Functions *****
+private:
+	// runPath
+	// Returns the path of the run file covering flush numbers oldest through newest.
+	//
+	// Exceptions: Throws if std::string throws
+	std::string runPath(unsigned long long oldest, unsigned long long newest) const
+	{
+		char name[48];
+		if (oldest == newest)
+			std::snprintf(name, sizeof(name), "run-%08llu.sst", newest);
+		else
+			std::snprintf(name, sizeof(name), "run-%08llu-%08llu.sst", oldest, newest);
+		return _directory + "/" + name;
+	}
+
+	// parseRunName
+	// If name is the name of a run file, sets the flush numbers it covers and returns true.
+	//
+	// No-Throw Guarantee
+	static bool parseRunName(const char * name, unsigned long long & oldest, unsigned long long & newest)
+	{
+		int end = 0;
+		if (std::sscanf(name, "run-%llu-%llu.sst%n", &oldest, &newest, &end) == 2 && end > 0 && name[end] == '\0')
+			return oldest <= newest;
+		end = 0;
+		if (std::sscanf(name, "run-%llu.sst%n", &newest, &end) == 1 && end > 0 && name[end] == '\0')
+		{
+			oldest = newest;
+			return true;
+		}
+		return false;
+	}
+
+	// runNumbers
+	// Sets the flush numbers covered by a run of this store.
+	//
+	// No-Throw Guarantee
+	void runNumbers(const SortedRun & run, unsigned long long & oldest, unsigned long long & newest) const
+	{
+		parseRunName(run.path().c_str() + _directory.size() + 1, oldest, newest);
+	}
+
+	// write
+	// Applies a put or erase to the active memtable and freezes it once it is full.
+	//
+	// Exceptions: Throws std::runtime_error if an earlier flush failed; throws if Memtable throws
+	// Strong Guarantee, Exception Neutral
+	void write(int key, bool erase)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (!_flushError.empty())
+			throw std::runtime_error(_flushError);
+		_flushDone.wait(lock, [this]() { return _frozen.size() < MaxFrozenMemtables || !_flushError.empty(); });
+		if (erase)
+			_active->erase(key);
+		else
+			_active->put(key);
+		if (_active->approximateBytes() >= _memtableBytes)
+			freeze();
+	}
+
+	// freeze
+	// Moves the active memtable to _frozen, replaces it with an empty one and wakes the flush thread.
+	//
+	// Preconditions: Caller holds _mutex
+	// Exceptions: Throws if make_shared or std::deque throws
+	// Strong Guarantee, Exception Neutral
+	void freeze()
+	{
+		auto fresh = std::make_shared<Memtable>();
+		_frozen.push_front(_active);
+		_active = fresh;
+		_flushWanted.notify_one();
+	}
+
+	// stop
+	// Stops the flush and compaction threads once the flush thread has written every frozen memtable
+	// it can, abandoning a compaction in progress. Does nothing if they are already stopped.
+	//
+	// Preconditions: No other thread is using the store
+	// No-Throw Guarantee
+	void stop() noexcept
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+			_abandonCompaction = true;
+		}
+		_flushWanted.notify_all();
+		_compactionWanted.notify_all();
+		if (_flusher.joinable())
+			_flusher.join();
+		if (_compactor.joinable())
+			_compactor.join();
+	}
+
+	// runFlusher
+	// Body of the flush thread: writes the oldest frozen memtable to a run file, publishes the run
+	// and only then drops the memtable. Stops once asked and nothing is left to flush.
+	//
+	// No-Throw Guarantee
+	void runFlusher()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true)
+		{
+			_flushWanted.wait(lock, [this]() { return _stopping || !_frozen.empty(); });
+			if (_frozen.empty() || !_flushError.empty())
+				return;
+
+			std::shared_ptr<Memtable> oldest = _frozen.back();
+			unsigned long long number = _nextRun++;
+			std::string path = runPath(number, number);
+			lock.unlock();
+			std::shared_ptr<SortedRun> run;
+			std::string error;
+			try {
+				SortedRun::write(path, [&oldest](auto emit) {
+					oldest->forEach(emit);
+				}, _bitsPerKey);
+				run = std::make_shared<SortedRun>(path);
+			}
+			catch (std::exception & e) {
+				error = e.what();
+			}
+			lock.lock();
+
+			if (run)
+			{
+				_runs.insert(_runs.begin(), run);
+				_frozen.pop_back();
+				_compactionWanted.notify_one();
+			}
+			else
+				_flushError = "LsmStore: flush failed: " + error;
+			_flushDone.notify_all();
+		}
+	}
+
+	// tier
+	// Returns the size tier of a run: 0 below TierRatio blocks, 1 below TierRatio squared, and so on.
+	//
+	// No-Throw Guarantee
+	static std::size_t tier(const SortedRun & run)
+	{
+		std::size_t result = 0;
+		for (std::uint64_t blocks = run.entries() / SortedRun::BlockEntries; blocks >= TierRatio; blocks /= TierRatio)
+			result++;
+		return result;
+	}
+
+	// pickCompaction
+	// Returns the positions [first, last) in _runs of the oldest stretch of at least CompactionFanIn
+	// consecutive runs in the same tier, or of every run if a full compaction is wanted;
+	// first == last if there is nothing to do.
+	//
+	// Preconditions: Caller holds _mutex
+	// No-Throw Guarantee
+	std::pair<std::size_t, std::size_t> pickCompaction() const
+	{
+		if (_fullCompactionWanted)
+			return std::make_pair(std::size_t(0), _runs.size());
+		std::size_t last = _runs.size();
+		while (last > 0)
+		{
+			std::size_t first = last - 1;
+			while (first > 0 && tier(*_runs[first - 1]) == tier(*_runs[last - 1]))
+				first--;
+			if (last - first >= CompactionFanIn)
+				return std::make_pair(first, last);
+			last = first;
+		}
+		return std::make_pair(std::size_t(0), std::size_t(0));
+	}
+
+	// runCompactor
+	// Body of the compaction thread: merges the runs pickCompaction chooses into one, replaces them
+	// in _runs and deletes their files, until asked to stop. A failure is recorded in _compactionError
+	// and ends compaction, leaving the runs as they were.
+	//
+	// No-Throw Guarantee
+	void runCompactor()
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while (true)
+		{
+			std::pair<std::size_t, std::size_t> span;
+			_compactionWanted.wait(lock, [this, &span]() {
+				span = pickCompaction();
+				return _stopping || _fullCompactionWanted || span.first != span.second;
+			});
+			if (_stopping)
+				return;
+			if (span.first == span.second)
+			{
+				// A full compaction of no runs
+				_fullCompactionWanted = false;
+				_compactionDone.notify_all();
+				continue;
+			}
+
+			std::vector<std::shared_ptr<SortedRun>> inputs(_runs.begin() + span.first, _runs.begin() + span.second);
+			bool bottom = span.second == _runs.size();
+			bool full = _fullCompactionWanted;
+			lock.unlock();
+			std::shared_ptr<SortedRun> merged;
+			bool finished = false;
+			std::string error;
+			try {
+				finished = merge(inputs, bottom, merged);
+			}
+			catch (std::exception & e) {
+				error = e.what();
+			}
+			lock.lock();
+
+			if (!error.empty())
+			{
+				_compactionError = "LsmStore: compaction failed: " + error;
+				_compactionDone.notify_all();
+				return;
+			}
+			if (!finished)
+				return;
+			// The flush thread may have added runs at the front meanwhile, but never moves these
+			auto first = std::find(_runs.begin(), _runs.end(), inputs.front());
+			first = _runs.erase(first, first + static_cast<std::ptrdiff_t>(inputs.size()));
+			if (merged)
+				_runs.insert(first, merged);
+			if (full)
+				_fullCompactionWanted = false;
+			_compactionDone.notify_all();
+			lock.unlock();
+			// A merge of one flushed run was renamed over it; merge removed the inputs if merged is null
+			for (auto & input : inputs)
+				if (merged && input->path() != merged->path())
+					::unlink(input->path().c_str());
+			lock.lock();
+		}
+	}
+
+	// merge
+	// Writes the newest version of every key in inputs, newest first, to a run file covering their
+	// flush numbers, dropping tombstones if bottom is true, and opens it as merged; leaves merged
+	// null if nothing is left. Returns false, writing nothing, if the store began shutting down.
+	//
+	// Preconditions: inputs are consecutive runs of _runs, newest first; bottom only if they end _runs
+	// Exceptions: Throws std::runtime_error if a run cannot be read or written
+	// Basic Guarantee, Exception Neutral
+	bool merge(const std::vector<std::shared_ptr<SortedRun>> & inputs, bool bottom,
+	           std::shared_ptr<SortedRun> & merged)
+	{
+		unsigned long long oldest;
+		unsigned long long newest;
+		unsigned long long ignored;
+		runNumbers(*inputs.back(), oldest, ignored);
+		runNumbers(*inputs.front(), ignored, newest);
+		const std::string path = runPath(oldest, newest);
+
+		std::vector<std::unique_ptr<LsmCursor>> sources;
+		std::vector<const SortedRun::Cursor *> cursors;
+		for (auto & input : inputs)
+		{
+			std::unique_ptr<SortedRun::Cursor> cursor(new SortedRun::Cursor(*input, std::numeric_limits<int>::min(),
+			                                                                std::numeric_limits<int>::max()));
+			cursors.push_back(cursor.get());
+			sources.push_back(std::move(cursor));
+		}
+		MergingIterator merging(std::move(sources));
+
+		std::uint64_t written = 0;
+		std::uint64_t charged = 0;
+		auto chargeIo = [&]() {
+			std::uint64_t total = written * SortedRun::EntryBytes;
+			for (auto cursor : cursors)
+				total += cursor->bytesRead();
+			_compactionLimiter.acquire(total - charged);
+			charged = total;
+		};
+		try {
+			SortedRun::write(path, [&](auto emit) {
+				for (; merging.valid(); merging.next())
+				{
+					if (_abandonCompaction.load())
+						throw CompactionAbandoned();
+					if (bottom && merging.entry() == LsmEntry::Deleted)
+						continue;
+					emit(merging.key(), merging.entry());
+					if (++written % SortedRun::BlockEntries == 0)
+						chargeIo();
+				}
+				chargeIo();
+			}, _bitsPerKey);
+		}
+		catch (const CompactionAbandoned &) {
+			// The partial file was removed before it took path, so the inputs are untouched
+			return false;
+		}
+
+		if (written > 0)
+			merged = std::make_shared<SortedRun>(path);
+		else
+		{
+			// Nothing is left, but the empty file must cover the inputs until they are deleted
+			for (auto & input : inputs)
+				::unlink(input->path().c_str());
+			::unlink(path.c_str());
+		}
+		return true;
+	}
+};
+
+#endif // #ifndef FILE_SKIPLIST_LSM_H_INCLUDED
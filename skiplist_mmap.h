@@ -0,0 +1,319 @@
+// skiplist_mmap.h
+// 18 Oct 2026
+//
+// Header for class MappedSkipList
+// A position-independent on-disk skip list that is searched in place through mmap.
+// Requires skiplist.h and a POSIX system (open, mmap)
+
+#ifndef FILE_SKIPLIST_MMAP_H_INCLUDED
+#define FILE_SKIPLIST_MMAP_H_INCLUDED
+
+#include "skiplist.h"	// for class SkipList, struct DurableFile, MaxLevel, NoSequence
+#include <string>		// for std::string
+#include <vector>		// for std::vector
+#include <stdexcept>	// for std::runtime_error
+#include <cstring>		// for std::memcpy, std::strerror
+#include <cstdint>		// for std::uint32_t, std::uint64_t, std::int32_t
+#include <cerrno>		// for errno
+#include <fcntl.h>		// for open, posix_fallocate
+#include <unistd.h>		// for close
+#include <sys/mman.h>	// for mmap, munmap, msync
+#include <sys/stat.h>	// for fstat
+
+// class MappedSkipList
+// Read-only view of a skip list file written by MappedSkipList::write.
+// Nodes refer to each other by 64-bit byte offsets from the start of the file rather than by
+// pointers, so the file is searched exactly as mapped, at any address, by any number of processes
+// sharing one copy in the page cache. Opening costs one mmap call, however large the file.
+//
+// File layout, in host byte order and 8-byte aligned:
+//		header: "SKPM", byte-order mark 0x01020304, node count, file size, offset of the head record
+//		record: key (int32), height (uint32), offsets of the next record on each level (uint64 each)
+// The head record has height MaxLevel. Offset 0 marks the end of a level. Every other offset
+// points further into the file than the record holding it.
+//
+// Opening checks the header and head record only, so that it stays one mmap call; every offset is
+// checked as it is followed, and one that points outside the file or backwards throws.
+//
+// Invariants:
+//		_data points to _size readable bytes holding a valid file
+class MappedSkipList {
+// ***** MappedSkipList: File Format *****
+private:
+	struct Header {
+		char _magic[4];
+		std::uint32_t _byteOrder;
+		std::uint64_t _count;
+		std::uint64_t _fileSize;
+		std::uint64_t _headOffset;
+	};
+
+	struct Record {
+		std::int32_t _key;
+		std::uint32_t _height;
+		// Followed by _height uint64 offsets, one per level
+	};
+
+	static const std::uint32_t ByteOrderMark = 0x01020304;
+
+	// recordSize
+	// Returns the number of bytes taken by a record of the given height.
+	//
+	// No-Throw Guarantee
+	static std::uint64_t recordSize(int height)
+	{
+		return 8 + 8 * static_cast<std::uint64_t>(height);
+	}
+
+// ***** MappedSkipList: Data Members *****
+private:
+	const char * _data;
+	std::uint64_t _size;
+	int _fd;
+
+// ***** MappedSkipList: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Maps the file at path read-only.
+	//
+	// Preconditions: None
+	// Postconditions: The file can be searched
+	// Exceptions: Throws std::runtime_error if the file cannot be mapped, or if its header or head record
+	//		is not that of a mapped skip list
+	// Strong Guarantee, Exception Neutral
+	explicit MappedSkipList(const std::string & path)
+		: _data(nullptr), _size(0), _fd(-1)
+	{
+		_fd = ::open(path.c_str(), O_RDONLY);
+		if (_fd < 0)
+			throw std::runtime_error("MappedSkipList: cannot open " + path + ": " + std::strerror(errno));
+		struct stat status;
+		if (::fstat(_fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header)))
+		{
+			::close(_fd);
+			throw std::runtime_error("MappedSkipList: " + path + " is not a mapped skip list");
+		}
+		_size = static_cast<std::uint64_t>(status.st_size);
+		void * mapping = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+		if (mapping == MAP_FAILED)
+		{
+			::close(_fd);
+			throw std::runtime_error("MappedSkipList: cannot map " + path + ": " + std::strerror(errno));
+		}
+		_data = static_cast<const char *>(mapping);
+
+		const Header * header = reinterpret_cast<const Header *>(_data);
+		if (std::memcmp(header->_magic, "SKPM", 4) != 0 || header->_byteOrder != ByteOrderMark ||
+		    header->_fileSize != _size || header->_headOffset < sizeof(Header) || header->_headOffset % 8 != 0 ||
+		    header->_headOffset > _size || recordSize(MaxLevel) > _size - header->_headOffset ||
+		    reinterpret_cast<const Record *>(_data + header->_headOffset)->_height != MaxLevel)
+		{
+			::munmap(mapping, _size);
+			::close(_fd);
+			throw std::runtime_error("MappedSkipList: " + path + " is not a mapped skip list");
+		}
+	}
+
+	MappedSkipList(const MappedSkipList & other) = delete;
+	MappedSkipList & operator=(const MappedSkipList & other) = delete;
+
+	// Destructor
+	// Unmaps the file.
+	//
+	// No-Throw Guarantee
+	~MappedSkipList()
+	{
+		::munmap(const_cast<char *>(_data), _size);
+		::close(_fd);
+	}
+
+// ***** MappedSkipList: Public Member Functions *****
+public:
+	// write
+	// Writes the keys of list to path in the mapped format, keeping each node's height.
+	// The output file is sized in one pass over level 0, its space reserved with posix_fallocate, so
+	// a full disk is an exception rather than SIGBUS, and filled through a writable mapping in a
+	// second, patching each level's previous record as the next node on that level is placed.
+	// It is built under a temporary name, synced, renamed over path and the directory synced, so
+	// processes that have the old file mapped keep reading it unchanged, a crash never leaves a
+	// half-written file at path, and once write returns the new file survives a crash.
+	//
+	// Preconditions: list is not being modified
+	// Postconditions: path can be opened with MappedSkipList
+	// Exceptions: Throws std::runtime_error if the file cannot be written
+	// Basic Guarantee, Exception Neutral
+	static void write(const SkipList & list, const std::string & path)
+	{
+		std::uint64_t count = 0;
+		std::uint64_t size = sizeof(Header) + recordSize(MaxLevel);
+		for (auto node = list._head->_forwardNodes[0]; node != list._tail; node = node->_forwardNodes[0])
+		{
+			if (node->_endSequence != NoSequence)
+				continue;
+			count++;
+			size += recordSize(nodeHeight(node.get()));
+		}
+
+		DurableFile::replace(path, "MappedSkipList::write", [&](int fd) {
+			auto fail = [&path](const char * what) {
+				throw std::runtime_error(std::string("MappedSkipList::write: cannot ") + what + " " + path + ": " +
+				                         std::strerror(errno));
+			};
+			// reserve the blocks before mapping: a store into a page the disk has no room for raises SIGBUS
+			int reserved = ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+			if (reserved != 0)
+			{
+				errno = reserved;
+				fail("reserve space for");
+			}
+			void * mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+			if (mapping == MAP_FAILED)
+				fail("map");
+			char * data = static_cast<char *>(mapping);
+
+			Header * header = reinterpret_cast<Header *>(data);
+			std::memcpy(header->_magic, "SKPM", 4);
+			header->_byteOrder = ByteOrderMark;
+			header->_count = count;
+			header->_fileSize = size;
+			header->_headOffset = sizeof(Header);
+
+			// lastRecords[i] is the offset of the last record placed on level i; new files are zero-filled,
+			// so levels that are never reached again already end in offset 0
+			std::uint64_t lastRecords[MaxLevel];
+			for (int i = 0; i < MaxLevel; i++)
+				lastRecords[i] = header->_headOffset;
+			Record * head = reinterpret_cast<Record *>(data + header->_headOffset);
+			head->_key = std::numeric_limits<int>::min();
+			head->_height = MaxLevel;
+
+			std::uint64_t offset = header->_headOffset + recordSize(MaxLevel);
+			for (auto node = list._head->_forwardNodes[0]; node != list._tail; node = node->_forwardNodes[0])
+			{
+				if (node->_endSequence != NoSequence)
+					continue;
+				int height = nodeHeight(node.get());
+				Record * record = reinterpret_cast<Record *>(data + offset);
+				record->_key = node->_key;
+				record->_height = static_cast<std::uint32_t>(height);
+				for (int i = 0; i < height; i++)
+				{
+					reinterpret_cast<std::uint64_t *>(data + lastRecords[i] + sizeof(Record))[i] = offset;
+					lastRecords[i] = offset;
+				}
+				offset += recordSize(height);
+			}
+
+			int result = ::msync(mapping, size, MS_SYNC);
+			::munmap(mapping, size);
+			if (result != 0)
+				fail("write");
+		});
+	}
+
+	// size
+	// Returns the number of keys in the file.
+	//
+	// No-Throw Guarantee
+	std::uint64_t size() const
+	{
+		return reinterpret_cast<const Header *>(_data)->_count;
+	}
+
+	// search
+	// Returns true if searchKey is in the file. Touches only the pages on the search path.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the search path holds a corrupt offset
+	// Strong Guarantee, Exception Neutral
+	bool search(int searchKey) const
+	{
+		const Record * found = lowerBound(searchKey);
+		return found && found->_key == searchKey;
+	}
+
+	// scan
+	// Calls visit(key) for every key in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the scan meets a corrupt offset; throws if visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) const
+	{
+		for (const Record * record = lowerBound(lowKey); record && record->_key <= highKey; record = next(record, 0))
+			visit(record->_key);
+	}
+
+	// range
+	// Returns the keys in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<int> range(int lowKey, int highKey) const
+	{
+		std::vector<int> result;
+		scan(lowKey, highKey, [&result](int key) { result.push_back(key); });
+		return result;
+	}
+
+// ***** MappedSkipList: Private Member Functions *****
+private:
+	// nodeHeight
+	// Returns the number of levels a SkipListNode is linked on.
+	//
+	// No-Throw Guarantee
+	static int nodeHeight(const SkipListNode * node)
+	{
+		int height = 0;
+		while (height < MaxLevel && node->_forwardNodes[height])
+			height++;
+		return height;
+	}
+
+	// next
+	// Returns the record after record on the given level, nullptr at the end of the level.
+	// The offset must point forwards to a whole, aligned record that reaches the given level, which also
+	// keeps a corrupt file from sending a search around in circles.
+	//
+	// Preconditions: record is a checked record of this file with _height > level
+	// Exceptions: Throws std::runtime_error if the offset is corrupt
+	// Strong Guarantee, Exception Neutral
+	const Record * next(const Record * record, int level) const
+	{
+		std::uint64_t offset = reinterpret_cast<const std::uint64_t *>(record + 1)[level];
+		if (offset == 0)
+			return nullptr;
+		std::uint64_t from = static_cast<std::uint64_t>(reinterpret_cast<const char *>(record) - _data);
+		if (offset <= from || offset % 8 != 0 || offset > _size || sizeof(Record) > _size - offset)
+			throw std::runtime_error("MappedSkipList: corrupt offset in mapped file");
+		const Record * nextRecord = reinterpret_cast<const Record *>(_data + offset);
+		if (nextRecord->_height <= static_cast<std::uint32_t>(level) || nextRecord->_height > MaxLevel ||
+		    recordSize(static_cast<int>(nextRecord->_height)) > _size - offset)
+			throw std::runtime_error("MappedSkipList: corrupt record in mapped file");
+		return nextRecord;
+	}
+
+	// lowerBound
+	// Returns the first record with _key >= searchKey, nullptr if there is none.
+	//
+	// Exceptions: Throws std::runtime_error if the search path holds a corrupt offset
+	// Strong Guarantee, Exception Neutral
+	const Record * lowerBound(int searchKey) const
+	{
+		const Record * currentRecord =
+			reinterpret_cast<const Record *>(_data + reinterpret_cast<const Header *>(_data)->_headOffset);
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			const Record * nextRecord = next(currentRecord, i);
+			while (nextRecord && nextRecord->_key < searchKey)
+			{
+				currentRecord = nextRecord;
+				nextRecord = next(currentRecord, i);
+			}
+		}
+		return next(currentRecord, 0);
+	}
+};
+
+#endif // #ifndef FILE_SKIPLIST_MMAP_H_INCLUDED
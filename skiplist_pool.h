@@ -0,0 +1,645 @@
+// skiplist_pool.h
+// 18 Oct 2026
+//
+// Header for classes NodePool, PoolAllocator, ArenaAllocator
+// A node pool for BasicSkipList: nodes are carved from large slabs and recycled through free
+// lists, so a list that removes as often as it inserts stops calling the global heap, and
+// an arena mode in which a list's destructor and clear() free all its slabs at once.
+// Slabs may be taken in 2 MB huge pages and bound to a NUMA node.
+// Requires skiplist.h and Linux (mmap, madvise, mbind, getcpu)
+
+#ifndef FILE_SKIPLIST_POOL_H_INCLUDED
+#define FILE_SKIPLIST_POOL_H_INCLUDED
+
+#include "skiplist.h"	// for class BasicSkipList, struct SkipListNode, struct BulkRelease
+#include <vector>		// for std::vector
+#include <memory>		// for std::shared_ptr, std::make_shared, std::unique_ptr
+#include <utility>		// for std::move
+#include <mutex>		// for std::mutex, std::lock_guard
+#include <new>			// for ::operator new, ::operator delete, std::bad_alloc
+#include <cstddef>		// for std::size_t, std::max_align_t
+#include <cstdint>		// for std::uintptr_t
+#include <algorithm>	// for std::max
+#include <sys/mman.h>	// for mmap, munmap, madvise, MAP_HUGETLB, MADV_HUGEPAGE
+#include <sys/syscall.h>	// for SYS_mbind, SYS_getcpu
+#include <unistd.h>		// for syscall
+#include <linux/mempolicy.h>	// for MPOL_BIND
+
+// struct PoolOptions
+// Where a NodePool takes its slabs from. By default they come from the heap, wherever the kernel
+// puts them. With hugePages, each slab is a 2 MB huge page, so a list of 1e8 nodes needs about
+// fifteen thousand TLB entries rather than seven million: an explicit (hugetlbfs) page if the
+// system has one free, otherwise a transparent huge page requested with madvise, otherwise
+// ordinary pages. With numaNode set, the slabs are bound to that node, or with LocalNode to the
+// node of the thread that makes the pool; a list sharded across threads gets its memory next to
+// each shard's owner by having the owner make the shard's allocator.
+struct PoolOptions {
+	static const int AnyNode = -1;
+	static const int LocalNode = -2;
+
+	bool hugePages = false;
+	int numaNode = AnyNode;
+};
+
+// struct PoolStats
+// The memory a NodePool holds and how much of it is in use.
+struct PoolStats {
+	unsigned long long slabs = 0;						// Slabs taken from the heap
+	unsigned long long reservedBytes = 0;				// Bytes in those slabs
+	unsigned long long blocksInUse = 0;					// Blocks handed out and not given back
+	unsigned long long bytesInUse = 0;					// Bytes in those blocks
+	unsigned long long freeBlocks = 0;					// Blocks carved and waiting on a free list
+	unsigned long long hugePageSlabs = 0;				// Slabs in explicit huge pages
+	unsigned long long transparentHugePageSlabs = 0;	// Slabs the kernel was asked to back with huge pages
+	unsigned long long numaBoundSlabs = 0;				// Slabs bound to the pool's NUMA node
+	int numaNode = PoolOptions::AnyNode;				// The node slabs are bound to, or AnyNode
+};
+
+// class NodePool
+// Hands out fixed-size blocks carved from slabs of at least SlabBytes, keeping one free list per
+// block size. A block given back goes on the front of its free list and is the next one handed
+// out, so steady-state insert and remove traffic reuses warm memory and never reaches malloc.
+// Slabs are only returned to the heap when the pool is destroyed, or, for an abandoned pool,
+// when the last block is given back.
+//
+// Every node of a BasicSkipList is the same size, whatever its height, so a list's nodes share one
+// size class; the pool keeps a class per size so that one pool can serve several node types.
+// Slabs come from the heap, or are mapped as PoolOptions asks; a mapping that cannot have huge
+// pages or a NUMA binding still serves, and stats() tells which slabs got them.
+// A mutex guards the free lists: list writers are single-threaded, but the last shared_ptr to a
+// removed node may be dropped on any thread.
+//
+// Invariants:
+//		Each block is in use or on exactly one free list
+//		Each SizeClass's _blockBytes is a multiple of alignof(std::max_align_t)
+class NodePool {
+// ***** NodePool: Types *****
+public:
+	static const std::size_t SlabBytes = 1 << 16;
+	static const std::size_t HugePageBytes = 1 << 21;
+
+private:
+	// struct Slab
+	// Memory carved into blocks, and how to give it back.
+	struct Slab {
+		void * _memory;
+		std::size_t _bytes;
+		bool _mapped;							// From mmap rather than operator new
+	};
+
+	struct FreeBlock {
+		FreeBlock * _next;
+	};
+
+	struct SizeClass {
+		std::size_t _blockBytes;
+		FreeBlock * _free;
+		unsigned long long _freeBlocks;
+		unsigned long long _blocksInUse;
+	};
+
+// ***** NodePool: Data Members *****
+private:
+	mutable std::mutex _mutex;			// Guards everything below
+	std::vector<SizeClass> _classes;
+	std::vector<Slab> _slabs;
+	PoolStats _slabStats;					// The slab counts of stats(); block counts are kept in _classes
+	bool _hugePages;
+	bool _abandoned;						// Delete the pool when the last block comes back
+
+// ***** NodePool: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Creates a pool that holds no memory and takes its slabs as options asks.
+	//
+	// No-Throw Guarantee
+	explicit NodePool(const PoolOptions & options = PoolOptions())
+		: _hugePages(options.hugePages), _abandoned(false)
+	{
+		_slabStats.numaNode = options.numaNode == PoolOptions::LocalNode ? currentNode() : options.numaNode;
+	}
+
+	NodePool(const NodePool & other) = delete;
+	NodePool & operator=(const NodePool & other) = delete;
+
+	// Destructor
+	// Returns every slab to the heap, with any blocks still in use; what they hold is not destroyed.
+	//
+	// Preconditions: Nothing will use a block again
+	// No-Throw Guarantee
+	~NodePool()
+	{
+		for (const auto & slab : _slabs)
+		{
+			if (slab._mapped)
+				::munmap(slab._memory, slab._bytes);
+			else
+				::operator delete(slab._memory);
+		}
+	}
+
+// ***** NodePool: Public Member Functions *****
+public:
+	// allocate
+	// Returns a block of at least bytes bytes, aligned for any type.
+	//
+	// Exceptions: Throws std::bad_alloc if a new slab is needed and cannot be had
+	// Strong Guarantee
+	void * allocate(std::size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		SizeClass & sizeClass = classFor(bytes);
+		if (!sizeClass._free)
+			refill(sizeClass);
+		FreeBlock * block = sizeClass._free;
+		sizeClass._free = block->_next;
+		sizeClass._freeBlocks--;
+		sizeClass._blocksInUse++;
+		return block;
+	}
+
+	// deallocate
+	// Puts block, returned by allocate(bytes), back on the free list for its size.
+	//
+	// No-Throw Guarantee
+	void deallocate(void * block, std::size_t bytes) noexcept
+	{
+		bool last;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			SizeClass * sizeClass = findClass(roundUp(bytes));
+			FreeBlock * freed = static_cast<FreeBlock *>(block);
+			freed->_next = sizeClass->_free;
+			sizeClass->_free = freed;
+			sizeClass->_freeBlocks++;
+			sizeClass->_blocksInUse--;
+			last = _abandoned && !blocksInUse();
+		}
+		if (last)
+			delete this;
+	}
+
+	// abandon
+	// Deletes the pool now if no block is in use, or else once the last block in use is given back,
+	// on whichever thread gives it back. For the owner of a pool that nodes may outlive.
+	//
+	// Preconditions: The pool was made with new; nothing allocates from it again
+	// No-Throw Guarantee
+	void abandon() noexcept
+	{
+		bool unused;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_abandoned = true;
+			unused = !blocksInUse();
+		}
+		if (unused)
+			delete this;
+	}
+
+	// forgetBlocks
+	// Counts every block as given back without touching it, so that the pool can be deleted or
+	// abandoned with everything still in its slabs, as a list that owns the pool does once it has
+	// dropped its nodes without destroying them.
+	//
+	// Preconditions: No block handed out is used or given back again
+	// No-Throw Guarantee
+	void forgetBlocks() noexcept
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (auto & sizeClass : _classes)
+			sizeClass._blocksInUse = 0;
+	}
+
+	// stats
+	// Returns the slabs held and the blocks in use and free, over every size.
+	//
+	// No-Throw Guarantee
+	PoolStats stats() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		PoolStats result = _slabStats;
+		for (const auto & sizeClass : _classes)
+		{
+			result.blocksInUse += sizeClass._blocksInUse;
+			result.bytesInUse += sizeClass._blocksInUse * sizeClass._blockBytes;
+			result.freeBlocks += sizeClass._freeBlocks;
+		}
+		return result;
+	}
+
+	// options
+	// Returns the options the pool takes its slabs with, LocalNode replaced by the node it stood for.
+	//
+	// No-Throw Guarantee
+	PoolOptions options() const
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		PoolOptions result;
+		result.hugePages = _hugePages;
+		result.numaNode = _slabStats.numaNode;
+		return result;
+	}
+
+// ***** NodePool: Private Member Functions *****
+private:
+	static std::size_t roundUp(std::size_t bytes)
+	{
+		const std::size_t alignment = alignof(std::max_align_t);
+		return (std::max(bytes, sizeof(FreeBlock)) + alignment - 1) / alignment * alignment;
+	}
+
+	// findClass
+	// Returns the SizeClass of blocks of blockBytes, or nullptr if there is none. Lists use one
+	// or two sizes, so a linear search beats any map.
+	//
+	// No-Throw Guarantee
+	SizeClass * findClass(std::size_t blockBytes)
+	{
+		for (auto & sizeClass : _classes)
+			if (sizeClass._blockBytes == blockBytes)
+				return &sizeClass;
+		return nullptr;
+	}
+
+	// classFor
+	// Returns the SizeClass for allocations of bytes, adding it if it is new.
+	//
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	SizeClass & classFor(std::size_t bytes)
+	{
+		const std::size_t blockBytes = roundUp(bytes);
+		if (SizeClass * found = findClass(blockBytes))
+			return *found;
+		_classes.push_back(SizeClass{ blockBytes, nullptr, 0, 0 });
+		return _classes.back();
+	}
+
+	// currentNode
+	// Returns the NUMA node of the CPU the calling thread is running on, or AnyNode if it cannot be told.
+	//
+	// No-Throw Guarantee
+	static int currentNode() noexcept
+	{
+		unsigned cpu = 0;
+		unsigned node = 0;
+		if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+			return PoolOptions::AnyNode;
+		return static_cast<int>(node);
+	}
+
+	// newSlab
+	// Returns a new slab of at least bytes bytes. Slabs with neither huge pages nor a NUMA node
+	// come from operator new; the others are mapped, so that they start on a page boundary and
+	// can be given their own memory policy before any page is touched. A transparent huge page is
+	// only possible in a 2 MB aligned range, so that mapping is made 2 MB larger and trimmed.
+	//
+	// Exceptions: Throws std::bad_alloc if the memory cannot be had
+	// Strong Guarantee
+	Slab newSlab(std::size_t bytes)
+	{
+		const int node = _slabStats.numaNode;
+		if (!_hugePages && node < 0)
+			return Slab{ ::operator new(bytes), bytes, false };
+
+		const std::size_t pageBytes = _hugePages ? HugePageBytes : static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+		bytes = (bytes + pageBytes - 1) / pageBytes * pageBytes;
+		void * memory = MAP_FAILED;
+		if (_hugePages)
+		{
+			memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (memory != MAP_FAILED)
+				_slabStats.hugePageSlabs++;
+		}
+		if (memory == MAP_FAILED && _hugePages)
+		{
+			void * mapped = ::mmap(nullptr, bytes + HugePageBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (mapped == MAP_FAILED)
+				throw std::bad_alloc();
+			char * start = static_cast<char *>(mapped);
+			char * aligned = start + (HugePageBytes - reinterpret_cast<std::uintptr_t>(start) % HugePageBytes) % HugePageBytes;
+			if (aligned > start)
+				::munmap(start, static_cast<std::size_t>(aligned - start));
+			::munmap(aligned + bytes, static_cast<std::size_t>(start + HugePageBytes - aligned));
+			memory = aligned;
+			if (::madvise(memory, bytes, MADV_HUGEPAGE) == 0)
+				_slabStats.transparentHugePageSlabs++;
+		}
+		if (memory == MAP_FAILED)
+		{
+			memory = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (memory == MAP_FAILED)
+				throw std::bad_alloc();
+		}
+		if (node >= 0 && node < static_cast<int>(8 * sizeof(unsigned long)))
+		{
+			unsigned long nodeMask = 1UL << node;
+			if (::syscall(SYS_mbind, memory, bytes, MPOL_BIND, &nodeMask, 8 * sizeof(nodeMask) + 1, 0) == 0)
+				_slabStats.numaBoundSlabs++;
+		}
+		return Slab{ memory, bytes, true };
+	}
+
+	// blocksInUse
+	// Returns true if any size class has a block in use.
+	//
+	// Preconditions: Caller holds _mutex
+	// No-Throw Guarantee
+	bool blocksInUse() const noexcept
+	{
+		for (const auto & sizeClass : _classes)
+			if (sizeClass._blocksInUse > 0)
+				return true;
+		return false;
+	}
+
+	// refill
+	// Takes a new slab and carves it into blocks on sizeClass's free list, in address order, so
+	// that nodes allocated one after another sit next to each other.
+	//
+	// Exceptions: Throws std::bad_alloc if the slab cannot be had, or if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	void refill(SizeClass & sizeClass)
+	{
+		_slabs.reserve(_slabs.size() + 1);
+		Slab slab = newSlab(std::max(sizeClass._blockBytes, std::size_t(SlabBytes)));
+		_slabs.push_back(slab);
+		_slabStats.slabs++;
+		_slabStats.reservedBytes += slab._bytes;
+		const std::size_t blocks = slab._bytes / sizeClass._blockBytes;
+		char * memory = static_cast<char *>(slab._memory);
+		for (std::size_t i = blocks; i-- > 0; )
+		{
+			FreeBlock * block = reinterpret_cast<FreeBlock *>(memory + i * sizeClass._blockBytes);
+			block->_next = sizeClass._free;
+			sizeClass._free = block;
+		}
+		sizeClass._freeBlocks += blocks;
+	}
+};
+
+// class PoolAllocator
+// An allocator that takes its memory from a shared NodePool, for BasicSkipList's Allocator
+// parameter. Copies, including the rebound copies that allocate_shared makes, share the pool,
+// and the control block of each node holds one, so the pool lives as long as any of its nodes.
+// Lists made with copies of one PoolAllocator share its pool.
+//
+// Invariants:
+//		_pool is not null
+template <typename T>
+class PoolAllocator {
+	template <typename U> friend class PoolAllocator;
+	static_assert(alignof(T) <= alignof(std::max_align_t), "PoolAllocator: over-aligned types are not supported");
+private:
+	std::shared_ptr<NodePool> _pool;
+
+public:
+	typedef T value_type;
+
+	// Default Constructor
+	// Creates a new, empty pool.
+	//
+	// Exceptions: Throws if make_shared throws
+	// Strong Guarantee, Exception Neutral
+	PoolAllocator()
+		: _pool(std::make_shared<NodePool>())
+	{}
+
+	// Parameterized Constructor
+	// Creates a new, empty pool that takes its slabs as options asks.
+	//
+	// Exceptions: Throws if make_shared throws
+	// Strong Guarantee, Exception Neutral
+	explicit PoolAllocator(const PoolOptions & options)
+		: _pool(std::make_shared<NodePool>(options))
+	{}
+
+	// Converting Constructor
+	// Shares the pool of other.
+	//
+	// No-Throw Guarantee
+	template <typename U>
+	PoolAllocator(const PoolAllocator<U> & other) noexcept
+		: _pool(other._pool)
+	{}
+
+	// allocate
+	// Returns uninitialised memory for count objects of type T from the pool.
+	//
+	// Exceptions: As NodePool::allocate
+	// Strong Guarantee
+	T * allocate(std::size_t count)
+	{
+		return static_cast<T *>(_pool->allocate(count * sizeof(T)));
+	}
+
+	// deallocate
+	// Gives memory returned by allocate(count) back to the pool.
+	//
+	// No-Throw Guarantee
+	void deallocate(T * memory, std::size_t count) noexcept
+	{
+		_pool->deallocate(memory, count * sizeof(T));
+	}
+
+	// pool
+	// Returns the pool shared by every copy of this allocator, for instance to read its stats.
+	//
+	// No-Throw Guarantee
+	NodePool & pool() const
+	{
+		return *_pool;
+	}
+
+	template <typename U>
+	bool operator==(const PoolAllocator<U> & other) const noexcept
+	{
+		return _pool == other._pool;
+	}
+
+	template <typename U>
+	bool operator!=(const PoolAllocator<U> & other) const noexcept
+	{
+		return _pool != other._pool;
+	}
+};
+
+// class ArenaAllocator
+// An allocator whose NodePool is an arena, for lists that are thrown away whole. As with a
+// std::pmr memory resource, one ArenaAllocator owns the arena: the one made by the default
+// constructor, or the one it was moved into. Copies only point at the arena, so the nodes, whose
+// control blocks keep copies, do not keep it alive, and the owner must outlive every list that
+// uses a copy. An owner going away while blocks are in use, such as nodes held by a Snapshot or
+// by a search result that outlived its list, abandons the arena to be freed with the last of them.
+// A list made without an allocator owns its arena, and BulkRelease lets its destructor and clear()
+// drop every node by freeing the slabs, in time proportional to the number of slabs rather than
+// of nodes, without running a node destructor, whenever no node is held outside the list. A list
+// made from a copy of an owner shares the arena and frees its nodes one by one, back to the
+// arena, like a PooledSkipList.
+//
+// Invariants:
+//		_pool is not null
+//		_owner is _pool or empty
+template <typename T>
+class ArenaAllocator {
+	template <typename U> friend class ArenaAllocator;
+	static_assert(alignof(T) <= alignof(std::max_align_t), "ArenaAllocator: over-aligned types are not supported");
+private:
+	// struct Abandon
+	// Lets the owner's arena go with NodePool::abandon, so nodes that outlive the owner stay valid.
+	struct Abandon {
+		void operator()(NodePool * pool) const noexcept
+		{
+			pool->abandon();
+		}
+	};
+
+	std::unique_ptr<NodePool, Abandon> _owner;
+	NodePool * _pool;
+
+public:
+	typedef T value_type;
+
+	// Default Constructor
+	// Creates a new, empty arena, owned by this allocator.
+	//
+	// Exceptions: Throws std::bad_alloc if the arena cannot be made
+	// Strong Guarantee, Exception Neutral
+	ArenaAllocator()
+		: _owner(new NodePool), _pool(_owner.get())
+	{}
+
+	// Parameterized Constructor
+	// Creates a new, empty arena, owned by this allocator, that takes its slabs as options asks.
+	// For a shard of a list, the thread that owns the shard makes its allocator with
+	// options.numaNode == PoolOptions::LocalNode.
+	//
+	// Exceptions: Throws std::bad_alloc if the arena cannot be made
+	// Strong Guarantee, Exception Neutral
+	explicit ArenaAllocator(const PoolOptions & options)
+		: _owner(new NodePool(options)), _pool(_owner.get())
+	{}
+
+	// Copy Constructor, Converting Constructor
+	// Point at the arena of other without owning it.
+	//
+	// No-Throw Guarantee
+	ArenaAllocator(const ArenaAllocator & other) noexcept
+		: _pool(other._pool)
+	{}
+
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U> & other) noexcept
+		: _pool(other._pool)
+	{}
+
+	// Move Constructor
+	// Takes over the arena of other, and its ownership if other owned it.
+	//
+	// No-Throw Guarantee
+	ArenaAllocator(ArenaAllocator && other) noexcept
+		: _owner(std::move(other._owner)), _pool(other._pool)
+	{}
+
+	// Copy Assignment, Move Assignment
+	// As the copy and move constructors. An arena this allocator owned is abandoned.
+	//
+	// Preconditions: No list uses the arena this allocator owned
+	// No-Throw Guarantee
+	ArenaAllocator & operator=(const ArenaAllocator & other) noexcept
+	{
+		if (this != &other)
+		{
+			_owner.reset();
+			_pool = other._pool;
+		}
+		return *this;
+	}
+
+	ArenaAllocator & operator=(ArenaAllocator && other) noexcept
+	{
+		if (this != &other)
+		{
+			_owner = std::move(other._owner);
+			_pool = other._pool;
+		}
+		return *this;
+	}
+
+	// allocate, deallocate
+	// As for PoolAllocator: blocks given back are reused until the arena is freed.
+	//
+	// Exceptions: allocate throws std::bad_alloc if a new slab is needed and cannot be had
+	// Strong Guarantee
+	T * allocate(std::size_t count)
+	{
+		return static_cast<T *>(_pool->allocate(count * sizeof(T)));
+	}
+
+	void deallocate(T * memory, std::size_t count) noexcept
+	{
+		_pool->deallocate(memory, count * sizeof(T));
+	}
+
+	// pool
+	// Returns the arena, for instance to read its stats.
+	//
+	// No-Throw Guarantee
+	NodePool & pool() const
+	{
+		return *_pool;
+	}
+
+	// owner
+	// Returns true if this allocator owns its arena, so that the arena goes with it.
+	//
+	// No-Throw Guarantee
+	bool owner() const noexcept
+	{
+		return _owner != nullptr;
+	}
+
+	template <typename U>
+	bool operator==(const ArenaAllocator<U> & other) const noexcept
+	{
+		return _pool == other._pool;
+	}
+
+	template <typename U>
+	bool operator!=(const ArenaAllocator<U> & other) const noexcept
+	{
+		return _pool != other._pool;
+	}
+};
+
+// struct BulkRelease<ArenaAllocator<T>>
+// A list that owns its arena frees its nodes with the arena, and gets a new arena when it is
+// cleared; a list using another allocator's arena keeps it.
+template <typename T>
+struct BulkRelease<ArenaAllocator<T>> {
+	static bool exclusive(const ArenaAllocator<T> & allocator)
+	{
+		return allocator.owner();
+	}
+
+	static void forget(ArenaAllocator<T> & allocator)
+	{
+		allocator.pool().forgetBlocks();
+	}
+
+	static ArenaAllocator<T> renew(const ArenaAllocator<T> & allocator)
+	{
+		return allocator.owner() ? ArenaAllocator<T>(allocator.pool().options()) : allocator;
+	}
+};
+
+// PooledSkipList
+// A SkipList whose nodes come from a NodePool.
+typedef BasicSkipList<NoInstrumentation, PoolAllocator<SkipListNode>> PooledSkipList;
+
+// ArenaSkipList
+// A SkipList whose nodes come from an arena of its own, freed at once when the list is destroyed or cleared.
+typedef BasicSkipList<NoInstrumentation, ArenaAllocator<SkipListNode>> ArenaSkipList;
+
+#endif // FILE_SKIPLIST_POOL_H_INCLUDED
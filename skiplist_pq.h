@@ -0,0 +1,356 @@
+// skiplist_pq.h
+// 18 Oct 2026
+//
+// Header for class SkipListPriorityQueue
+// A concurrent priority queue built on a skip list with an exact and a relaxed delete-min.
+// Consumers claim nodes without taking a lock, in the manner of Lotan and Shavit's skip-list
+// priority queue; the relaxed delete-min is based on "The SprayList: A Scalable Relaxed
+// Priority Queue" by Alistarh, Kopinsky, Li and Shavit.
+// Requires skiplist.h and skiplist_rcu.h
+
+#ifndef FILE_SKIPLIST_PQ_H_INCLUDED
+#define FILE_SKIPLIST_PQ_H_INCLUDED
+
+#include "skiplist.h"		// for proportion, MaxLevel, randomLevel
+#include "skiplist_rcu.h"	// for class EpochDomain
+#include <atomic>			// for std::atomic
+#include <mutex>			// for std::mutex, std::lock_guard, std::unique_lock, std::try_to_lock
+#include <vector>			// for std::vector
+#include <limits>			// for std::numeric_limits
+#include <thread>			// for std::thread::hardware_concurrency
+#include <random>			// for std::minstd_rand, std::uniform_int_distribution
+#include <cmath>			// for std::log, std::log2, std::ceil
+
+// struct PriorityQueueNode
+// Skip list node that consumers claim by setting _taken. Links are published with release stores
+// and followed with acquire loads, so consumers walk the list while a producer links new nodes.
+//
+// Invariants:
+//		_key == key
+//		_taken goes from false to true at most once
+//		_doomed is only touched by the thread holding the queue's _mutex
+struct PriorityQueueNode {
+	int _key;
+	std::atomic<bool> _taken;
+	bool _doomed;
+	std::atomic<PriorityQueueNode *> _forwardNodes[MaxLevel];
+
+	// Parameterized Constructor
+	// Creates an unlinked, untaken PriorityQueueNode
+	//
+	// Preconditions: None
+	// Postconditions: _key == key
+	// No-Throw Guarantee
+	explicit PriorityQueueNode(int key)
+		: _key(key), _taken(false), _doomed(false)
+	{
+		for (int i = 0; i < MaxLevel; i++)
+			_forwardNodes[i].store(nullptr, std::memory_order_relaxed);
+	}
+};
+
+// class SkipListPriorityQueue
+// Min-priority queue of ints shared between producer and consumer threads.
+//
+// Consumers take no lock. popMin claims the first untaken node of level 0 with one
+// compare-and-swap on its _taken flag, so a key is handed out exactly once. With many consumers
+// that first node is a hot spot, so sprayPopMin instead walks a short random path down from
+// level _sprayHeight - 1 and claims the node it lands on: a key chosen from roughly the first
+// consumers * log(consumers) keys, which spreads concurrent consumers over different nodes.
+//
+// Producers serialise on _mutex to link new nodes. Claimed nodes stay linked until a consumer
+// that has walked past enough of them takes _mutex, if it is free, and unlinks the claimed
+// nodes at the front. Unlinked nodes are freed through _epochs once no consumer can still be
+// standing on them.
+//
+// Invariants:
+//		_head is a node of "negative infinity" and _tail a node of "positive infinity"
+//		Nodes are linked in sorted order
+//		Every key pushed and not popped is in an untaken linked node
+//		1 <= _sprayHeight <= MaxLevel
+//		_sprayJump >= 1
+class SkipListPriorityQueue {
+// ***** SkipListPriorityQueue: Types and Constants *****
+private:
+	struct RetiredNode {
+		PriorityQueueNode * _node;
+		unsigned long long _stamp;
+	};
+
+	static const int CleanupThreshold = 32;				// Claimed nodes a consumer may walk past before cleaning up
+	static const std::size_t CleanupWindow = 1024;		// Most level-0 nodes one cleanup looks at
+
+// ***** SkipListPriorityQueue: Data Members *****
+private:
+	PriorityQueueNode * _head;
+	PriorityQueueNode * _tail;
+	std::mutex _mutex;						// Guards linking, unlinking and _retiredNodes
+	EpochDomain _epochs;
+	std::vector<RetiredNode> _retiredNodes;
+	int _sprayHeight;						// Level at which a spray starts walking
+	int _sprayJump;							// Maximum number of forward steps taken on each level of a spray
+
+// ***** SkipListPriorityQueue: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Creates an empty queue tuned for the given number of concurrent consumers.
+	// Following the SprayList paper, the spray starts log(consumers) levels up
+	// (in base 1/proportion) and takes up to log2(consumers) + 1 steps per level.
+	//
+	// Preconditions: None. Values of consumers below 1 are treated as 1.
+	// Postconditions: An empty queue
+	// Exceptions: Throws if new throws
+	// Strong Guarantee, Exception Neutral
+	explicit SkipListPriorityQueue(int consumers = static_cast<int>(std::thread::hardware_concurrency()))
+	{
+		if (consumers < 1)
+			consumers = 1;
+		_sprayHeight = 1 + static_cast<int>(std::ceil(std::log(consumers) / std::log(1.0 / proportion)));
+		if (_sprayHeight > MaxLevel)
+			_sprayHeight = MaxLevel;
+		_sprayJump = 1 + static_cast<int>(std::ceil(std::log2(consumers)));
+
+		_tail = new PriorityQueueNode(std::numeric_limits<int>::max());
+		try {
+			_head = new PriorityQueueNode(std::numeric_limits<int>::min());
+		}
+		catch (...) {
+			delete _tail;
+			throw;
+		}
+		for (int i = 0; i < MaxLevel; i++)
+			_head->_forwardNodes[i].store(_tail, std::memory_order_relaxed);
+	}
+
+	SkipListPriorityQueue(const SkipListPriorityQueue & other) = delete;
+	SkipListPriorityQueue & operator=(const SkipListPriorityQueue & other) = delete;
+
+	// Destructor
+	// Deletes every linked and retired node.
+	//
+	// Preconditions: No other thread is using the queue
+	// No-Throw Guarantee
+	~SkipListPriorityQueue()
+	{
+		for (auto & retired : _retiredNodes)
+			delete retired._node;
+		PriorityQueueNode * currentNode = _head;
+		while (currentNode)
+		{
+			PriorityQueueNode * nextNode = currentNode->_forwardNodes[0].load(std::memory_order_relaxed);
+			delete currentNode;
+			currentNode = nextNode;
+		}
+	}
+
+// ***** SkipListPriorityQueue: Public Member Functions *****
+public:
+	// push
+	// Adds a key to the queue.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if new throws
+	// Strong Guarantee, Exception Neutral
+	void push(int key)
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		PriorityQueueNode * updateNodes[MaxLevel];
+		PriorityQueueNode * currentNode = _head;
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			PriorityQueueNode * nextNode = currentNode->_forwardNodes[i].load(std::memory_order_relaxed);
+			while (nextNode->_key < key)
+			{
+				currentNode = nextNode;
+				nextNode = currentNode->_forwardNodes[i].load(std::memory_order_relaxed);
+			}
+			updateNodes[i] = currentNode;
+		}
+
+		int level = randomLevel();
+		auto newNode = new PriorityQueueNode(key);
+		for (int i = 0; i < level; i++)
+			newNode->_forwardNodes[i].store(updateNodes[i]->_forwardNodes[i].load(std::memory_order_relaxed),
+			                                std::memory_order_relaxed);
+		// Link bottom up so a consumer that finds the node on a high level also finds it on level 0
+		for (int i = 0; i < level; i++)
+			updateNodes[i]->_forwardNodes[i].store(newNode, std::memory_order_release);
+	}
+
+	// popMin
+	// Removes the smallest key and stores it in key.
+	// Returns false, leaving key unchanged, if the queue is empty.
+	// Keys pushed while the call runs may or may not be considered.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws on this thread's first use of the queue
+	// Strong Guarantee, Exception Neutral
+	bool popMin(int & key)
+	{
+		int skipped = 0;
+		bool found;
+		{
+			EpochDomain::Guard guard(_epochs);
+			found = claimFrom(_head->_forwardNodes[0].load(std::memory_order_acquire), key, skipped);
+		}
+		if (skipped >= CleanupThreshold)
+			cleanup();
+		return found;
+	}
+
+	// sprayPopMin
+	// Removes a key near the front of the queue and stores it in key.
+	// Starting at _head on level _sprayHeight - 1, walks a random number of steps in [0, _sprayJump]
+	// on each level and then drops one level, so the landing node is spread over the first
+	// O(consumers * log(consumers)) keys. If the landing node is already claimed, claims the next
+	// untaken node after it, and falls back to popMin if there is none.
+	// Returns false, leaving key unchanged, if the queue is empty.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws on this thread's first use of the queue
+	// Strong Guarantee, Exception Neutral
+	bool sprayPopMin(int & key)
+	{
+		thread_local std::minstd_rand generator(std::random_device{}());
+		std::uniform_int_distribution<int> jump(0, _sprayJump);
+
+		int skipped = 0;
+		bool found;
+		{
+			EpochDomain::Guard guard(_epochs);
+			PriorityQueueNode * currentNode = _head;
+			for (int i = _sprayHeight - 1; i >= 0; i--) {
+				for (int steps = jump(generator); steps > 0; steps--) {
+					PriorityQueueNode * nextNode = currentNode->_forwardNodes[i].load(std::memory_order_acquire);
+					if (nextNode == _tail)
+						break;
+					currentNode = nextNode;
+				}
+			}
+			if (currentNode == _head)
+				currentNode = currentNode->_forwardNodes[0].load(std::memory_order_acquire);
+			found = claimFrom(currentNode, key, skipped) ||
+			        claimFrom(_head->_forwardNodes[0].load(std::memory_order_acquire), key, skipped);
+		}
+		if (skipped >= CleanupThreshold)
+			cleanup();
+		return found;
+	}
+
+	// empty
+	// Returns true if the queue held no keys at some moment during the call.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws on this thread's first use of the queue
+	// Strong Guarantee, Exception Neutral
+	bool empty()
+	{
+		EpochDomain::Guard guard(_epochs);
+		PriorityQueueNode * currentNode = _head->_forwardNodes[0].load(std::memory_order_acquire);
+		while (currentNode != _tail && currentNode->_taken.load(std::memory_order_acquire))
+			currentNode = currentNode->_forwardNodes[0].load(std::memory_order_acquire);
+		return currentNode == _tail;
+	}
+
+// ***** SkipListPriorityQueue: Private Member Functions *****
+private:
+	// claimFrom
+	// Claims the first untaken node at or after currentNode on level 0 and stores its key in key.
+	// Adds the number of claimed nodes walked past to skipped. Returns false if there is none.
+	//
+	// Preconditions: _epochs is pinned by the calling thread
+	// No-Throw Guarantee
+	bool claimFrom(PriorityQueueNode * currentNode, int & key, int & skipped)
+	{
+		while (currentNode != _tail)
+		{
+			bool expected = false;
+			if (!currentNode->_taken.load(std::memory_order_relaxed) &&
+			    currentNode->_taken.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+			{
+				key = currentNode->_key;
+				return true;
+			}
+			skipped++;
+			currentNode = currentNode->_forwardNodes[0].load(std::memory_order_acquire);
+		}
+		return false;
+	}
+
+	// cleanup
+	// Unlinks the claimed nodes among the first CleanupWindow nodes of level 0 and retires them.
+	// Gives up at once if another thread holds _mutex; that thread's push or cleanup will do.
+	//
+	// No-Throw Guarantee
+	void cleanup()
+	{
+		std::unique_lock<std::mutex> lock(_mutex, std::try_to_lock);
+		if (!lock.owns_lock())
+			return;
+		reclaimRetired();
+
+		// Choose the nodes first, so one that is claimed part way through is not unlinked from
+		// only some of its levels
+		std::vector<PriorityQueueNode *> doomedNodes;
+		try {
+			doomedNodes.reserve(CleanupWindow);
+			if (_retiredNodes.capacity() - _retiredNodes.size() < CleanupWindow)
+				_retiredNodes.reserve(2 * _retiredNodes.capacity() + CleanupWindow);
+		}
+		catch (...) {
+			return;
+		}
+		PriorityQueueNode * lastNode = _head;
+		for (PriorityQueueNode * currentNode = _head->_forwardNodes[0].load(std::memory_order_relaxed);
+		     currentNode != _tail && doomedNodes.size() + 1 < CleanupWindow;
+		     currentNode = currentNode->_forwardNodes[0].load(std::memory_order_relaxed))
+		{
+			lastNode = currentNode;
+			if (currentNode->_taken.load(std::memory_order_acquire))
+			{
+				currentNode->_doomed = true;
+				doomedNodes.push_back(currentNode);
+			}
+		}
+		if (doomedNodes.empty())
+			return;
+
+		// Splice the doomed nodes out of every level, top down, stopping after lastNode
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			PriorityQueueNode * currentNode = _head;
+			PriorityQueueNode * nextNode = currentNode->_forwardNodes[i].load(std::memory_order_relaxed);
+			while (nextNode != _tail && nextNode->_key <= lastNode->_key)
+			{
+				if (nextNode->_doomed)
+				{
+					nextNode = nextNode->_forwardNodes[i].load(std::memory_order_relaxed);
+					currentNode->_forwardNodes[i].store(nextNode, std::memory_order_release);
+				}
+				else
+				{
+					currentNode = nextNode;
+					nextNode = currentNode->_forwardNodes[i].load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		unsigned long long stamp = _epochs.retireStamp();
+		for (auto node : doomedNodes)
+			_retiredNodes.push_back(RetiredNode{ node, stamp });
+	}
+
+	// reclaimRetired
+	// Deletes the retired nodes that no consumer can still be standing on.
+	//
+	// Preconditions: Caller holds _mutex
+	// No-Throw Guarantee
+	void reclaimRetired()
+	{
+		unsigned long long safe = _epochs.safeEpoch();
+		std::size_t freed = 0;
+		while (freed < _retiredNodes.size() && _retiredNodes[freed]._stamp <= safe)
+			delete _retiredNodes[freed++]._node;
+		_retiredNodes.erase(_retiredNodes.begin(), _retiredNodes.begin() + freed);
+	}
+};
+
+#endif // #ifndef FILE_SKIPLIST_PQ_H_INCLUDED
@@ -0,0 +1,757 @@
+// skiplist_rcu.h
+// 18 Oct 2026
+//
+// Header for classes RcuSkipList and WriteBatch
+// A read-mostly skip list in the style of read-copy-update: writers serialise on one mutex,
+// readers take no lock and write only their own epoch slot. Groups of writes can be committed
+// atomically, and removed nodes are freed once no reader can still be standing on them.
+// Requires skiplist.h
+
+#ifndef FILE_SKIPLIST_RCU_H_INCLUDED
+#define FILE_SKIPLIST_RCU_H_INCLUDED
+
+#include "skiplist.h"	// for MaxLevel, NoSequence, randomLevel
+#include <atomic>		// for std::atomic, std::atomic_thread_fence
+#include <mutex>		// for std::mutex, std::lock_guard
+#include <vector>		// for std::vector
+#include <memory>		// for std::unique_ptr
+#include <limits>		// for std::numeric_limits
+#include <algorithm>	// for std::max
+#include <thread>		// for std::this_thread::yield, std::this_thread::get_id
+
+// struct RcuSkipListNode
+// Skip List int node whose links may be read while a writer changes them.
+// Links are published with release stores and followed with acquire loads.
+// A node is visible to readers once _beginSequence has been committed and until
+// _endSequence has been committed.
+//
+// Invariants:
+//		_key == key
+//		_forwardNodes is an array of nullptr or ptrs to other nodes
+//		_beginSequence does not change once the node is linked
+struct RcuSkipListNode {
+	int _key;
+	unsigned long long _beginSequence;
+	std::atomic<unsigned long long> _endSequence;
+	std::atomic<RcuSkipListNode *> _forwardNodes[MaxLevel];
+
+	// Parameterized Constructor
+	// Creates an unlinked RcuSkipListNode
+	//
+	// Preconditions: None
+	// Postconditions:
+	//		_key == key
+	//		Node becomes visible at sequence beginSequence
+	// No-Throw Guarantee
+	RcuSkipListNode(int key, unsigned long long beginSequence)
+		: _key(key), _beginSequence(beginSequence), _endSequence(NoSequence)
+	{
+		for (int i = 0; i < MaxLevel; i++)
+			_forwardNodes[i].store(nullptr, std::memory_order_relaxed);
+	}
+};
+
+// class EpochDomain
+// Grace-period detection for readers that take no lock, after Fraser's epoch-based reclamation.
+// For the length of one operation a reader pins the domain by copying the global epoch into its
+// own slot, a cache line no other thread writes; only writers ever read the slots. A writer that
+// has unlinked some nodes takes a stamp from retireStamp(). Every reader that pins at or after
+// that stamp started after the nodes were unlinked, so the nodes may be freed as soon as
+// safeEpoch() reaches the stamp. Readers never wait for writers, and one slow reader holds back
+// only the nodes retired while it was pinned.
+//
+// Invariants:
+//		_epoch only increases
+//		A Slot's _epoch is Idle or the value of _epoch when its owner pinned it
+//		Each Slot is written only by the thread in _owner
+class EpochDomain {
+// ***** EpochDomain: Types and Constants *****
+public:
+	static const unsigned long long Idle = std::numeric_limits<unsigned long long>::max();
+
+private:
+	// struct Slot
+	// One thread's announced epoch, on a cache line of its own.
+	struct alignas(64) Slot {
+		std::atomic<unsigned long long> _epoch;
+		int _depth;							// Nesting count of Guards, touched only by _owner
+		std::thread::id _owner;
+
+		Slot()
+			: _epoch(Idle), _depth(0)
+		{}
+	};
+
+// ***** EpochDomain: Data Members *****
+private:
+	std::atomic<unsigned long long> _epoch;
+	std::mutex _slotsMutex;
+	std::vector<std::unique_ptr<Slot>> _slots;
+	unsigned long long _id;					// Distinguishes this domain in each thread's slot cache
+
+// ***** EpochDomain: Guard *****
+public:
+	// class Guard
+	// Pins the domain for the calling thread from construction to destruction. Guards nest.
+	//
+	// Invariants:
+	//		_slot belongs to the calling thread
+	class Guard {
+	private:
+		EpochDomain::Slot * _slot;
+
+	public:
+		// Parameterized Constructor
+		// Publishes the current epoch in the calling thread's slot, unless it is already pinned.
+		//
+		// Exceptions: Throws if std::vector or new throws on this thread's first use of the domain
+		// Strong Guarantee, Exception Neutral
+		explicit Guard(EpochDomain & domain)
+			: _slot(&domain.localSlot())
+		{
+			if (_slot->_depth++ == 0)
+			{
+				_slot->_epoch.store(domain._epoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+				// Pairs with the fence in safeEpoch: either the writer sees this slot or we see its unlinks
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+			}
+		}
+
+		Guard(const Guard & other) = delete;
+		Guard & operator=(const Guard & other) = delete;
+
+		// Destructor
+		// Unpins the slot when the outermost Guard goes away.
+		//
+		// No-Throw Guarantee
+		~Guard()
+		{
+			if (--_slot->_depth == 0)
+				_slot->_epoch.store(Idle, std::memory_order_release);
+		}
+	};
+
+// ***** EpochDomain: Constructors and Destructors *****
+public:
+	// Default Constructor
+	// Creates a domain with no slots.
+	//
+	// No-Throw Guarantee
+	EpochDomain()
+		: _epoch(1), _id(nextId())
+	{}
+
+	EpochDomain(const EpochDomain & other) = delete;
+	EpochDomain & operator=(const EpochDomain & other) = delete;
+
+// ***** EpochDomain: Public Member Functions *****
+public:
+	// retireStamp
+	// Advances the epoch and returns the new value. Nodes unlinked before the call may be freed
+	// once safeEpoch() returns at least this stamp.
+	//
+	// No-Throw Guarantee
+	unsigned long long retireStamp()
+	{
+		return _epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+	}
+
+	// safeEpoch
+	// Returns the oldest epoch any reader is pinned at, or Idle if no reader is pinned.
+	//
+	// No-Throw Guarantee
+	unsigned long long safeEpoch()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		unsigned long long oldest = Idle;
+		std::lock_guard<std::mutex> lock(_slotsMutex);
+		for (auto & slot : _slots)
+		{
+			unsigned long long epoch = slot->_epoch.load(std::memory_order_seq_cst);
+			if (epoch < oldest)
+				oldest = epoch;
+		}
+		return oldest;
+	}
+
+// ***** EpochDomain: Private Member Functions *****
+private:
+	// nextId
+	// Returns a number never returned before, so a thread's cached slot can't be mistaken
+	// for one belonging to a later domain at the same address.
+	//
+	// No-Throw Guarantee
+	static unsigned long long nextId()
+	{
+		static std::atomic<unsigned long long> counter(0);
+		return ++counter;
+	}
+
+	// localSlot
+	// Returns the calling thread's Slot, creating it on first use.
+	// The last slot used is cached per thread so the common case takes no lock.
+	//
+	// Exceptions: Throws if std::vector or new throws
+	// Strong Guarantee, Exception Neutral
+	Slot & localSlot()
+	{
+		thread_local unsigned long long cachedId = 0;
+		thread_local Slot * cachedSlot = nullptr;
+		if (cachedId == _id)
+			return *cachedSlot;
+
+		std::lock_guard<std::mutex> lock(_slotsMutex);
+		auto self = std::this_thread::get_id();
+		Slot * slot = nullptr;
+		for (auto & candidate : _slots)
+		{
+			if (candidate->_owner == self)
+				slot = candidate.get();
+		}
+		if (!slot)
+		{
+			std::unique_ptr<Slot> created(new Slot);
+			created->_owner = self;
+			_slots.push_back(std::move(created));
+			slot = _slots.back().get();
+		}
+		cachedId = _id;
+		cachedSlot = slot;
+		return *slot;
+	}
+};
+
+// class WriteBatch
+// An ordered group of inserts and removes to be applied to an RcuSkipList as one commit.
+//
+// Invariants:
+//		_operations holds the calls to put and erase in the order they were made
+class WriteBatch {
+	friend class RcuSkipList;
+// ***** WriteBatch: Data Members *****
+private:
+	struct Operation {
+		bool _erase;
+		int _key;
+	};
+	std::vector<Operation> _operations;
+
+// ***** WriteBatch: Public Member Functions *****
+public:
+	// put
+	// Adds an insert of key to the batch.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	void put(int key)
+	{
+		_operations.push_back(Operation{ false, key });
+	}
+
+	// erase
+	// Adds a remove of one copy of key to the batch.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	void erase(int key)
+	{
+		_operations.push_back(Operation{ true, key });
+	}
+
+	// size, clear
+	// Number of operations in the batch; discard them all.
+	//
+	// No-Throw Guarantee
+	std::size_t size() const
+	{
+		return _operations.size();
+	}
+
+	void clear()
+	{
+		_operations.clear();
+	}
+};
+
+// class RcuSkipList
+// Sorted multiset of ints tuned for workloads that are almost all reads.
+// Writers take _writeMutex, bump _version to an odd value, relink with release stores and bump
+// _version back to even. Readers follow links with acquire loads and retry if _version was odd
+// or changed while they read, so every read reflects one state between two writes.
+//
+// Every write is a commit with its own sequence number. apply() links the batch's new nodes and
+// stamps its removed nodes with the next sequence number, then publishes it in _committed.
+// Readers only see nodes whose sequence range covers the _committed they loaded, so a batch
+// becomes visible all at once without readers ever taking a lock.
+//
+// Readers pin _epochs while they walk the list. Unlinked nodes wait in _retiredNodes with the
+// stamp taken after unlinking them, and writers free them once every pinned reader started
+// after that stamp, so memory is reclaimed even when readers never stop.
+//
+// Invariants:
+//		_head is a node of "negative infinity" and _tail a node of "positive infinity"
+//		Nodes are linked in sorted order
+//		_version is even whenever no write is in progress
+//		Linked nodes have _endSequence > _committed, except while a write runs
+//		_retiredNodes is ordered by _stamp and holds only unlinked nodes
+class RcuSkipList {
+// ***** RcuSkipList: Types and Constants *****
+private:
+	struct RetiredNode {
+		RcuSkipListNode * _node;
+		unsigned long long _stamp;
+	};
+
+	static const std::size_t MinimumReclaimBatch = 64;
+
+// ***** RcuSkipList: Data Members *****
+private:
+	RcuSkipListNode * _head;
+	RcuSkipListNode * _tail;
+	std::atomic<unsigned long long> _version;
+	std::atomic<unsigned long long> _committed;
+	std::mutex _writeMutex;
+	mutable EpochDomain _epochs;
+	std::vector<RetiredNode> _retiredNodes;
+	std::size_t _reclaimAt;					// Size of _retiredNodes that triggers the next reclaim
+
+// ***** RcuSkipList: Constructors and Destructors *****
+public:
+	// Default Constructor
+	// Creates an empty list bracketed by the _head and _tail nodes
+	//
+	// Preconditions: None
+	// Postconditions: RcuSkipList with invariants
+	// Exceptions: Throws if new throws
+	// Strong Guarantee, Exception Neutral
+	RcuSkipList()
+		: _version(0), _committed(0), _reclaimAt(MinimumReclaimBatch)
+	{
+		_tail = new RcuSkipListNode(std::numeric_limits<int>::max(), 0);
+		try {
+			_head = new RcuSkipListNode(std::numeric_limits<int>::min(), 0);
+		}
+		catch (...) {
+			delete _tail;
+			throw;
+		}
+		for (int i = MaxLevel - 1; i >= 0; i--)
+			_head->_forwardNodes[i].store(_tail, std::memory_order_relaxed);
+	}
+
+	RcuSkipList(const RcuSkipList & other) = delete;
+	RcuSkipList & operator=(const RcuSkipList & other) = delete;
+
+	// Destructor
+	// Deletes every linked and retired node.
+	//
+	// Preconditions: No reader is active
+	// No-Throw Guarantee
+	~RcuSkipList()
+	{
+		for (auto & retired : _retiredNodes)
+			delete retired._node;
+		RcuSkipListNode * currentNode = _head;
+		while (currentNode)
+		{
+			RcuSkipListNode * nextNode = currentNode->_forwardNodes[0].load(std::memory_order_relaxed);
+			delete currentNode;
+			currentNode = nextNode;
+		}
+	}
+
+// ***** RcuSkipList: Public Member Functions *****
+public:
+	// search
+	// Returns true if a node with _key == searchKey is in the list.
+	// Takes no lock and writes only the calling thread's epoch slot.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws on this thread's first read
+	// Strong Guarantee, Exception Neutral
+	bool search(int searchKey) const
+	{
+		while (true)
+		{
+			// Pinned per attempt, so a reader retrying behind a stream of writes never holds back reclamation
+			EpochDomain::Guard guard(_epochs);
+			unsigned long long version = beginRead();
+			unsigned long long committed = _committed.load(std::memory_order_acquire);
+			RcuSkipListNode * currentNode = lowerBound(searchKey);
+			bool found = false;
+			while (currentNode != _tail && currentNode->_key == searchKey && !found)
+			{
+				found = visibleAt(currentNode, committed);
+				currentNode = currentNode->_forwardNodes[0].load(std::memory_order_acquire);
+			}
+			if (validateRead(version))
+				return found;
+		}
+	}
+
+	// scan
+	// Calls visit(key) for every key in [lowKey, highKey], in sorted order.
+	// The keys are collected and validated first, so visit sees one consistent state
+	// and may take as long as it likes without holding up writers or reclamation.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector or visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) const
+	{
+		std::vector<int> keys;
+		while (true)
+		{
+			EpochDomain::Guard guard(_epochs);
+			keys.clear();
+			unsigned long long version = beginRead();
+			unsigned long long committed = _committed.load(std::memory_order_acquire);
+			RcuSkipListNode * currentNode = lowerBound(lowKey);
+			while (currentNode != _tail && currentNode->_key <= highKey)
+			{
+				if (visibleAt(currentNode, committed))
+					keys.push_back(currentNode->_key);
+				currentNode = currentNode->_forwardNodes[0].load(std::memory_order_acquire);
+			}
+			if (validateRead(version))
+				break;
+		}
+		for (auto key : keys)
+			visit(key);
+	}
+
+	// range
+	// Returns the keys in [lowKey, highKey], in sorted order, as of one consistent state.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<int> range(int lowKey, int highKey) const
+	{
+		std::vector<int> result;
+		scan(lowKey, highKey, [&result](int key) { result.push_back(key); });
+		return result;
+	}
+
+	// insert
+	// Inserts a new node into the list at the proper, sorted position, as a commit of its own.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if new throws
+	// Strong Guarantee, Exception Neutral
+	void insert(int insertKey)
+	{
+		std::lock_guard<std::mutex> lock(_writeMutex);
+		unsigned long long sequence = _committed.load(std::memory_order_relaxed) + 1;
+		linkNew(insertKey, sequence);
+		_committed.store(sequence, std::memory_order_release);
+	}
+
+	// remove
+	// Unlinks the first node with _key == removeKey, if there is one, and retires it,
+	// as a commit of its own.
+	//
+	// Preconditions: None
+	// Postconditions: If a node with _key == key existed, that node is unlinked.
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	void remove(int removeKey)
+	{
+		std::lock_guard<std::mutex> lock(_writeMutex);
+		reserveRetired(1);
+		unsigned long long sequence = _committed.load(std::memory_order_relaxed) + 1;
+		RcuSkipListNode * node = markErased(removeKey, sequence);
+		if (!node)
+			return;
+		_committed.store(sequence, std::memory_order_release);
+		unlink(node);
+		retire(&node, 1);
+	}
+
+	// apply
+	// Commits every operation of batch, in order, as one write: readers see all of them or none.
+	// New nodes are linked invisibly, removed nodes are stamped with the commit's sequence number,
+	// and only then is that sequence number published. Removed nodes are unlinked afterwards.
+	//
+	// Preconditions: None
+	// Postconditions: The list reflects every put and erase in batch
+	// Exceptions: Throws if new or std::vector throws
+	// Strong Guarantee, Exception Neutral
+	void apply(const WriteBatch & batch)
+	{
+		std::lock_guard<std::mutex> lock(_writeMutex);
+		unsigned long long sequence = _committed.load(std::memory_order_relaxed) + 1;
+		std::vector<RcuSkipListNode *> insertedNodes;
+		std::vector<RcuSkipListNode *> erasedNodes;
+		insertedNodes.reserve(batch.size());
+		erasedNodes.reserve(batch.size());
+		reserveRetired(batch.size());
+
+		try {
+			for (auto & operation : batch._operations)
+			{
+				if (!operation._erase)
+					insertedNodes.push_back(linkNew(operation._key, sequence));
+				else if (RcuSkipListNode * node = markErased(operation._key, sequence))
+					erasedNodes.push_back(node);
+			}
+		}
+		catch (...) {
+			// Nothing was published: revive the erased nodes and retire the never-visible new ones
+			for (auto node : erasedNodes)
+				node->_endSequence.store(NoSequence, std::memory_order_relaxed);
+			for (auto node : insertedNodes)
+			{
+				node->_endSequence.store(sequence, std::memory_order_relaxed);
+				unlink(node);
+			}
+			retire(insertedNodes.data(), insertedNodes.size());
+			throw;
+		}
+
+		_committed.store(sequence, std::memory_order_release);
+
+		for (auto node : erasedNodes)
+			unlink(node);
+		retire(erasedNodes.data(), erasedNodes.size());
+	}
+
+	// reclaim
+	// Deletes the retired nodes that no reader can reach any more. Writers call this as nodes
+	// pile up; it may also be called at any time to release memory promptly.
+	//
+	// Preconditions: None
+	// No-Throw Guarantee
+	void reclaim()
+	{
+		std::lock_guard<std::mutex> lock(_writeMutex);
+		reclaimRetired();
+	}
+
+	// retiredCount
+	// Returns the number of unlinked nodes still waiting to be freed.
+	//
+	// Preconditions: None
+	// No-Throw Guarantee
+	std::size_t retiredCount()
+	{
+		std::lock_guard<std::mutex> lock(_writeMutex);
+		return _retiredNodes.size();
+	}
+
+// ***** RcuSkipList: Private Member Functions *****
+private:
+	// visibleAt
+	// Returns true if node was inserted at or before committed and not removed by then.
+	//
+	// No-Throw Guarantee
+	static bool visibleAt(const RcuSkipListNode * node, unsigned long long committed)
+	{
+		return node->_beginSequence <= committed &&
+		       committed < node->_endSequence.load(std::memory_order_relaxed);
+	}
+
+	// lowerBound
+	// Returns the first node with _key >= searchKey, following links with acquire loads.
+	//
+	// Preconditions: Called between beginRead and validateRead, with _epochs pinned
+	// No-Throw Guarantee
+	RcuSkipListNode * lowerBound(int searchKey) const
+	{
+		RcuSkipListNode * currentNode = _head;
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			RcuSkipListNode * nextNode = currentNode->_forwardNodes[i].load(std::memory_order_acquire);
+			while (nextNode->_key < searchKey)
+			{
+				currentNode = nextNode;
+				nextNode = currentNode->_forwardNodes[i].load(std::memory_order_acquire);
+			}
+		}
+		return currentNode->_forwardNodes[0].load(std::memory_order_acquire);
+	}
+
+	// findPredecessors
+	// Stores in updateNodes the last node before searchKey on each level.
+	//
+	// Preconditions: Caller holds _writeMutex
+	// No-Throw Guarantee
+	void findPredecessors(int searchKey, RcuSkipListNode * updateNodes[MaxLevel]) const
+	{
+		RcuSkipListNode * currentNode = _head;
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			RcuSkipListNode * nextNode = currentNode->_forwardNodes[i].load(std::memory_order_relaxed);
+			while (nextNode->_key < searchKey)
+			{
+				currentNode = nextNode;
+				nextNode = currentNode->_forwardNodes[i].load(std::memory_order_relaxed);
+			}
+			updateNodes[i] = currentNode;
+		}
+	}
+
+	// linkNew
+	// Links a new node for key, visible from sequence on, and returns it.
+	//
+	// Preconditions: Caller holds _writeMutex
+	// Exceptions: Throws if new throws, before anything is linked
+	// Strong Guarantee, Exception Neutral
+	RcuSkipListNode * linkNew(int key, unsigned long long sequence)
+	{
+		RcuSkipListNode * updateNodes[MaxLevel];
+		findPredecessors(key, updateNodes);
+		int level = randomLevel();
+		auto newNode = new RcuSkipListNode(key, sequence);
+		for (int i = 0; i < level; i++)
+			newNode->_forwardNodes[i].store(updateNodes[i]->_forwardNodes[i].load(std::memory_order_relaxed),
+			                                std::memory_order_relaxed);
+		beginWrite();
+		for (int i = 0; i < level; i++)
+			updateNodes[i]->_forwardNodes[i].store(newNode, std::memory_order_release);
+		endWrite();
+		return newNode;
+	}
+
+	// markErased
+	// Stamps the first copy of key that is live as of sequence with _endSequence = sequence
+	// and returns it; returns nullptr if there is none.
+	//
+	// Preconditions: Caller holds _writeMutex
+	// No-Throw Guarantee
+	RcuSkipListNode * markErased(int key, unsigned long long sequence)
+	{
+		RcuSkipListNode * updateNodes[MaxLevel];
+		findPredecessors(key, updateNodes);
+		RcuSkipListNode * currentNode = updateNodes[0]->_forwardNodes[0].load(std::memory_order_relaxed);
+		while (currentNode != _tail && currentNode->_key == key)
+		{
+			if (currentNode->_endSequence.load(std::memory_order_relaxed) == NoSequence)
+			{
+				currentNode->_endSequence.store(sequence, std::memory_order_relaxed);
+				return currentNode;
+			}
+			currentNode = currentNode->_forwardNodes[0].load(std::memory_order_relaxed);
+		}
+		return nullptr;
+	}
+
+	// unlink
+	// Unlinks one particular node, which may be preceded by other nodes with the same key.
+	//
+	// Preconditions: Caller holds _writeMutex; node is linked into this list
+	// No-Throw Guarantee
+	void unlink(RcuSkipListNode * node)
+	{
+		int height = 0;
+		while (height < MaxLevel && node->_forwardNodes[height].load(std::memory_order_relaxed))
+			height++;
+
+		beginWrite();
+		RcuSkipListNode * currentNode = _head;
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			while (currentNode->_forwardNodes[i].load(std::memory_order_relaxed)->_key < node->_key)
+				currentNode = currentNode->_forwardNodes[i].load(std::memory_order_relaxed);
+			if (i < height) {
+				// Equal keys linked ahead of node on this level also precede it on every lower level
+				while (currentNode->_forwardNodes[i].load(std::memory_order_relaxed) != node)
+					currentNode = currentNode->_forwardNodes[i].load(std::memory_order_relaxed);
+				currentNode->_forwardNodes[i].store(node->_forwardNodes[i].load(std::memory_order_relaxed),
+				                                    std::memory_order_release);
+			}
+		}
+		endWrite();
+	}
+
+	// reserveRetired
+	// Makes room for count more retired nodes, growing _retiredNodes geometrically,
+	// so that retire cannot throw once a write has been published.
+	//
+	// Preconditions: Caller holds _writeMutex
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	void reserveRetired(std::size_t count)
+	{
+		if (_retiredNodes.capacity() - _retiredNodes.size() < count)
+			_retiredNodes.reserve(std::max(2 * _retiredNodes.capacity(), _retiredNodes.size() + count));
+	}
+
+	// retire
+	// Hands count unlinked nodes to the reclaimer and reclaims once enough have piled up.
+	// The threshold doubles with what the last reclaim had to keep, so the cost stays amortised
+	// constant per node even while a slow reader holds nodes back.
+	//
+	// Preconditions: Caller holds _writeMutex; the nodes are unlinked; reserveRetired(count) was called
+	// No-Throw Guarantee
+	void retire(RcuSkipListNode * const * nodes, std::size_t count)
+	{
+		if (count == 0)
+			return;
+		unsigned long long stamp = _epochs.retireStamp();
+		for (std::size_t i = 0; i < count; i++)
+			_retiredNodes.push_back(RetiredNode{ nodes[i], stamp });
+		if (_retiredNodes.size() >= _reclaimAt)
+		{
+			reclaimRetired();
+			_reclaimAt = 2 * _retiredNodes.size() > MinimumReclaimBatch ? 2 * _retiredNodes.size() : MinimumReclaimBatch;
+		}
+	}
+
+	// reclaimRetired
+	// Deletes the oldest retired nodes whose stamp every pinned reader has passed.
+	//
+	// Preconditions: Caller holds _writeMutex
+	// No-Throw Guarantee
+	void reclaimRetired()
+	{
+		unsigned long long safe = _epochs.safeEpoch();
+		std::size_t freed = 0;
+		while (freed < _retiredNodes.size() && _retiredNodes[freed]._stamp <= safe)
+			delete _retiredNodes[freed++]._node;
+		_retiredNodes.erase(_retiredNodes.begin(), _retiredNodes.begin() + freed);
+	}
+
+	// beginWrite, endWrite
+	// Mark the start and end of a change that readers must not straddle.
+	//
+	// Preconditions: Caller holds _writeMutex
+	// No-Throw Guarantee
+	void beginWrite()
+	{
+		_version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+
+	void endWrite()
+	{
+		_version.store(_version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	}
+
+	// beginRead
+	// Waits until no write is in progress and returns the version to validate against.
+	//
+	// No-Throw Guarantee
+	unsigned long long beginRead() const
+	{
+		unsigned long long version = _version.load(std::memory_order_acquire);
+		while (version & 1)
+		{
+			std::this_thread::yield();
+			version = _version.load(std::memory_order_acquire);
+		}
+		return version;
+	}
+
+	// validateRead
+	// Returns true if no write started since beginRead returned version.
+	//
+	// No-Throw Guarantee
+	bool validateRead(unsigned long long version) const
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return _version.load(std::memory_order_relaxed) == version;
+	}
+};
+
+#endif // #ifndef FILE_SKIPLIST_RCU_H_INCLUDED
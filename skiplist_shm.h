@@ -0,0 +1,413 @@
+// skiplist_shm.h
+// 18 Oct 2026
+//
+// Header for class SharedSkipList
+// A skip list kept in a POSIX shared-memory region, written by one process and searched in place
+// by any number of others, so a host holds one copy of the list however many processes read it.
+// Requires skiplist.h and a POSIX system (shm_open, mmap)
+
+#ifndef FILE_SKIPLIST_SHM_H_INCLUDED
+#define FILE_SKIPLIST_SHM_H_INCLUDED
+
+#include "skiplist.h"	// for MaxLevel, randomLevel
+#include <string>		// for std::string
+#include <vector>		// for std::vector
+#include <atomic>		// for std::atomic
+#include <new>			// for placement new
+#include <limits>		// for std::numeric_limits
+#include <stdexcept>	// for std::runtime_error
+#include <cstring>		// for std::strerror
+#include <cstdint>		// for std::uint32_t, std::uint64_t, std::int32_t
+#include <cerrno>		// for errno
+#include <fcntl.h>		// for O_CREAT, O_RDWR, O_RDONLY
+#include <unistd.h>		// for close, ftruncate
+#include <sys/mman.h>	// for shm_open, shm_unlink, mmap, munmap
+#include <sys/stat.h>	// for fstat
+
+// class SharedSkipList
+// A skip list in a fixed-size shared-memory region named like "/name", opened either as its one
+// writer or as a reader. The writer creates the region; readers map it read-only and take no lock,
+// so they never slow the writer or each other.
+//
+// As in MappedSkipList, records refer to each other by 64-bit byte offsets from the start of the
+// region, so every process follows them at whatever address it mapped the region. As in RcuSkipList,
+// the writer fills in a new record and then links it bottom-up with release stores, and readers
+// follow links with acquire loads, so a reader sees each record either fully linked on a level or
+// not at all. A removed record is flagged first, so readers skip it, and then unlinked top-down;
+// its space is never reused, since a reader in another process may still be standing on it, so a
+// list with heavy churn should be rebuilt into a fresh region once bytesUsed() nears capacity().
+//
+// Region layout, in host byte order and 8-byte aligned:
+//		header: magic, byte-order mark, capacity, bytes used, key count, offset of the head record
+//		record: key (int32), height (uint32), removed flag (uint32), padding, next offsets (uint64 each)
+// The head record has height MaxLevel. Offset 0 marks the end of a level. The writer stores the
+// magic last, so a reader never opens a region that is still being set up. Readers check every
+// offset they follow against the region's bounds.
+//
+// Invariants:
+//		_data points to _size bytes holding a region set up by a writer
+//		_writable is true only in the process that created the region, which is its only writer
+//		Records from the header's _used up to _size are unused
+class SharedSkipList {
+// ***** SharedSkipList: Region Format *****
+private:
+	static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<std::uint32_t>::is_always_lock_free,
+	              "SharedSkipList needs lock-free atomics, which are address-free, to share them between processes");
+
+	struct Header {
+		std::atomic<std::uint32_t> _magic;
+		std::uint32_t _byteOrder;
+		std::uint64_t _capacity;
+		std::atomic<std::uint64_t> _used;
+		std::atomic<std::uint64_t> _count;
+		std::uint64_t _headOffset;
+	};
+
+	struct Record {
+		std::int32_t _key;
+		std::uint32_t _height;
+		std::atomic<std::uint32_t> _removed;
+		std::uint32_t _padding;
+		// Followed by _height atomic uint64 offsets, one per level
+	};
+
+	static const std::uint32_t Magic = 0x48534B53;	// "SKSH" read as a little-endian uint32
+	static const std::uint32_t ByteOrderMark = 0x01020304;
+
+	// recordSize
+	// Returns the number of bytes taken by a record of the given height.
+	//
+	// No-Throw Guarantee
+	static std::uint64_t recordSize(int height)
+	{
+		return sizeof(Record) + 8 * static_cast<std::uint64_t>(height);
+	}
+
+// ***** SharedSkipList: Data Members *****
+private:
+	std::string _name;
+	char * _data;
+	std::uint64_t _size;
+	bool _writable;
+
+// ***** SharedSkipList: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Creates the region name with room for capacityBytes and opens it as its writer. A region
+	// already under that name is replaced; processes that have it open keep reading the old one.
+	//
+	// Preconditions: name starts with '/'; capacityBytes is large enough for the header and head record
+	// Exceptions: Throws std::runtime_error if the region cannot be created or is too small
+	// Strong Guarantee, Exception Neutral
+	SharedSkipList(const std::string & name, std::uint64_t capacityBytes)
+		: _name(name), _data(nullptr), _size(capacityBytes / 8 * 8), _writable(true)
+	{
+		if (_size < sizeof(Header) + recordSize(MaxLevel))
+			throw std::runtime_error("SharedSkipList: capacity too small for " + name);
+		::shm_unlink(name.c_str());
+		int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+		if (fd < 0)
+			throw std::runtime_error("SharedSkipList: cannot create " + name + ": " + std::strerror(errno));
+		if (::ftruncate(fd, static_cast<off_t>(_size)) != 0)
+		{
+			int savedErrno = errno;
+			::close(fd);
+			::shm_unlink(name.c_str());
+			throw std::runtime_error("SharedSkipList: cannot size " + name + ": " + std::strerror(savedErrno));
+		}
+		map(fd, PROT_READ | PROT_WRITE);
+
+		// The region is zero-filled, so every offset of the head already marks the end of its level
+		Header * header = new (_data) Header;
+		header->_byteOrder = ByteOrderMark;
+		header->_capacity = _size;
+		header->_headOffset = sizeof(Header);
+		header->_count.store(0, std::memory_order_relaxed);
+		newRecord(header->_headOffset, std::numeric_limits<int>::min(), MaxLevel);
+		header->_used.store(header->_headOffset + recordSize(MaxLevel), std::memory_order_relaxed);
+		header->_magic.store(Magic, std::memory_order_release);
+	}
+
+	// Parameterized Constructor
+	// Opens the region name, created by a writer in this or another process, for reading.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the region cannot be opened or is not a shared skip list
+	// Strong Guarantee, Exception Neutral
+	explicit SharedSkipList(const std::string & name)
+		: _name(name), _data(nullptr), _size(0), _writable(false)
+	{
+		int fd = ::shm_open(name.c_str(), O_RDONLY, 0);
+		if (fd < 0)
+			throw std::runtime_error("SharedSkipList: cannot open " + name + ": " + std::strerror(errno));
+		struct stat status;
+		if (::fstat(fd, &status) != 0 || status.st_size < static_cast<off_t>(sizeof(Header) + recordSize(MaxLevel)))
+		{
+			::close(fd);
+			throw std::runtime_error("SharedSkipList: " + name + " is not a shared skip list");
+		}
+		_size = static_cast<std::uint64_t>(status.st_size);
+		map(fd, PROT_READ);
+
+		const Header * header = reinterpret_cast<const Header *>(_data);
+		if (header->_magic.load(std::memory_order_acquire) != Magic || header->_byteOrder != ByteOrderMark ||
+		    header->_capacity != _size || header->_headOffset != sizeof(Header))
+		{
+			::munmap(_data, _size);
+			throw std::runtime_error("SharedSkipList: " + name + " is not a shared skip list");
+		}
+	}
+
+	SharedSkipList(const SharedSkipList & other) = delete;
+	SharedSkipList & operator=(const SharedSkipList & other) = delete;
+
+	// Destructor
+	// Unmaps the region. The writer also removes its name, so no new reader can open it,
+	// while readers that have it open keep reading.
+	//
+	// No-Throw Guarantee
+	~SharedSkipList()
+	{
+		::munmap(_data, _size);
+		if (_writable)
+			::shm_unlink(_name.c_str());
+	}
+
+// ***** SharedSkipList: Public Member Functions *****
+public:
+	// insert
+	// Links a new record for key, before any records with the same key.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if this is a reader or the region is full
+	// Strong Guarantee, Exception Neutral
+	void insert(int insertKey)
+	{
+		checkWritable();
+		Header * header = reinterpret_cast<Header *>(_data);
+		int level = randomLevel();
+		std::uint64_t offset = header->_used.load(std::memory_order_relaxed);
+		if (recordSize(level) > _size - offset)
+			throw std::runtime_error("SharedSkipList: " + _name + " is full");
+
+		std::uint64_t updateOffsets[MaxLevel];
+		findPredecessors(insertKey, updateOffsets);
+		Record * record = newRecord(offset, insertKey, level);
+		for (int i = 0; i < level; i++)
+			links(record)[i].store(links(at(updateOffsets[i]))[i].load(std::memory_order_relaxed),
+			                          std::memory_order_relaxed);
+		header->_used.store(offset + recordSize(level), std::memory_order_relaxed);
+		for (int i = 0; i < level; i++)
+			links(at(updateOffsets[i]))[i].store(offset, std::memory_order_release);
+		header->_count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// remove
+	// Removes one record with key, if there is one: flags it so readers skip it, then unlinks it
+	// from the top level down.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if this is a reader
+	// Strong Guarantee, Exception Neutral
+	void remove(int removeKey)
+	{
+		checkWritable();
+		std::uint64_t updateOffsets[MaxLevel];
+		findPredecessors(removeKey, updateOffsets);
+		std::uint64_t offset = links(at(updateOffsets[0]))[0].load(std::memory_order_relaxed);
+		if (offset == 0 || at(offset)->_key != removeKey)
+			return;
+
+		// The first record with the key directly follows its predecessor on every level it is on
+		Record * record = at(offset);
+		record->_removed.store(1, std::memory_order_release);
+		for (int i = static_cast<int>(record->_height) - 1; i >= 0; i--)
+			links(at(updateOffsets[i]))[i].store(links(record)[i].load(std::memory_order_relaxed),
+			                                     std::memory_order_release);
+		reinterpret_cast<Header *>(_data)->_count.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	// search
+	// Returns true if searchKey is in the list. Touches only the records on the search path.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the search path holds an offset outside the region
+	// Strong Guarantee, Exception Neutral
+	bool search(int searchKey) const
+	{
+		for (const Record * record = lowerBound(searchKey); record && record->_key == searchKey; record = next(record, 0))
+			if (!record->_removed.load(std::memory_order_acquire))
+				return true;
+		return false;
+	}
+
+	// scan
+	// Calls visit(key) for every key in [lowKey, highKey], in sorted order. Keys inserted or removed
+	// by the writer during the scan may or may not be seen; every other key is seen exactly once.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the scan meets an offset outside the region;
+	//		throws if visit throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Visit>
+	void scan(int lowKey, int highKey, Visit visit) const
+	{
+		for (const Record * record = lowerBound(lowKey); record && record->_key <= highKey; record = next(record, 0))
+			if (!record->_removed.load(std::memory_order_acquire))
+				visit(record->_key);
+	}
+
+	// range
+	// Returns the keys in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: None
+	// Exceptions: As scan; throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<int> range(int lowKey, int highKey) const
+	{
+		std::vector<int> result;
+		scan(lowKey, highKey, [&result](int key) { result.push_back(key); });
+		return result;
+	}
+
+	// size, bytesUsed, capacity
+	// Number of keys, bytes of the region allocated so far, including removed records, and its size.
+	//
+	// No-Throw Guarantee
+	std::uint64_t size() const
+	{
+		return reinterpret_cast<const Header *>(_data)->_count.load(std::memory_order_relaxed);
+	}
+
+	std::uint64_t bytesUsed() const
+	{
+		return reinterpret_cast<const Header *>(_data)->_used.load(std::memory_order_relaxed);
+	}
+
+	std::uint64_t capacity() const
+	{
+		return _size;
+	}
+
+// ***** SharedSkipList: Private Member Functions *****
+private:
+	// map
+	// Maps the region open on fd with the given protection and closes fd.
+	//
+	// Exceptions: Throws std::runtime_error if the region cannot be mapped
+	// Strong Guarantee, Exception Neutral
+	void map(int fd, int protection)
+	{
+		void * mapping = ::mmap(nullptr, _size, protection, MAP_SHARED, fd, 0);
+		int savedErrno = errno;
+		::close(fd);
+		if (mapping == MAP_FAILED)
+		{
+			if (_writable)
+				::shm_unlink(_name.c_str());
+			throw std::runtime_error("SharedSkipList: cannot map " + _name + ": " + std::strerror(savedErrno));
+		}
+		_data = static_cast<char *>(mapping);
+	}
+
+	// checkWritable
+	// Throws std::runtime_error unless this process is the region's writer.
+	//
+	// Strong Guarantee
+	void checkWritable() const
+	{
+		if (!_writable)
+			throw std::runtime_error("SharedSkipList: " + _name + " is open for reading only");
+	}
+
+	// at, links
+	// The record at a checked offset, and its array of next offsets.
+	//
+	// No-Throw Guarantee
+	Record * at(std::uint64_t offset) const
+	{
+		return reinterpret_cast<Record *>(_data + offset);
+	}
+
+	static std::atomic<std::uint64_t> * links(const Record * record)
+	{
+		return reinterpret_cast<std::atomic<std::uint64_t> *>(const_cast<Record *>(record) + 1);
+	}
+
+	// newRecord
+	// Constructs an unlinked record with every next offset 0 at offset.
+	//
+	// Preconditions: The writer owns recordSize(height) unused bytes at offset
+	// No-Throw Guarantee
+	Record * newRecord(std::uint64_t offset, int key, int height)
+	{
+		Record * record = new (_data + offset) Record;
+		record->_key = key;
+		record->_height = static_cast<std::uint32_t>(height);
+		record->_removed.store(0, std::memory_order_relaxed);
+		for (int i = 0; i < height; i++)
+			new (links(record) + i) std::atomic<std::uint64_t>(0);
+		return record;
+	}
+
+	// next
+	// Returns the record after record on the given level, nullptr at the end of the level.
+	// The offset must point to a whole, aligned record inside the region that reaches the level.
+	//
+	// Preconditions: record is a checked record of this region with _height > level
+	// Exceptions: Throws std::runtime_error if the offset is corrupt
+	// Strong Guarantee, Exception Neutral
+	const Record * next(const Record * record, int level) const
+	{
+		std::uint64_t offset = links(record)[level].load(std::memory_order_acquire);
+		if (offset == 0)
+			return nullptr;
+		if (offset % 8 != 0 || offset > _size || sizeof(Record) > _size - offset)
+			throw std::runtime_error("SharedSkipList: corrupt offset in " + _name);
+		const Record * nextRecord = at(offset);
+		if (nextRecord->_height <= static_cast<std::uint32_t>(level) || nextRecord->_height > MaxLevel ||
+		    recordSize(static_cast<int>(nextRecord->_height)) > _size - offset)
+			throw std::runtime_error("SharedSkipList: corrupt record in " + _name);
+		return nextRecord;
+	}
+
+	// lowerBound
+	// Returns the first record with _key >= searchKey, removed or not; nullptr if there is none.
+	//
+	// Exceptions: Throws std::runtime_error if the search path holds a corrupt offset
+	// Strong Guarantee, Exception Neutral
+	const Record * lowerBound(int searchKey) const
+	{
+		const Record * currentRecord = at(reinterpret_cast<const Header *>(_data)->_headOffset);
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			const Record * nextRecord = next(currentRecord, i);
+			while (nextRecord && nextRecord->_key < searchKey)
+			{
+				currentRecord = nextRecord;
+				nextRecord = next(currentRecord, i);
+			}
+		}
+		return next(currentRecord, 0);
+	}
+
+	// findPredecessors
+	// Sets updateOffsets[i] to the offset of the last record on level i with _key < key.
+	//
+	// Preconditions: This is the writer
+	// No-Throw Guarantee
+	void findPredecessors(int key, std::uint64_t updateOffsets[MaxLevel]) const
+	{
+		std::uint64_t currentOffset = reinterpret_cast<const Header *>(_data)->_headOffset;
+		for (int i = MaxLevel - 1; i >= 0; i--) {
+			std::uint64_t nextOffset = links(at(currentOffset))[i].load(std::memory_order_relaxed);
+			while (nextOffset != 0 && at(nextOffset)->_key < key)
+			{
+				currentOffset = nextOffset;
+				nextOffset = links(at(currentOffset))[i].load(std::memory_order_relaxed);
+			}
+			updateOffsets[i] = currentOffset;
+		}
+	}
+};
+
+#endif // #ifndef FILE_SKIPLIST_SHM_H_INCLUDED
@@ -5,11 +5,23 @@
 // For CS 311 Fall 2017
 // Tests for class SkipList
 // Uses the "Catch" unit-testing framework
-// Requires skiplist_test_main.cpp, catch.hpp, skiplist.h
+// Requires skiplist_test_main.cpp, catch.hpp, skiplist.h, skiplist_pq.h, skiplist_rcu.h, skiplist_buffered.h, skiplist_mmap.h, skiplist_wal.h, skiplist_lsm.h, skiplist_checkpoint.h, skiplist_shm.h,
+//	skiplist_compressed.h, skiplist_trace.h, skiplist_pool.h
 
 // Includes for code to be tested
 #include "skiplist.h"				// For class SkipList
 #include "skiplist.h"				// Double inclusion test
+#include "skiplist_pq.h"			// For class SkipListPriorityQueue
+#include "skiplist_rcu.h"			// For class RcuSkipList
+#include "skiplist_buffered.h"		// For class BufferedSkipList
+#include "skiplist_mmap.h"			// For class MappedSkipList
+#include "skiplist_wal.h"			// For classes WriteAheadLog, DurableSkipList
+#include "skiplist_lsm.h"			// For classes Memtable, SortedRun, MergingIterator, LsmStore
+#include "skiplist_checkpoint.h"	// For class CheckpointedSkipList
+#include "skiplist_shm.h"			// For class SharedSkipList
+#include "skiplist_compressed.h"	// For class CompressedSkipList
+#include "skiplist_trace.h"			// For class TracingInstrumentation
+#include "skiplist_pool.h"			// For classes NodePool, PoolAllocator, ArenaAllocator
 
 // Includes and settings for Catch framework
 #include "catch.hpp"				// For the "Catch" unit-testing framework
@@ -19,15 +31,25 @@
 #include <limits>					// for std::numeric_limits
 #include <vector>					// for std::vector
 #include <algorithm>				// for std::sort, std::generate
-#include <random>					// for std::random_device, std::minstd_rand, std::uniform_int_distribution
+#include <random>					// for std::random_device, std::minstd_rand, std::uniform_int_distribution, std::uniform_real_distribution
 #include <iostream>					// for std::cout, std::endl
+#include <thread>					// for std::thread
+#include <atomic>					// for std::atomic
+#include <cstdio>					// for std::remove
+#include <fstream>					// for std::ofstream, std::ifstream, std::fstream
+#include <memory>					// for std::unique_ptr
+#include <chrono>					// for std::chrono::steady_clock, std::chrono::milliseconds
+#include <unistd.h>					// for fork, _exit, access
+#include <sys/wait.h>				// for waitpid
+#include <sys/socket.h>				// for socketpair
+#include <cmath>					// for std::sqrt
 
 // *********************************************************************
 // Utility Functions
 // *********************************************************************
 
 // Random Number Generator
-// Returns a random integer between 2,147,483,648 and 2,147,483,647
+// Returns a random integer between �2,147,483,648 and 2,147,483,647
 // 
 // Preconditions: None
 // No-Throw Guarantee
@@ -295,3 +317,2323 @@ TEST_CASE("SkipList Removals", "[member functions]")
 		}
 	}
 }
+
+TEST_CASE("SkipListPriorityQueue", "[priority queue]")
+// Tests that popMin returns keys in sorted order, that sprayPopMin eventually returns every key exactly once,
+// and that concurrent consumers never lose or duplicate a key.
+{
+	SECTION("popMin returns keys in order.")
+	{
+		SkipListPriorityQueue queue(4);
+		std::vector<int> testInts = { 0, -37, 42, 178, 91, -9999, 777, 9999, 3, 400 };
+		for (auto i : testInts)
+			queue.push(i);
+		std::sort(testInts.begin(), testInts.end());
+
+		std::vector<int> resultInts;
+		int key;
+		while (queue.popMin(key))
+			resultInts.push_back(key);
+		{
+			INFO("Keys are popped in sorted order.");
+			REQUIRE(resultInts == testInts);
+		}
+		{
+			INFO("Queue is empty after popping every key.");
+			REQUIRE(queue.empty());
+			REQUIRE(!queue.popMin(key));
+			REQUIRE(!queue.sprayPopMin(key));
+		}
+	}
+
+	SECTION("sprayPopMin returns every key exactly once, near the front.")
+	{
+		SkipListPriorityQueue queue(8);
+		std::vector<int> testInts(1000);
+		for (int i = 0; i < 1000; i++)
+			testInts[i] = i;
+		for (auto i : testInts)
+			queue.push(i);
+
+		std::vector<int> resultInts;
+		int key;
+		long long totalRank = 0;
+		while (queue.sprayPopMin(key))
+		{
+			// Keys popped so far occupy ranks below the current front, so the rank of this key
+			// among those still queued is how far the spray landed from the minimum.
+			int rank = key - static_cast<int>(std::count_if(resultInts.begin(), resultInts.end(),
+			                                                [key](int k) { return k < key; }));
+			totalRank += rank;
+			resultInts.push_back(key);
+		}
+		std::sort(resultInts.begin(), resultInts.end());
+		{
+			INFO("Every key was popped exactly once.");
+			REQUIRE(resultInts == testInts);
+		}
+		{
+			// The landing spot is random, so bound the average rather than the worst spray
+			double meanRank = static_cast<double>(totalRank) / testInts.size();
+			INFO("Spray stays near the front of the queue (landed " << meanRank << " keys from the minimum on average).");
+			REQUIRE(meanRank < 250);
+		}
+	}
+
+	SECTION("Concurrent consumers pop every key exactly once.")
+	{
+		const int consumers = 4;
+		const int testNumber = 20000;
+		SkipListPriorityQueue queue(consumers);
+		for (int i = 0; i < testNumber; i++)
+			queue.push(i);
+
+		std::vector<std::vector<int>> popped(consumers);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < consumers; t++)
+			threads.emplace_back([&queue, &popped, t]() {
+				int key;
+				while ((t % 2) ? queue.sprayPopMin(key) : queue.popMin(key))
+					popped[t].push_back(key);
+			});
+		for (auto & thread : threads)
+			thread.join();
+
+		std::vector<int> resultInts;
+		for (auto & keys : popped)
+			resultInts.insert(resultInts.end(), keys.begin(), keys.end());
+		std::sort(resultInts.begin(), resultInts.end());
+		std::vector<int> testInts(testNumber);
+		for (int i = 0; i < testNumber; i++)
+			testInts[i] = i;
+		{
+			INFO("Every key was popped exactly once.");
+			REQUIRE(resultInts == testInts);
+		}
+	}
+
+	SECTION("Producers and consumers run at the same time.")
+	{
+		const int producers = 2;
+		const int consumers = 4;
+		const int perProducer = 10000;
+		SkipListPriorityQueue queue(consumers);
+		std::atomic<int> producing(producers);
+		std::vector<std::vector<int>> popped(consumers);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < producers; t++)
+			threads.emplace_back([&queue, &producing, t]() {
+				for (int i = 0; i < perProducer; i++)
+					queue.push(i * producers + t);
+				producing--;
+			});
+		for (int t = 0; t < consumers; t++)
+			threads.emplace_back([&queue, &producing, &popped, t]() {
+				int key;
+				while (true)
+				{
+					bool stillProducing = producing.load() > 0;
+					if ((t % 2) ? queue.sprayPopMin(key) : queue.popMin(key))
+						popped[t].push_back(key);
+					else if (!stillProducing)
+						return;
+				}
+			});
+		for (auto & thread : threads)
+			thread.join();
+
+		std::vector<int> resultInts;
+		for (auto & keys : popped)
+			resultInts.insert(resultInts.end(), keys.begin(), keys.end());
+		std::sort(resultInts.begin(), resultInts.end());
+		std::vector<int> testInts(producers * perProducer);
+		for (int i = 0; i < producers * perProducer; i++)
+			testInts[i] = i;
+		{
+			INFO("Every key pushed was popped exactly once.");
+			REQUIRE(resultInts == testInts);
+		}
+	}
+}
+
+TEST_CASE("SkipList Snapshots", "[snapshots]")
+// Tests that a snapshot keeps seeing the keys present when it was taken while the list changes,
+// and that removed nodes are unlinked once no snapshot can see them.
+{
+	SECTION("Snapshot ignores later inserts and removes.")
+	{
+		SkipList testList = SkipList();
+		std::vector<int> testInts = { 0, -37, 42, 178, 91, -9999, 777, 9999, 3, 400 };
+		for (auto i : testInts)
+			testList.insert(i);
+		std::sort(testInts.begin(), testInts.end());
+
+		auto snapshot = testList.snapshot();
+		testList.insert(500);
+		testList.remove(91);
+		testList.remove(-9999);
+		{
+			INFO("The list sees its own writes.");
+			REQUIRE(testList.search(500));
+			REQUIRE(!testList.search(91));
+			REQUIRE(!testList.search(-9999));
+		}
+		{
+			INFO("The snapshot does not see writes made after it was taken.");
+			REQUIRE(!snapshot.search(500));
+			REQUIRE(snapshot.search(91));
+			REQUIRE(snapshot.search(-9999));
+			REQUIRE(snapshot.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+		{
+			INFO("Range on the list reflects the writes.");
+			std::vector<int> expected = { -37, 0, 3, 42, 178, 400, 500, 777 };
+			REQUIRE(testList.range(-100, 1000) == expected);
+		}
+	}
+
+	SECTION("Removed nodes are unlinked after the snapshot is released.")
+	{
+		SkipList testList = SkipList();
+		for (int i = 0; i < 100; i++)
+			testList.insert(i % 10);
+		std::weak_ptr<SkipListNode> removed;
+		{
+			auto snapshot = testList.snapshot();
+			removed = testList.search(5);
+			for (int i = 0; i < 10; i++)
+				testList.remove(5);
+			REQUIRE(!testList.search(5));
+			REQUIRE(snapshot.range(5, 5).size() == 10);
+			testList.collectGarbage();
+			INFO("Nodes visible to an open snapshot stay alive.");
+			REQUIRE(!removed.expired());
+		}
+		testList.collectGarbage();
+		{
+			INFO("Nodes are released once no snapshot can see them.");
+			REQUIRE(removed.expired());
+		}
+		std::vector<int> resultInts;
+		for (auto node = testList._head->_forwardNodes[0]; node != testList._tail; node = node->_forwardNodes[0])
+			resultInts.push_back(node->_key);
+		{
+			INFO("Only the removed keys were unlinked.");
+			REQUIRE(resultInts.size() == 90);
+			REQUIRE(std::find(resultInts.begin(), resultInts.end(), 5) == resultInts.end());
+		}
+	}
+
+	SECTION("A snapshot scan may write to the list from its visitor.")
+	{
+		SkipList testList;
+		for (int i = 0; i < 100; i++)
+			testList.insert(i);
+		std::vector<int> expected = testList.range(0, 99);
+		std::vector<int> resultInts;
+		{
+			auto older = testList.snapshot();
+			for (int i = 0; i < 100; i += 2)
+				testList.remove(i);
+			auto snapshot = testList.snapshot();
+			expected = snapshot.range(0, 99);
+			{
+				// Dropping the older snapshot lets the visitor's writes collect the nodes it kept
+				auto released = std::move(older);
+			}
+			snapshot.scan(0, 99, [&testList, &resultInts](int key) {
+				resultInts.push_back(key);
+				testList.remove(key);
+				testList.insert(key + 1000);
+			});
+		}
+		{
+			INFO("The scan sees the snapshot's state while its visitor removes and inserts keys.");
+			REQUIRE(resultInts == expected);
+			REQUIRE(testList.range(0, 99).empty());
+		}
+	}
+}
+
+TEST_CASE("RcuSkipList", "[rcu]")
+// Tests that the read-mostly list behaves like SkipList for single-threaded use
+// and that concurrent readers only ever see states between two writes.
+{
+	SECTION("Insert, search and remove.")
+	{
+		RcuSkipList testList;
+		std::vector<int> testInts = { 0, -37, 42, 178, 91, -9999, 777, 9999, 3, 400 };
+		for (auto i : testInts)
+			testList.insert(i);
+		std::sort(testInts.begin(), testInts.end());
+		{
+			INFO("All items were inserted in sorted order.");
+			REQUIRE(testList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+		testList.remove(91);
+		testList.remove(300);
+		testList.reclaim();
+		{
+			INFO("Removed item is gone and the others remain.");
+			REQUIRE(!testList.search(91));
+			REQUIRE(testList.search(400));
+			REQUIRE(testList.range(-100, 1000).size() == 7);
+		}
+	}
+
+	SECTION("Readers see a consistent state while a writer runs.")
+	{
+		// The writer moves a single token forward by inserting its successor before removing it,
+		// so every consistent state holds one or two adjacent keys.
+		RcuSkipList testList;
+		testList.insert(0);
+		std::atomic<bool> done(false);
+		std::atomic<int> badReads(0);
+		std::vector<std::thread> readers;
+		for (int t = 0; t < 3; t++)
+			readers.emplace_back([&]() {
+				while (!done.load())
+				{
+					auto keys = testList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+					if (keys.empty() || keys.size() > 2 || (keys.size() == 2 && keys[1] != keys[0] + 1))
+						badReads++;
+				}
+			});
+		for (int i = 0; i < 5000; i++)
+		{
+			testList.insert(i + 1);
+			testList.remove(i);
+		}
+		done = true;
+		for (auto & reader : readers)
+			reader.join();
+		testList.reclaim();
+		{
+			INFO("No reader saw a state in the middle of a write.");
+			REQUIRE(badReads.load() == 0);
+		}
+		{
+			INFO("The token reached its final position.");
+			REQUIRE(testList.search(5000));
+			REQUIRE(!testList.search(4999));
+		}
+	}
+
+	SECTION("Removed nodes are freed while readers keep reading.")
+	{
+		RcuSkipList testList;
+		const int testNumber = 20000;
+		for (int i = 0; i < testNumber; i++)
+			testList.insert(i);
+		std::atomic<bool> done(false);
+		std::vector<std::thread> readers;
+		for (int t = 0; t < 3; t++)
+			readers.emplace_back([&]() {
+				for (int i = 0; !done.load(); i = (i + 7919) % testNumber)
+					testList.search(i);
+			});
+		for (int i = 0; i < testNumber; i++)
+		{
+			testList.remove(i);
+			// Let the readers run even on one core, where a reader preempted while pinned holds back
+			// everything retired during the writer's time slice
+			if (i % 1000 == 999)
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		testList.reclaim();
+		std::size_t waiting = testList.retiredCount();
+		done = true;
+		for (auto & reader : readers)
+			reader.join();
+		{
+			INFO("Readers that never stop hold back only the nodes retired while they were pinned ("
+			     << waiting << " of " << testNumber << " still waiting).");
+			REQUIRE(waiting < static_cast<std::size_t>(testNumber) / 2);
+		}
+		testList.reclaim();
+		{
+			INFO("Once the readers are gone everything is freed.");
+			REQUIRE(testList.retiredCount() == 0);
+		}
+	}
+}
+
+TEST_CASE("SkipList Batch Insertions", "[member functions]")
+// Tests that insertBatch gives the same list as inserting the keys one at a time.
+{
+	SECTION("Insert an unsorted batch into a non-empty list.")
+	{
+		SkipList testList = SkipList();
+		std::vector<int> testInts = { 0, -37, 42, 178, 91, -9999, 777, 9999, 3, 400 };
+		for (auto i : testInts)
+			testList.insert(i);
+		std::vector<int> batch = { 5, 1000, -5, 42, 0, 10000 };
+		testList.insertBatch(batch);
+		testInts.insert(testInts.end(), batch.begin(), batch.end());
+		std::sort(testInts.begin(), testInts.end());
+		{
+			INFO("All items were inserted in sorted order.");
+			REQUIRE(testList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+	}
+}
+
+TEST_CASE("SkipList Instrumentation", "[instrumentation]")
+// Tests that CountingInstrumentation counts every operation, that its hop counts show a healthy
+// list's search paths are short, and that they expose a list whose towers have collapsed.
+{
+	auto total = [](const unsigned long long * counts, int size) {
+		unsigned long long sum = 0;
+		for (int i = 0; i < size; i++)
+			sum += counts[i];
+		return sum;
+	};
+	const int histogramBuckets = SkipListOperationStats::HistogramBuckets;
+
+	SECTION("Every search, insert and remove is counted once.")
+	{
+		BasicSkipList<CountingInstrumentation> testList;
+		for (int i = 0; i < 10000; i++)
+			testList.insert((i * 7919) % 10000);
+		int found = 0;
+		for (int i = 0; i < 2000; i++)
+			found += testList.search(i * 5) ? 1 : 0;
+		REQUIRE(found == 2000);
+		REQUIRE_FALSE(testList.search(-1));
+		for (int i = 0; i < 500; i++)
+			testList.remove(i);
+		SkipListStats stats = testList.stats();
+		{
+			INFO("Each operation lands in one bucket of each histogram and has one starting level.");
+			REQUIRE(stats.insert.operations == 10000);
+			REQUIRE(stats.search.operations == 2001);
+			REQUIRE(stats.remove.operations == 500);
+			REQUIRE(total(stats.search.hopHistogram, histogramBuckets) == 2001);
+			REQUIRE(total(stats.search.comparisonHistogram, histogramBuckets) == 2001);
+			REQUIRE(total(stats.insert.startLevels, MaxLevel) == 10000);
+			REQUIRE(stats.search.comparisonHistogram[0] == 0);
+		}
+		{
+			INFO("A healthy list of 10000 keys starts searches high and takes a few dozen hops at most.");
+			unsigned long long hops = total(stats.search.hopsByLevel, MaxLevel);
+			REQUIRE(hops / stats.search.operations < 40);
+			REQUIRE(total(stats.search.startLevels + 4, MaxLevel - 4) > stats.search.operations / 2);
+		}
+		testList.instrumentation().reset();
+		{
+			INFO("reset clears every count.");
+			REQUIRE(testList.stats().insert.operations == 0);
+			REQUIRE(total(testList.stats().search.hopsByLevel, MaxLevel) == 0);
+		}
+	}
+
+	SECTION("A list with no towers shows every hop on level 0.")
+	{
+		BasicSkipList<CountingInstrumentation> testList;
+		BasicSkipList<CountingInstrumentation>::Builder builder(testList);
+		for (int i = 0; i < 1000; i++)
+			builder.append(i, 1);
+		int found = 0;
+		for (int i = 0; i < 100; i++)
+			found += testList.search(999 - i) ? 1 : 0;
+		REQUIRE(found == 100);
+		SkipListStats stats = testList.stats();
+		{
+			INFO("Searches start on level 0 and walk the list end to end.");
+			REQUIRE(stats.search.startLevels[0] == 100);
+			REQUIRE(stats.search.hopsByLevel[0] == total(stats.search.hopsByLevel, MaxLevel));
+			REQUIRE(stats.search.hopsByLevel[0] / 100 > 900);
+		}
+	}
+}
+
+TEST_CASE("SkipList Health Report", "[instrumentation]")
+// Tests that analyze reports level counts near their expected values and search paths within Pugh's
+// bound for a random list, exposes a list with no towers, and can be run a step at a time on a live list.
+{
+	SkipList testList;
+
+	SECTION("A random list matches the expected shape.")
+	{
+		// Pugh's bound is on the expected path over random lists, and the mean of one list strays above
+		// it now and then, so the heights come from a seeded generator to make the check repeatable
+		{
+			SkipList::Builder builder(testList);
+			std::minstd_rand generator(2026);
+			std::uniform_real_distribution<double> random(0.0, 1.0);
+			for (int i = 0; i < 100000; i++)
+			{
+				int height = 1;
+				while (random(generator) < proportion && height < MaxLevel)
+					height++;
+				builder.append(i, height);
+			}
+		}
+		SkipListReport report = testList.analyze();
+		{
+			INFO("Every node is on level 0 and the upper levels hold about a quarter of the level below.");
+			REQUIRE(report.nodes == 100000);
+			REQUIRE(report.levelCounts[0] == 100000);
+			for (int i = 1; i <= 4; i++)
+			{
+				// Within five standard deviations of the binomial count
+				double tolerance = 5 * std::sqrt(report.expectedLevelCounts[i]);
+				REQUIRE(report.levelCounts[i] > report.expectedLevelCounts[i] - tolerance);
+				REQUIRE(report.levelCounts[i] < report.expectedLevelCounts[i] + tolerance);
+			}
+			REQUIRE(report.height >= 7);
+		}
+		{
+			INFO("Search paths stay within Pugh's bound on average.");
+			REQUIRE(report.meanSearchPath > report.height);
+			REQUIRE(report.meanSearchPath < report.expectedSearchPath);
+			REQUIRE(report.maxSearchPath >= report.meanSearchPath);
+		}
+		{
+			INFO("The memory breakdown adds up and shows most link slots unused.");
+			REQUIRE(report.keyBytes == 100000 * sizeof(int));
+			REQUIRE(report.keyBytes + report.linkBytes + report.unusedLinkBytes + report.otherNodeBytes +
+			        report.allocatorOverheadBytes == report.totalBytes);
+			REQUIRE(report.unusedLinkBytes > 10 * report.linkBytes);
+			REQUIRE(report.fragmentation > 0.8);
+		}
+	}
+
+	SECTION("A list with no towers has search paths as long as the list.")
+	{
+		SkipList::Builder builder(testList);
+		for (int i = 0; i < 1000; i++)
+			builder.append(i, 1);
+		SkipListReport report = testList.analyze();
+		{
+			INFO("All nodes are on level 0 and the last key is 999 hops from the head.");
+			REQUIRE(report.height == 1);
+			REQUIRE(report.levelCounts[1] == 0);
+			REQUIRE(report.maxSearchPath == 999);
+			REQUIRE(report.meanSearchPath > 400);
+		}
+	}
+
+	SECTION("An Analyzer reports the list as it was while the list changes between steps.")
+	{
+		for (int i = 0; i < 10000; i++)
+			testList.insert(2 * i);
+		SkipList::Analyzer analyzer(testList);
+		int steps = 0;
+		for (int key = 1; analyzer.step(500); key += 2, steps++)
+		{
+			testList.insert(key);
+			testList.remove(key - 1);
+		}
+		SkipListReport report = analyzer.report();
+		{
+			INFO("The report counts the 10000 keys of the snapshot in about 20 steps.");
+			REQUIRE(steps >= 19);
+			REQUIRE(report.nodes == 10000);
+			REQUIRE(report.levelCounts[0] == 10000);
+		}
+	}
+}
+
+TEST_CASE("SkipList Tracing", "[instrumentation]")
+// Tests that TracingInstrumentation records one timed event per operation, keeps the latest
+// events when a ring wraps, gives each thread one ring per traced list, and that dumps read back and
+// convert to JSON.
+{
+	const std::string tracePath = "skiplist_test.sktr";
+	const std::string jsonPath = "skiplist_test.json";
+	std::remove(tracePath.c_str());
+	std::remove(jsonPath.c_str());
+
+	SECTION("Each operation becomes one event that survives a dump.")
+	{
+		BasicSkipList<TracingInstrumentation> testList;
+		for (int i = 0; i < 1000; i++)
+			testList.insert((i * 7919) % 1000);
+		int found = 0;
+		for (int i = 0; i < 1000; i++)
+			found += testList.search(i) ? 1 : 0;
+		REQUIRE(found == 1000);
+		for (int i = 0; i < 100; i++)
+			testList.remove(i);
+		REQUIRE(testList.instrumentation().dump(tracePath) == 2100);
+
+		std::uint64_t ticksPerSecond = 0;
+		std::vector<TraceEvent> events = TracingInstrumentation::readTrace(tracePath, ticksPerSecond);
+		REQUIRE(events.size() == 2100);
+		REQUIRE(ticksPerSecond > 0);
+		int counts[SkipListOperations] = {};
+		int ordered = 0, walked = 0, sameThread = 0;
+		for (std::size_t i = 0; i < events.size(); i++)
+		{
+			if (events[i]._operation < SkipListOperations)
+				counts[events[i]._operation]++;
+			ordered += events[i]._start <= events[i]._end && (i == 0 || events[i - 1]._start <= events[i]._start);
+			walked += events[i]._levels > 0 && events[i]._levels <= MaxLevel;
+			sameThread += events[i]._thread == 0;
+		}
+		{
+			INFO("The events are the 1000 inserts, 1000 searches and 100 removes, in order.");
+			REQUIRE(counts[SkipListInsert] == 1000);
+			REQUIRE(counts[SkipListSearch] == 1000);
+			REQUIRE(counts[SkipListRemove] == 100);
+			REQUIRE(ordered == 2100);
+			REQUIRE(sameThread == 2100);
+			REQUIRE(walked > 1900);
+		}
+		{
+			INFO("The same key always hashes the same and different keys differ.");
+			REQUIRE(events[0]._keyHash == events[1000]._keyHash);
+			REQUIRE(events[0]._keyHash == events[2000]._keyHash);
+			REQUIRE(events[1000]._keyHash != events[1001]._keyHash);
+		}
+		{
+			INFO("The Chrome trace holds one complete event per operation.");
+			REQUIRE(TracingInstrumentation::writeChromeTrace(tracePath, jsonPath) == 2100);
+			std::ifstream json(jsonPath);
+			std::string text((std::istreambuf_iterator<char>(json)), std::istreambuf_iterator<char>());
+			std::size_t complete = 0;
+			for (std::size_t at = text.find("\"ph\":\"X\""); at != std::string::npos; at = text.find("\"ph\":\"X\"", at + 1))
+				complete++;
+			REQUIRE(complete == 2100);
+			REQUIRE(text.find("\"name\":\"remove\"") != std::string::npos);
+			REQUIRE(text.find("traceEvents") != std::string::npos);
+		}
+	}
+
+	SECTION("A full ring keeps its latest events.")
+	{
+		BasicSkipList<TracingInstrumentation> testList;
+		const std::size_t ringEvents = TracingInstrumentation::RingEvents;
+		const int operations = static_cast<int>(ringEvents) + 500;
+		for (int i = 0; i < operations; i++)
+			testList.search(i);
+		testList.insert(7);
+		{
+			INFO("The oldest slot is the next to be overwritten, so it is left out.");
+			REQUIRE(testList.instrumentation().dump(tracePath) == ringEvents - 1);
+		}
+		std::uint64_t ticksPerSecond = 0;
+		std::vector<TraceEvent> events = TracingInstrumentation::readTrace(tracePath, ticksPerSecond);
+		REQUIRE(events.back()._operation == SkipListInsert);
+	}
+
+	SECTION("Threads record into rings of their own.")
+	{
+		BasicSkipList<TracingInstrumentation> testList;
+		for (int i = 0; i < 1000; i++)
+			testList.insert(i);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < 4; t++)
+			threads.emplace_back([&testList]() {
+				for (int i = 0; i < 1000; i++)
+					testList.search(i);
+			});
+		for (auto & thread : threads)
+			thread.join();
+		REQUIRE(testList.instrumentation().dump(tracePath) == 5000);
+		std::uint64_t ticksPerSecond = 0;
+		std::vector<TraceEvent> events = TracingInstrumentation::readTrace(tracePath, ticksPerSecond);
+		int perThread[5] = {};
+		for (const auto & event : events)
+			if (event._thread < 5)
+				perThread[event._thread]++;
+		for (int t = 0; t < 5; t++)
+			REQUIRE(perThread[t] == 1000);
+	}
+
+	SECTION("A thread that alternates between traced lists keeps one ring in each.")
+	{
+		BasicSkipList<TracingInstrumentation> firstList, secondList;
+		std::thread worker([&firstList, &secondList]() {
+			for (int i = 0; i < 3000; i++)
+			{
+				firstList.insert(i);
+				secondList.search(i);
+			}
+		});
+		worker.join();
+		secondList.search(0);
+		const std::string secondPath = "skiplist_test_second.sktr";
+		REQUIRE(firstList.instrumentation().dump(tracePath) == 3000);
+		REQUIRE(secondList.instrumentation().dump(secondPath) == 3001);
+		std::uint64_t ticksPerSecond = 0;
+		std::vector<TraceEvent> first = TracingInstrumentation::readTrace(tracePath, ticksPerSecond);
+		std::vector<TraceEvent> second = TracingInstrumentation::readTrace(secondPath, ticksPerSecond);
+		std::remove(secondPath.c_str());
+		int firstRing = 0, secondRing = 0;
+		for (const auto & event : first)
+			firstRing += event._thread == 0;
+		for (const auto & event : second)
+			secondRing += event._thread == 0;
+		{
+			INFO("The worker's events share one ring per list, and the main thread gets the next.");
+			REQUIRE(firstRing == 3000);
+			REQUIRE(secondRing == 3000);
+			REQUIRE(second.back()._thread == 1);
+		}
+	}
+
+	SECTION("A file that is not a trace is rejected.")
+	{
+		std::ofstream(tracePath) << "not a trace";
+		std::uint64_t ticksPerSecond = 0;
+		REQUIRE_THROWS_AS(TracingInstrumentation::readTrace(tracePath, ticksPerSecond), const std::runtime_error &);
+	}
+
+	std::remove(tracePath.c_str());
+	std::remove(jsonPath.c_str());
+}
+
+TEST_CASE("SkipList Allocators", "[allocator]")
+// Tests that every node comes from the list's Allocator, that CountingAllocator counts each list
+// separately and tracks its peak, and that a loaded list keeps allocating from the same allocator.
+{
+	typedef BasicSkipList<NoInstrumentation, CountingAllocator<SkipListNode>> CountedSkipList;
+	CountingAllocator<SkipListNode> counter;
+
+	SECTION("Each node is one allocation, freed when the list is destroyed.")
+	{
+		{
+			CountedSkipList testList(counter);
+			{
+				INFO("The head and tail are allocated by the constructor.");
+				REQUIRE(counter.stats().allocations == 2);
+				REQUIRE(testList.allocator() == counter);
+			}
+			for (int i = 0; i < 1000; i++)
+				testList.insert((i * 7919) % 1000);
+			AllocationStats stats = counter.stats();
+			{
+				INFO("Each insert allocates one block for the node and its control block.");
+				REQUIRE(stats.allocations == 1002);
+				REQUIRE(stats.deallocations == 0);
+				REQUIRE(stats.allocatedBytes == stats.liveBytes);
+				REQUIRE(stats.liveBytes % 1002 == 0);
+				REQUIRE(stats.liveBytes / 1002 >= sizeof(SkipListNode));
+				REQUIRE(stats.peakBytes == stats.liveBytes);
+			}
+			for (int i = 0; i < 500; i++)
+				testList.remove(i);
+			{
+				INFO("Removes free their nodes and leave the peak where it was.");
+				REQUIRE(counter.stats().deallocations == 500);
+				REQUIRE(counter.stats().liveBytes == stats.liveBytes / 2 + stats.liveBytes / 1002);
+				REQUIRE(counter.stats().peakBytes == stats.peakBytes);
+			}
+		}
+		INFO("Nothing is left once the list is gone.");
+		REQUIRE(counter.stats().liveBytes == 0);
+		REQUIRE(counter.stats().allocations == counter.stats().deallocations);
+	}
+
+	SECTION("Lists with their own allocators count separately.")
+	{
+		CountedSkipList firstList(counter);
+		CountedSkipList secondList;
+		for (int i = 0; i < 100; i++)
+			firstList.insert(i);
+		secondList.insert(1);
+		REQUIRE(counter.stats().allocations == 102);
+		REQUIRE(secondList.allocator().stats().allocations == 3);
+		REQUIRE_FALSE(secondList.allocator() == counter);
+	}
+
+	SECTION("A loaded list allocates from the list's allocator.")
+	{
+		const std::string path = "skiplist_test_allocator.skl";
+		{
+			SkipList savedList;
+			for (int i = 0; i < 100; i++)
+				savedList.insert(i);
+			savedList.save(path);
+		}
+		{
+			CountedSkipList testList(counter);
+			testList.load(path);
+			REQUIRE(testList.range(0, 99).size() == 100);
+			REQUIRE(counter.stats().allocations == 104);
+			REQUIRE(counter.stats().deallocations == 2);
+		}
+		REQUIRE(counter.stats().liveBytes == 0);
+		std::remove(path.c_str());
+	}
+}
+
+TEST_CASE("PooledSkipList", "[allocator]")
+// Tests that a PooledSkipList keeps every key it is given, recycles removed nodes instead of
+// taking more slabs, and that lists sharing a PoolAllocator share its pool.
+{
+	SECTION("Removed nodes are reused by later inserts.")
+	{
+		PoolAllocator<SkipListNode> allocator;
+		{
+			PooledSkipList testList(allocator);
+			for (int i = 0; i < 5000; i++)
+				testList.insert((i * 7919) % 5000);
+			PoolStats grown = allocator.pool().stats();
+			{
+				INFO("The nodes are carved from a few slabs.");
+				REQUIRE(grown.blocksInUse == 5002);
+				REQUIRE(grown.slabs > 1);
+				REQUIRE(grown.slabs < 5002 / 10);
+				REQUIRE(grown.reservedBytes >= grown.slabs * NodePool::SlabBytes / 2);
+				REQUIRE(grown.bytesInUse >= grown.blocksInUse * sizeof(SkipListNode));
+				REQUIRE(grown.bytesInUse <= grown.reservedBytes);
+			}
+			for (int round = 0; round < 10; round++)
+			{
+				for (int i = 0; i < 5000; i += 2)
+					testList.remove(i);
+				for (int i = 0; i < 5000; i += 2)
+					testList.insert(i);
+			}
+			int found = 0;
+			for (int i = 0; i < 5000; i++)
+				found += testList.search(i) ? 1 : 0;
+			{
+				INFO("Churn keeps every key and takes no more slabs.");
+				REQUIRE(found == 5000);
+				REQUIRE(testList.range(0, 4999).size() == 5000);
+				REQUIRE(allocator.pool().stats().slabs == grown.slabs);
+				REQUIRE(allocator.pool().stats().blocksInUse == 5002);
+			}
+			{
+				INFO("A removed node's block is the next one handed out.");
+				const SkipListNode * removed = testList.search(17).get();
+				testList.remove(17);
+				testList.insert(17);
+				REQUIRE(testList.search(17).get() == removed);
+			}
+		}
+		INFO("Every block is back on a free list once the list is gone.");
+		REQUIRE(allocator.pool().stats().blocksInUse == 0);
+		REQUIRE(allocator.pool().stats().freeBlocks > 5000);
+	}
+
+	SECTION("Lists made with one PoolAllocator share its pool.")
+	{
+		PoolAllocator<SkipListNode> allocator;
+		PooledSkipList firstList(allocator);
+		PooledSkipList secondList(allocator);
+		PooledSkipList thirdList;
+		for (int i = 0; i < 100; i++)
+		{
+			firstList.insert(i);
+			secondList.insert(-i);
+		}
+		thirdList.insert(1);
+		REQUIRE(allocator.pool().stats().blocksInUse == 204);
+		REQUIRE(thirdList.allocator().pool().stats().blocksInUse == 3);
+		REQUIRE(firstList.allocator() == secondList.allocator());
+		REQUIRE(firstList.allocator() != thirdList.allocator());
+	}
+
+	SECTION("A NodePool keeps a free list for each block size.")
+	{
+		NodePool pool;
+		void * small = pool.allocate(24);
+		void * large = pool.allocate(200);
+		pool.deallocate(small, 24);
+		void * reused = pool.allocate(32);
+		void * second = pool.allocate(200);
+		REQUIRE(reused == small);
+		REQUIRE(second != large);
+		REQUIRE(pool.stats().blocksInUse == 3);
+		REQUIRE(pool.stats().slabs == 2);
+		pool.deallocate(reused, 32);
+		pool.deallocate(large, 200);
+		pool.deallocate(second, 200);
+		REQUIRE(pool.stats().blocksInUse == 0);
+	}
+}
+
+TEST_CASE("SkipList Clearing", "[allocator]")
+// Tests that clear empties a list and leaves it usable, that the parallel teardown frees every node
+// whatever the number of threads, that an ArenaSkipList frees its arena at once only when it owns it
+// alone, and that nodes held by a Snapshot or a search result stay valid after their ArenaSkipList goes.
+{
+	typedef BasicSkipList<NoInstrumentation, CountingAllocator<SkipListNode>> CountedSkipList;
+
+	SECTION("A cleared list is empty and can be filled again.")
+	{
+		SkipList testList;
+		for (int i = 0; i < 1000; i++)
+			testList.insert(i);
+		testList.clear();
+		REQUIRE(testList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()).empty());
+		REQUIRE_FALSE(testList.search(5));
+		for (int i = 0; i < 10; i++)
+			testList.insert(i);
+		REQUIRE(testList.range(0, 9).size() == 10);
+	}
+
+	SECTION("Teardown on several threads frees every node.")
+	{
+		for (unsigned threads : { 1u, 2u, 4u, 16u })
+		{
+			CountingAllocator<SkipListNode> counter;
+			{
+				CountedSkipList testList(counter);
+				for (int i = 0; i < 50000; i++)
+					testList.insert((i * 7919) % 50000);
+				testList.clear(threads);
+				INFO("Only the new head and tail are left after clear(" << threads << ").");
+				REQUIRE(counter.stats().liveBytes * 50004 == counter.stats().allocatedBytes * 2);
+				REQUIRE(counter.stats().deallocations == 50002);
+				for (int i = 0; i < 50000; i++)
+					testList.insert(i);
+			}
+			REQUIRE(counter.stats().liveBytes == 0);
+		}
+	}
+
+	SECTION("A list with an open Snapshot cannot be cleared.")
+	{
+		SkipList testList;
+		testList.insert(1);
+		{
+			auto snapshot = testList.snapshot();
+			REQUIRE_THROWS_AS(testList.clear(), const std::runtime_error &);
+			REQUIRE(snapshot.search(1));
+		}
+		testList.clear();
+		REQUIRE_FALSE(testList.search(1));
+	}
+
+	SECTION("An ArenaSkipList that owns its arena replaces it when cleared.")
+	{
+		ArenaSkipList testList;
+		for (int i = 0; i < 20000; i++)
+			testList.insert((i * 7919) % 20000);
+		for (int i = 0; i < 20000; i += 2)
+			testList.remove(i);
+		const NodePool * oldArena = &testList.allocator().pool();
+		REQUIRE(oldArena->stats().blocksInUse == 10002);
+		testList.clear();
+		{
+			INFO("The cleared list holds only its head and tail, in a new arena.");
+			REQUIRE(&testList.allocator().pool() != oldArena);
+			REQUIRE(testList.allocator().pool().stats().blocksInUse == 2);
+			REQUIRE(testList.allocator().pool().stats().slabs == 1);
+		}
+		for (int i = 0; i < 1000; i++)
+			testList.insert(i);
+		REQUIRE(testList.range(0, 999).size() == 1000);
+	}
+
+	SECTION("Nodes held outside an ArenaSkipList outlive it.")
+	{
+		std::unique_ptr<ArenaSkipList> testList(new ArenaSkipList);
+		for (int i = 0; i < 5000; i++)
+			testList->insert(i);
+		auto found = testList->search(42);
+		testList->clear();
+		{
+			INFO("A search result taken before clear still holds its key.");
+			REQUIRE(found);
+			REQUIRE(found->_key == 42);
+		}
+		for (int i = 0; i < 5000; i++)
+			testList->insert(i);
+		found = testList->search(4242);
+		auto snapshot = testList->snapshot();
+		testList.reset();
+		{
+			INFO("A search result and a Snapshot taken before the list was destroyed can still be released.");
+			REQUIRE(found->_key == 4242);
+			found.reset();
+		}
+	}
+
+	SECTION("ArenaSkipLists sharing an arena free their nodes one by one.")
+	{
+		ArenaAllocator<SkipListNode> arena;
+		{
+			ArenaSkipList firstList(arena);
+			ArenaSkipList secondList(arena);
+			for (int i = 0; i < 1000; i++)
+			{
+				firstList.insert(i);
+				secondList.insert(i);
+			}
+			REQUIRE(arena.pool().stats().blocksInUse == 2004);
+			firstList.clear();
+			REQUIRE(arena.pool().stats().blocksInUse == 1004);
+			REQUIRE(secondList.range(0, 999).size() == 1000);
+		}
+		REQUIRE(arena.pool().stats().blocksInUse == 0);
+	}
+}
+
+TEST_CASE("NodePool Placement", "[allocator]")
+// Tests that pools asked for huge pages or a NUMA node take slabs of the right size, fall back to
+// ordinary pages where the system has none, keep every key, and keep their options when cleared.
+{
+	const std::size_t hugePageBytes = NodePool::HugePageBytes;
+
+	SECTION("Huge page slabs are 2 MB and hold every node.")
+	{
+		PoolOptions options;
+		options.hugePages = true;
+		ArenaSkipList testList((ArenaAllocator<SkipListNode>(options)));
+		for (int i = 0; i < 20000; i++)
+			testList.insert((i * 7919) % 20000);
+		int found = 0;
+		for (int i = 0; i < 20000; i++)
+			found += testList.search(i) ? 1 : 0;
+		REQUIRE(found == 20000);
+		PoolStats stats = testList.allocator().pool().stats();
+		{
+			INFO("20000 nodes of about 300 bytes fit in a few 2 MB slabs.");
+			REQUIRE(stats.slabs >= 2);
+			REQUIRE(stats.slabs <= 4);
+			REQUIRE(stats.reservedBytes == stats.slabs * hugePageBytes);
+			REQUIRE(stats.hugePageSlabs + stats.transparentHugePageSlabs <= stats.slabs);
+		}
+		testList.clear();
+		{
+			INFO("A cleared list's new arena also takes huge pages.");
+			REQUIRE(testList.allocator().pool().options().hugePages);
+			REQUIRE(testList.allocator().pool().stats().reservedBytes == hugePageBytes);
+		}
+	}
+
+	SECTION("A pool for the local NUMA node binds its slabs there.")
+	{
+		PoolOptions options;
+		options.numaNode = PoolOptions::LocalNode;
+		PoolAllocator<SkipListNode> allocator(options);
+		PooledSkipList testList(allocator);
+		for (int i = 0; i < 5000; i++)
+			testList.insert(i);
+		REQUIRE(testList.range(0, 4999).size() == 5000);
+		PoolStats stats = allocator.pool().stats();
+		{
+			INFO("The local node is known on Linux, and slabs are bound to it if the kernel supports NUMA.");
+			REQUIRE(stats.numaNode >= 0);
+			REQUIRE(allocator.pool().options().numaNode == stats.numaNode);
+			REQUIRE(stats.numaBoundSlabs <= stats.slabs);
+			REQUIRE(stats.hugePageSlabs == 0);
+		}
+	}
+}
+
+TEST_CASE("BufferedSkipList", "[buffered]")
+// Tests that a thread reads its own buffered writes and that every write reaches the shared list.
+{
+	SECTION("Reads see own writes before the merge.")
+	{
+		BufferedSkipList testList(1000, std::chrono::milliseconds(10000));
+		testList.insert(7);
+		testList.insert(3);
+		{
+			INFO("Buffered keys are visible to the writing thread.");
+			REQUIRE(testList.search(7));
+			REQUIRE(testList.search(3));
+			REQUIRE(!testList.search(5));
+			REQUIRE(testList.range(0, 10) == std::vector<int>({ 3, 7 }));
+		}
+		testList.remove(7);
+		{
+			INFO("Buffered keys can be removed.");
+			REQUIRE(!testList.search(7));
+		}
+	}
+
+	SECTION("Concurrent writers' keys are all merged.")
+	{
+		const int writers = 4;
+		const int perWriter = 5000;
+		BufferedSkipList testList(32);
+		std::atomic<int> missedOwnWrites(0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < writers; t++)
+			threads.emplace_back([&testList, &missedOwnWrites, t]() {
+				for (int i = 0; i < perWriter; i++)
+				{
+					testList.insert(i * writers + t);
+					if (!testList.search(i * writers + t))
+						missedOwnWrites++;
+				}
+			});
+		for (auto & thread : threads)
+			thread.join();
+		testList.flush();
+
+		std::vector<int> testInts(writers * perWriter);
+		for (int i = 0; i < writers * perWriter; i++)
+			testInts[i] = i;
+		{
+			INFO("Every thread saw its own writes.");
+			REQUIRE(missedOwnWrites.load() == 0);
+		}
+		{
+			INFO("Every key reached the list exactly once.");
+			REQUIRE(testList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+	}
+
+	SECTION("A remove reaches keys buffered by another thread.")
+	{
+		BufferedSkipList testList(1000, std::chrono::milliseconds(10000));
+		std::thread writer([&testList]() {
+			testList.insert(7);
+			testList.insert(8);
+		});
+		writer.join();
+		testList.remove(7);
+		testList.flush();
+		{
+			INFO("The key removed before it was merged does not come back.");
+			REQUIRE(!testList.search(7));
+			REQUIRE(testList.search(8));
+		}
+	}
+}
+
+TEST_CASE("RcuSkipList WriteBatch", "[rcu]")
+// Tests that a WriteBatch applies its operations in order and that readers see all of a batch or none of it.
+{
+	SECTION("Operations apply in order.")
+	{
+		RcuSkipList testList;
+		testList.insert(1);
+		testList.insert(2);
+		WriteBatch batch;
+		batch.put(3);
+		batch.erase(1);
+		batch.put(4);
+		batch.erase(4);
+		batch.erase(99);
+		testList.apply(batch);
+		{
+			INFO("Puts and erases, including an erase of a put in the same batch, are applied.");
+			REQUIRE(testList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == std::vector<int>({ 2, 3 }));
+		}
+	}
+
+	SECTION("Readers see whole batches.")
+	{
+		// The writer alternates between a batch that puts ten keys and a batch that erases them,
+		// so any consistent read holds either none or all ten.
+		RcuSkipList testList;
+		std::atomic<bool> done(false);
+		std::atomic<int> badReads(0);
+		std::vector<std::thread> readers;
+		for (int t = 0; t < 3; t++)
+			readers.emplace_back([&]() {
+				while (!done.load())
+				{
+					auto size = testList.range(0, 9).size();
+					if (size != 0 && size != 10)
+						badReads++;
+				}
+			});
+		WriteBatch putAll, eraseAll;
+		for (int i = 0; i < 10; i++)
+		{
+			putAll.put(i);
+			eraseAll.erase(i);
+		}
+		for (int round = 0; round < 500; round++)
+		{
+			testList.apply(putAll);
+			testList.apply(eraseAll);
+		}
+		done = true;
+		for (auto & reader : readers)
+			reader.join();
+		testList.reclaim();
+		{
+			INFO("No reader saw part of a batch.");
+			REQUIRE(badReads.load() == 0);
+		}
+	}
+}
+
+TEST_CASE("SkipList Save and Load", "[persistence]")
+// Tests that a saved list loads back with the same keys, and with the same towers when heights are saved,
+// that a failed save keeps the previous file, and that damaged files are rejected.
+{
+	const std::string path = "skiplist_test_save.bin";
+
+	SkipList testList = SkipList();
+	std::vector<int> testInts(10000);
+	std::generate(testInts.begin(), testInts.end(), randomNumber);
+	for (auto i : testInts)
+		testList.insert(i);
+	std::sort(testInts.begin(), testInts.end());
+
+	SECTION("Saved heights reproduce the same towers.")
+	{
+		testList.save(path);
+		SkipList loadedList = SkipList();
+		loadedList.insert(12345);
+		loadedList.load(path);
+		{
+			INFO("All keys were loaded in sorted order, replacing the old contents.");
+			REQUIRE(loadedList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+		{
+			INFO("Every level links the same keys as the original.");
+			for (int i = 0; i < MaxLevel; i++)
+			{
+				std::vector<int> original, loaded;
+				for (auto node = testList._head->_forwardNodes[i]; node != testList._tail; node = node->_forwardNodes[i])
+					original.push_back(node->_key);
+				for (auto node = loadedList._head->_forwardNodes[i]; node != loadedList._tail; node = node->_forwardNodes[i])
+					loaded.push_back(node->_key);
+				REQUIRE(original == loaded);
+			}
+		}
+		{
+			INFO("The loaded list can be searched and modified.");
+			REQUIRE(loadedList.search(testInts[500]));
+			loadedList.remove(testInts[500]);
+			loadedList.insert(7);
+			REQUIRE(loadedList.search(7));
+		}
+	}
+
+	SECTION("Without heights, towers are rebuilt deterministically.")
+	{
+		testList.save(path, false);
+		SkipList loadedList = SkipList();
+		loadedList.load(path);
+		{
+			INFO("All keys were loaded in sorted order.");
+			REQUIRE(loadedList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+		{
+			INFO("Every fourth node reaches level 1.");
+			int levelOne = 0;
+			for (auto node = loadedList._head->_forwardNodes[1]; node != loadedList._tail; node = node->_forwardNodes[1])
+				levelOne++;
+			REQUIRE(levelOne == 10000 / 4);
+		}
+	}
+
+	SECTION("Damaged files are rejected.")
+	{
+		testList.save(path);
+		{
+			std::ofstream truncated(path, std::ios::binary | std::ios::in);
+			truncated.seekp(0);
+			truncated.write("XXXX", 4);
+		}
+		SkipList loadedList = SkipList();
+		loadedList.insert(1);
+		{
+			INFO("A file with the wrong magic number throws and leaves the list unchanged.");
+			REQUIRE_THROWS(loadedList.load(path));
+			REQUIRE(loadedList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == std::vector<int>({ 1 }));
+		}
+		{
+			INFO("A missing file throws.");
+			REQUIRE_THROWS(loadedList.load("no_such_skiplist_file.bin"));
+		}
+		testList.save(path);
+		{
+			// The first height byte follows the 20-byte header and the 4-byte keys
+			std::ofstream corrupt(path, std::ios::binary | std::ios::in);
+			corrupt.seekp(20 + 4 * 10000);
+			corrupt.write("\x40", 1);
+		}
+		{
+			INFO("A height out of range throws std::runtime_error and leaves the list unchanged.");
+			REQUIRE_THROWS_AS(loadedList.load(path), const std::runtime_error &);
+			REQUIRE(loadedList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == std::vector<int>({ 1 }));
+		}
+	}
+
+	SECTION("A failed save leaves the previous file in place.")
+	{
+		SkipList smallList = SkipList();
+		smallList.insert(1);
+		smallList.save(path);
+		// A directory in the way of the temporary file makes the next save fail before it writes
+		::mkdir(DurableFile::temporaryPath(path).c_str(), 0755);
+		{
+			INFO("save throws std::runtime_error.");
+			REQUIRE_THROWS_AS(testList.save(path), const std::runtime_error &);
+		}
+		::rmdir(DurableFile::temporaryPath(path).c_str());
+		SkipList loadedList = SkipList();
+		loadedList.load(path);
+		{
+			INFO("The file still holds the list saved before.");
+			REQUIRE(loadedList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == std::vector<int>({ 1 }));
+		}
+		testList.save(path);
+		loadedList.load(path);
+		{
+			INFO("A save that succeeds replaces the file.");
+			REQUIRE(loadedList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+	}
+
+	SECTION("A list with an open snapshot cannot be loaded into.")
+	{
+		testList.save(path);
+		SkipList loadedList = SkipList();
+		loadedList.insert(1);
+		auto snapshot = loadedList.snapshot();
+		{
+			INFO("load throws instead of pulling the nodes out from under the snapshot.");
+			REQUIRE_THROWS_AS(loadedList.load(path), const std::runtime_error &);
+			REQUIRE(snapshot.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == std::vector<int>({ 1 }));
+		}
+	}
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("MappedSkipList", "[persistence]")
+// Tests that a list written in the mapped format can be searched and scanned in place.
+{
+	const std::string path = "skiplist_test_mapped.bin";
+
+	SECTION("Mapped file answers like the original list.")
+	{
+		SkipList testList = SkipList();
+		std::vector<int> testInts(10000);
+		std::generate(testInts.begin(), testInts.end(), randomNumber);
+		for (auto i : testInts)
+			testList.insert(i);
+		testList.remove(testInts[0]);
+		testInts.erase(testInts.begin());
+		std::sort(testInts.begin(), testInts.end());
+		MappedSkipList::write(testList, path);
+
+		MappedSkipList mapped(path);
+		{
+			INFO("Every key is in the file in sorted order.");
+			REQUIRE(mapped.size() == testInts.size());
+			REQUIRE(mapped.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+		{
+			INFO("Search finds present keys and rejects absent ones.");
+			for (int i = 0; i < 100; i++)
+			{
+				REQUIRE(mapped.search(testInts[i * 97]));
+				REQUIRE(mapped.search(testInts[i * 97]) == static_cast<bool>(testList.search(testInts[i * 97])));
+				int probe = randomNumber();
+				REQUIRE(mapped.search(probe) == static_cast<bool>(testList.search(probe)));
+			}
+		}
+		{
+			INFO("Range scans match the original list.");
+			REQUIRE(mapped.range(-1000000, 1000000) == testList.range(-1000000, 1000000));
+		}
+	}
+
+	SECTION("Empty lists and bad files.")
+	{
+		SkipList testList = SkipList();
+		MappedSkipList::write(testList, path);
+		{
+			MappedSkipList mapped(path);
+			INFO("An empty list maps to an empty file view.");
+			REQUIRE(mapped.size() == 0);
+			REQUIRE(!mapped.search(0));
+			REQUIRE(mapped.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()).empty());
+		}
+		testList.insert(1);
+		testList.save(path);
+		{
+			INFO("A file in another format is rejected.");
+			REQUIRE_THROWS(MappedSkipList(path));
+		}
+	}
+
+	SECTION("Rewriting a file leaves open mappings intact.")
+	{
+		SkipList testList = SkipList();
+		for (int i = 0; i < 1000; i++)
+			testList.insert(i);
+		MappedSkipList::write(testList, path);
+		MappedSkipList mapped(path);
+		SkipList otherList = SkipList();
+		otherList.insert(-1);
+		MappedSkipList::write(otherList, path);
+		{
+			INFO("The open mapping still reads the old file.");
+			REQUIRE(mapped.size() == 1000);
+			REQUIRE(mapped.range(0, 999).size() == 1000);
+		}
+		MappedSkipList reopened(path);
+		{
+			INFO("A new mapping reads the new file.");
+			REQUIRE(reopened.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == std::vector<int>({ -1 }));
+		}
+	}
+
+	SECTION("Corrupt offsets throw instead of reading outside the file.")
+	{
+		SkipList testList = SkipList();
+		for (int i = 0; i < 100; i++)
+			testList.insert(i);
+		MappedSkipList::write(testList, path);
+		{
+			// Level 0 of the head record, which starts right after the 32-byte header
+			std::fstream corrupt(path, std::ios::binary | std::ios::in | std::ios::out);
+			corrupt.seekp(32 + 8);
+			const char farAway[8] = { 0, 0, 0, 0, 0, 0, 0, 0x10 };
+			corrupt.write(farAway, sizeof(farAway));
+		}
+		MappedSkipList mapped(path);
+		{
+			INFO("Following the corrupt offset throws std::runtime_error.");
+			REQUIRE_THROWS_AS(mapped.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()),
+			                  const std::runtime_error &);
+		}
+	}
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("DurableSkipList", "[persistence]")
+// Tests that logged operations are replayed on open, that a torn final record is discarded but
+// damage before intact records is reported, that concurrent commits share syncs and are visible
+// once they return, and that a failed write is never reported durable.
+{
+	const std::string path = "skiplist_test.wal";
+	std::remove(path.c_str());
+
+	SECTION("Operations survive reopening.")
+	{
+		{
+			DurableSkipList testList(path, WalSyncPolicy::EveryN, 4);
+			for (int i = 0; i < 100; i++)
+				testList.insert(i);
+			for (int i = 0; i < 100; i += 3)
+				testList.remove(i);
+		}
+		DurableSkipList reopened(path);
+		std::vector<int> testInts;
+		for (int i = 0; i < 100; i++)
+			if (i % 3)
+				testInts.push_back(i);
+		{
+			INFO("The reopened list matches the operations logged before closing.");
+			REQUIRE(reopened.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == testInts);
+		}
+	}
+
+	SECTION("A torn record at the end of the log is discarded.")
+	{
+		{
+			DurableSkipList testList(path, WalSyncPolicy::OnClose);
+			testList.insert(1);
+			testList.insert(2);
+		}
+		{
+			std::ofstream log(path, std::ios::binary | std::ios::app);
+			log.write("\x01\x03\x00", 3);
+		}
+		{
+			DurableSkipList reopened(path);
+			INFO("Intact records are replayed and the partial one is dropped.");
+			REQUIRE(reopened.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == std::vector<int>({ 1, 2 }));
+			reopened.insert(3);
+		}
+		DurableSkipList reopened(path);
+		{
+			INFO("Records appended after the truncation replay correctly.");
+			REQUIRE(reopened.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == std::vector<int>({ 1, 2, 3 }));
+		}
+	}
+
+	SECTION("A damaged record followed by intact ones is corruption, not a torn write.")
+	{
+		{
+			DurableSkipList testList(path, WalSyncPolicy::OnClose);
+			testList.insert(1);
+			testList.insert(2);
+			testList.insert(3);
+		}
+		{
+			std::fstream log(path, std::ios::binary | std::ios::in | std::ios::out);
+			log.seekp(WriteAheadLog::RecordBytes + 1);
+			log.put('\x7F');
+		}
+		{
+			INFO("Opening throws rather than dropping the intact record after the damaged one.");
+			REQUIRE_THROWS_AS(DurableSkipList(path), const std::runtime_error &);
+		}
+		std::ifstream log(path, std::ios::binary | std::ios::ate);
+		{
+			INFO("The log is left as it was.");
+			REQUIRE(log.tellg() == std::streampos(3 * WriteAheadLog::RecordBytes));
+		}
+	}
+
+	SECTION("Concurrent commits are durable and share syncs.")
+	{
+		const int writers = 4;
+		const int perWriter = 100;
+		unsigned long long syncs;
+		{
+			DurableSkipList testList(path, WalSyncPolicy::EveryCommit);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < writers; t++)
+				threads.emplace_back([&testList, t]() {
+					for (int i = 0; i < perWriter; i++)
+						testList.insert(i * writers + t);
+				});
+			for (auto & thread : threads)
+				thread.join();
+			syncs = testList.log().syncCount();
+			INFO("Every insert was applied once its commit returned.");
+			REQUIRE(testList.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()).size() == writers * perWriter);
+		}
+		{
+			INFO("Fewer syncs than commits were needed (" << syncs << " syncs for " << writers * perWriter << " commits).");
+			REQUIRE(syncs >= 1);
+			REQUIRE(syncs < static_cast<unsigned long long>(writers * perWriter));
+		}
+		DurableSkipList reopened(path);
+		{
+			INFO("Every committed insert was replayed.");
+			REQUIRE(reopened.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()).size() == writers * perWriter);
+		}
+	}
+
+	SECTION("Records appended before a sync are covered by one fdatasync.")
+	{
+		const int writers = 4;
+		std::atomic<int> appended(0);
+		{
+			WriteAheadLog log(path, WalSyncPolicy::EveryCommit);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < writers; t++)
+				threads.emplace_back([&log, &appended, t]() {
+					unsigned long long lsn = log.append(WriteAheadLog::Insert, t);
+					++appended;
+					while (appended.load() < writers)
+						std::this_thread::yield();
+					log.commit(lsn);
+				});
+			for (auto & thread : threads)
+				thread.join();
+			INFO("The first committer's group held every record, so the others found theirs durable.");
+			REQUIRE(log.syncCount() == 1);
+		}
+	}
+
+	SECTION("A failed write fails every later commit.")
+	{
+		WriteAheadLog log("/dev/full", WalSyncPolicy::EveryCommit);
+		const int writers = 4;
+		std::atomic<int> failures(0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < writers; t++)
+			threads.emplace_back([&log, &failures, t]() {
+				try {
+					log.commit(log.append(WriteAheadLog::Insert, t));
+				}
+				catch (const std::runtime_error &) {
+					++failures;
+				}
+			});
+		for (auto & thread : threads)
+			thread.join();
+		{
+			INFO("No commit reported success for a record that was never written.");
+			REQUIRE(failures.load() == writers);
+			REQUIRE(log.syncCount() == 0);
+		}
+		{
+			INFO("The log stays failed rather than retrying.");
+			REQUIRE_THROWS_AS(log.append(WriteAheadLog::Insert, 0), const std::runtime_error &);
+			REQUIRE_THROWS_AS(log.sync(), const std::runtime_error &);
+		}
+	}
+
+	std::remove(path.c_str());
+}
+
+TEST_CASE("CheckpointedSkipList", "[persistence]")
+// Tests that a checkpoint writes only the keys changed since the last one, that the list is restored
+// from the base and deltas, that deltas are folded into a new base, retrying a fold that fails, that
+// temporary files are cleaned up at open, and that writers can run meanwhile.
+{
+	const std::string directory = "skiplist_test_checkpoint";
+	auto removeDirectory = [&directory]() {
+		if (DIR * listing = ::opendir(directory.c_str()))
+		{
+			while (dirent * entry = ::readdir(listing))
+				std::remove((directory + "/" + entry->d_name).c_str());
+			::closedir(listing);
+		}
+		::rmdir(directory.c_str());
+	};
+	auto fileCount = [&directory]() {
+		int count = 0;
+		if (DIR * listing = ::opendir(directory.c_str()))
+		{
+			while (dirent * entry = ::readdir(listing))
+				count += entry->d_name[0] != '.' ? 1 : 0;
+			::closedir(listing);
+		}
+		return count;
+	};
+	const int lowest = std::numeric_limits<int>::min();
+	const int highest = std::numeric_limits<int>::max();
+	removeDirectory();
+
+	SECTION("A checkpoint writes only the changed keys.")
+	{
+		std::vector<int> expected;
+		{
+			CheckpointedSkipList testList(directory);
+			for (int i = 0; i < 10000; i++)
+				testList.insert(i);
+			{
+				INFO("The first checkpoint writes every key and folds them into a base.");
+				REQUIRE(testList.checkpoint() == 10000);
+				REQUIRE(testList.deltaCount() == 0);
+			}
+			testList.insert(20000);
+			testList.insert(20001);
+			testList.remove(5);
+			testList.remove(6);
+			testList.remove(6);
+			{
+				INFO("The next checkpoint writes the four changed keys to one delta.");
+				REQUIRE(testList.dirtyCount() == 4);
+				REQUIRE(testList.checkpoint() == 4);
+				REQUIRE(testList.deltaCount() == 1);
+				REQUIRE(testList.checkpoint() == 0);
+			}
+			testList.insert(7);
+			expected = testList.range(lowest, highest);
+			testList.checkpoint();
+		}
+		CheckpointedSkipList reopened(directory);
+		{
+			INFO("Reopening applies the deltas to the base, duplicates included.");
+			REQUIRE(reopened.range(lowest, highest) == expected);
+			REQUIRE(reopened.range(7, 7).size() == 2);
+			REQUIRE(!reopened.search(5));
+		}
+	}
+
+	SECTION("Many deltas are folded into a new base.")
+	{
+		{
+			CheckpointedSkipList testList(directory);
+			for (int i = 0; i < static_cast<int>(CheckpointedSkipList::MaxDeltas) + 3; i++)
+			{
+				testList.insert(i);
+				testList.checkpoint();
+			}
+			INFO("The deltas were folded after MaxDeltas checkpoints and the old files deleted.");
+			REQUIRE(testList.deltaCount() == 3);
+			REQUIRE(fileCount() == 4);
+		}
+		CheckpointedSkipList reopened(directory);
+		{
+			INFO("The new base and the deltas after it restore every key.");
+			REQUIRE(reopened.range(lowest, highest).size() == CheckpointedSkipList::MaxDeltas + 3);
+		}
+	}
+
+	SECTION("A failed fold keeps the deltas and the next checkpoint retries it.")
+	{
+		const int deltas = static_cast<int>(CheckpointedSkipList::MaxDeltas);
+		char blocked[64];
+		std::snprintf(blocked, sizeof(blocked), "/base-%08d.skpl.tmp", deltas);
+		{
+			CheckpointedSkipList testList(directory);
+			REQUIRE(::mkdir((directory + blocked).c_str(), 0755) == 0);
+			for (int i = 0; i < deltas; i++)
+			{
+				testList.insert(i);
+				REQUIRE(testList.checkpoint() == 1);
+			}
+			{
+				INFO("The new base cannot be written, but the checkpoint succeeds and the deltas stay.");
+				REQUIRE(testList.deltaCount() == static_cast<unsigned long long>(deltas));
+			}
+			::rmdir((directory + blocked).c_str());
+			testList.insert(deltas);
+			REQUIRE(testList.checkpoint() == 1);
+			{
+				INFO("The next checkpoint folds every delta into a base.");
+				REQUIRE(testList.deltaCount() == 0);
+				REQUIRE(fileCount() == 1);
+			}
+		}
+		CheckpointedSkipList reopened(directory);
+		REQUIRE(reopened.range(lowest, highest).size() == static_cast<std::size_t>(deltas + 1));
+	}
+
+	SECTION("Temporary files left by a crash are deleted at open.")
+	{
+		{
+			CheckpointedSkipList testList(directory);
+			testList.insert(1);
+			testList.checkpoint();
+		}
+		std::ofstream(directory + "/delta-00000002.ckpt.tmp") << "torn";
+		std::ofstream(directory + "/base-00000002.skpl.tmp") << "torn";
+		REQUIRE(fileCount() == 3);
+		CheckpointedSkipList reopened(directory);
+		{
+			INFO("Only the base is left, and it restores the list.");
+			REQUIRE(fileCount() == 1);
+			REQUIRE(reopened.search(1));
+		}
+	}
+
+	SECTION("Writers keep going while checkpoints run.")
+	{
+		const int writers = 2;
+		const int perWriter = 5000;
+		std::vector<int> expected;
+		{
+			CheckpointedSkipList testList(directory);
+			std::atomic<bool> writing(true);
+			std::vector<std::thread> threads;
+			for (int t = 0; t < writers; t++)
+				threads.emplace_back([&testList, t]() {
+					for (int i = 0; i < perWriter; i++)
+					{
+						testList.insert(i * writers + t);
+						if (i % 3 == 0)
+							testList.remove((i / 2) * writers + t);
+					}
+				});
+			std::thread checkpointer([&testList, &writing]() {
+				while (writing.load())
+				{
+					testList.checkpoint();
+					std::this_thread::yield();
+				}
+			});
+			for (auto & thread : threads)
+				thread.join();
+			writing = false;
+			checkpointer.join();
+			testList.checkpoint();
+			expected = testList.range(lowest, highest);
+		}
+		CheckpointedSkipList reopened(directory);
+		{
+			INFO("The last checkpoint holds exactly the list as the writers left it.");
+			REQUIRE(reopened.range(lowest, highest) == expected);
+		}
+	}
+
+	removeDirectory();
+}
+
+TEST_CASE("SkipList streaming", "[persistence]")
+// Tests that a list streamed over a socket arrives intact, that an Exporter sends the keys of one moment
+// while the list changes between chunks, and that a broken stream leaves the receiver unchanged.
+{
+	int sockets[2];
+	REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+	SkipList sent;
+	SkipList received;
+
+	SECTION("A list streamed through a socket arrives with every key.")
+	{
+		std::vector<int> keys;
+		for (int i = 0; i < 100000; i++)
+			keys.push_back((i * 7919) % 50000 - 25000);
+		sent.insertBatch(keys);
+		std::sort(keys.begin(), keys.end());
+		unsigned long long exported = 0;
+		std::thread sender([&]() { exported = sent.exportTo(sockets[0]); });
+		unsigned long long imported = received.importFrom(sockets[1]);
+		sender.join();
+		{
+			INFO("Both ends count every key, duplicates included, and the copy holds them in order.");
+			REQUIRE(exported == 100000);
+			REQUIRE(imported == 100000);
+			REQUIRE(received.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == keys);
+		}
+	}
+
+	SECTION("An Exporter streams one moment of a list that changes between chunks.")
+	{
+		for (int i = 0; i < 40000; i++)
+			sent.insert(2 * i);
+		std::vector<int> expected = sent.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max());
+		unsigned long long imported = 0;
+		std::thread receiver([&]() { imported = received.importFrom(sockets[1]); });
+		SkipList::Exporter exporter(sent);
+		for (int chunk = 0; exporter.writeChunk(sockets[0]); chunk++)
+		{
+			for (int i = 0; i < 1000; i++)
+				sent.insert(2 * (chunk * 1000 + i) + 1);
+			for (int i = 0; i < 1000; i++)
+				sent.remove(2 * (chunk * 1000 + i));
+		}
+		receiver.join();
+		{
+			INFO("Keys inserted and removed during the export do not change what is sent.");
+			REQUIRE(exporter.count() == 40000);
+			REQUIRE(imported == 40000);
+			REQUIRE(received.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == expected);
+			REQUIRE(sent.range(0, 10) == std::vector<int>({ 1, 3, 5, 7, 9 }));
+		}
+	}
+
+	SECTION("A truncated or foreign stream throws and leaves the receiver as it was.")
+	{
+		received.insert(42);
+		const char header[12] = { 'S', 'K', 'S', 'T', 1, 0, 0, 0, 2, 0, 0, 0 };
+		REQUIRE(::write(sockets[0], header, sizeof(header)) == static_cast<ssize_t>(sizeof(header)));
+		::shutdown(sockets[0], SHUT_WR);
+		{
+			INFO("A stream that ends inside a chunk is truncated.");
+			REQUIRE_THROWS_AS(received.importFrom(sockets[1]), const std::runtime_error &);
+			REQUIRE(received.range(0, 100) == std::vector<int>({ 42 }));
+		}
+		int others[2];
+		REQUIRE(::socketpair(AF_UNIX, SOCK_STREAM, 0, others) == 0);
+		REQUIRE(::write(others[0], "SKPL\1\0\0\0", 8) == 8);
+		{
+			INFO("A stream without the magic is refused.");
+			REQUIRE_THROWS_AS(received.importFrom(others[1]), const std::runtime_error &);
+			REQUIRE(received.search(42));
+		}
+		::close(others[0]);
+		::close(others[1]);
+	}
+	::close(sockets[0]);
+	::close(sockets[1]);
+}
+
+TEST_CASE("SharedSkipList", "[shared memory]")
+// Tests that reader processes see the writer's list in shared memory, including while it changes,
+// and that readers cannot write and a full region refuses inserts.
+{
+	const std::string name = "/skiplist_test_shm";
+	// Runs check in a child process and returns true if it exits successfully
+	auto inChild = [](auto check) {
+		pid_t child = ::fork();
+		if (child == 0)
+		{
+			bool passed = false;
+			try {
+				passed = check();
+			}
+			catch (...) {
+			}
+			::_exit(passed ? 0 : 1);
+		}
+		int status = 0;
+		return child > 0 && ::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	};
+
+	SECTION("Another process reads what the writer inserted.")
+	{
+		SharedSkipList writer(name, 1 << 22);
+		for (int i = 0; i < 10000; i += 2)
+			writer.insert(i);
+		writer.remove(10);
+		bool passed = inChild([&name]() {
+			SharedSkipList reader(name);
+			return reader.size() == 4999 && reader.search(0) && reader.search(9998) && !reader.search(10) &&
+			       !reader.search(1) && reader.range(4, 16) == std::vector<int>({ 4, 6, 8, 12, 14, 16 });
+		});
+		{
+			INFO("The reader process found exactly the writer's keys.");
+			REQUIRE(passed);
+		}
+	}
+
+	SECTION("Readers scan consistently while the writer changes the list.")
+	{
+		const int stableKeys = 10000;
+		SharedSkipList writer(name, 1 << 24);
+		for (int i = 0; i < stableKeys; i++)
+			writer.insert(2 * i);
+		pid_t child = ::fork();
+		if (child == 0)
+		{
+			bool passed = true;
+			try {
+				SharedSkipList reader(name);
+				for (int pass = 0; pass < 100 && passed; pass++)
+				{
+					int evens = 0;
+					int previous = std::numeric_limits<int>::min();
+					reader.scan(std::numeric_limits<int>::min(), std::numeric_limits<int>::max(), [&](int key) {
+						passed = passed && key > previous;
+						previous = key;
+						evens += key % 2 == 0 ? 1 : 0;
+					});
+					passed = passed && evens == stableKeys;
+				}
+			}
+			catch (...) {
+				passed = false;
+			}
+			::_exit(passed ? 0 : 1);
+		}
+		for (int round = 0; round < 20; round++)
+		{
+			for (int i = 0; i < stableKeys; i += 7)
+				writer.insert(2 * i + 1);
+			for (int i = 0; i < stableKeys; i += 7)
+				writer.remove(2 * i + 1);
+		}
+		int status = 0;
+		bool passed = child > 0 && ::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		{
+			INFO("Every scan saw the stable keys exactly once, in order, whatever the writer was doing.");
+			REQUIRE(passed);
+			REQUIRE(writer.size() == static_cast<std::uint64_t>(stableKeys));
+		}
+	}
+
+	SECTION("Readers cannot write and a full region refuses inserts.")
+	{
+		SharedSkipList writer(name, 4096);
+		SharedSkipList reader(name);
+		{
+			INFO("A reader's insert and remove throw.");
+			REQUIRE_THROWS_AS(reader.insert(1), const std::runtime_error &);
+			REQUIRE_THROWS_AS(reader.remove(1), const std::runtime_error &);
+		}
+		bool full = false;
+		int inserted = 0;
+		for (; inserted < 4096 && !full; inserted++)
+		{
+			try {
+				writer.insert(inserted);
+			}
+			catch (const std::runtime_error &) {
+				full = true;
+			}
+		}
+		{
+			INFO("Inserts stop with an exception once the region is full, leaving the list intact.");
+			REQUIRE(full);
+			REQUIRE(reader.size() == static_cast<std::uint64_t>(inserted - 1));
+			REQUIRE(reader.range(0, 4096).size() == static_cast<std::size_t>(inserted - 1));
+		}
+	}
+}
+
+TEST_CASE("CompressedSkipList", "[compressed]")
+// Tests that frozen ranges keep their keys in far less memory and that search, scan, remove
+// and thaw see the same multiset whichever tier holds each key.
+{
+	CompressedSkipList list;
+
+	SECTION("Freezing a range keeps its keys and packs them into about a byte each.")
+	{
+		std::vector<int> expected;
+		for (int i = 0; i < 20000; i++)
+		{
+			list.insert(3 * i);
+			expected.push_back(3 * i);
+		}
+		std::size_t frozen = list.freeze(0, 3 * 14999);
+		{
+			INFO("Only the keys in the range move, and every key is still found.");
+			REQUIRE(frozen == 15000);
+			REQUIRE(list.coldCount() == 15000);
+			REQUIRE(list.hotCount() == 5000);
+			REQUIRE(list.size() == 20000);
+			REQUIRE(list.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == expected);
+			REQUIRE(list.search(0));
+			REQUIRE(list.search(3 * 14999));
+			REQUIRE(list.search(3 * 15000));
+			REQUIRE_FALSE(list.search(1));
+			REQUIRE(list.range(44990, 45010) == std::vector<int>({ 44991, 44994, 44997, 45000, 45003, 45006, 45009 }));
+		}
+		{
+			INFO("Small gaps take one byte, plus a few bytes a block.");
+			REQUIRE(list.coldBytes() < 2 * 15000);
+		}
+	}
+
+	SECTION("Keys inserted into a frozen range merge with it and freeze again.")
+	{
+		for (int i = 0; i < 1000; i += 2)
+			list.insert(i);
+		list.freeze(0, 999);
+		for (int i = 1; i < 1000; i += 2)
+			list.insert(i);
+		list.insert(500);
+		{
+			INFO("Scans merge the tiers, duplicates included.");
+			REQUIRE(list.range(497, 503) == std::vector<int>({ 497, 498, 499, 500, 500, 501, 502, 503 }));
+		}
+		REQUIRE(list.freeze(0, 999) == 501);
+		{
+			INFO("Refreezing leaves one sorted cold tier holding everything.");
+			REQUIRE(list.hotCount() == 0);
+			REQUIRE(list.coldCount() == 1001);
+			std::vector<int> keys = list.range(0, 999);
+			REQUIRE(keys.size() == 1001);
+			REQUIRE(std::is_sorted(keys.begin(), keys.end()));
+		}
+	}
+
+	SECTION("Remove and thaw reach cold keys, across the full int range.")
+	{
+		const int low = std::numeric_limits<int>::min();
+		const int high = std::numeric_limits<int>::max();
+		std::vector<int> keys({ low, low, -70000, -1, 0, 1, 1 << 20, high - 1, high });
+		for (int key : keys)
+			list.insert(key);
+		list.freeze(low, high);
+		{
+			INFO("Gaps up to 2^32 - 1 decode exactly.");
+			REQUIRE(list.range(low, high) == keys);
+		}
+		list.remove(low);
+		list.remove(1 << 20);
+		list.remove(5);
+		{
+			INFO("Remove takes one copy from the block that holds it.");
+			REQUIRE(list.size() == 7);
+			REQUIRE(list.search(low));
+			REQUIRE_FALSE(list.search(1 << 20));
+		}
+		{
+			INFO("Thaw moves only the keys in its range back into the hot tier.");
+			REQUIRE(list.thaw(-1, 1) == 3);
+			REQUIRE(list.hotCount() == 3);
+			REQUIRE(list.coldCount() == 4);
+			REQUIRE(list.range(low, high) == std::vector<int>({ low, -70000, -1, 0, 1, high - 1, high }));
+		}
+		for (int key : std::vector<int>({ low, -70000, -1, 0, 1, high - 1, high }))
+			list.remove(key);
+		REQUIRE(list.size() == 0);
+		REQUIRE(list.coldCount() == 0);
+		REQUIRE(list.range(low, high).empty());
+	}
+}
+
+TEST_CASE("LsmStore", "[lsm]")
+// Tests that full memtables are frozen and flushed to run files, that lookups and range scans see
+// the newest version of each key across memtables and runs, that runs are picked up on reopening,
+// that close reports a failed flush, that run files carry a working Bloom filter, and that compaction
+// merges runs without losing writes.
+{
+	const std::string directory = "skiplist_test_lsm";
+	auto removeDirectory = [&directory]() {
+		if (DIR * listing = ::opendir(directory.c_str()))
+		{
+			while (dirent * entry = ::readdir(listing))
+				std::remove((directory + "/" + entry->d_name).c_str());
+			::closedir(listing);
+		}
+		::rmdir(directory.c_str());
+	};
+	removeDirectory();
+
+	SECTION("Writes are flushed to runs and stay visible.")
+	{
+		LsmStore store(directory, 4096);
+		for (int i = 0; i < 1000; i++)
+			store.put(i);
+		for (int i = 0; i < 1000; i += 2)
+			store.erase(i);
+		store.flush();
+		{
+			INFO("Full memtables were frozen and flushed to more than one run.");
+			REQUIRE(store.runCount() > 1);
+			REQUIRE(store.frozenCount() == 0);
+		}
+		bool allCorrect = true;
+		for (int i = -10; i < 1010; i++)
+			allCorrect = allCorrect && store.contains(i) == (i >= 0 && i < 1000 && i % 2 == 1);
+		{
+			INFO("Erases in newer runs hide puts in older ones.");
+			REQUIRE(allCorrect);
+		}
+		store.put(4);
+		{
+			INFO("A put in the active memtable hides an older tombstone.");
+			REQUIRE(store.contains(4));
+		}
+	}
+
+	SECTION("Runs are found again on reopening.")
+	{
+		{
+			LsmStore store(directory, 1 << 20);
+			for (int i = 0; i < 3000; i += 3)
+				store.put(i);
+		}
+		LsmStore reopened(directory, 1 << 20);
+		{
+			INFO("The destructor flushed the active memtable and the reopened store reads it.");
+			REQUIRE(reopened.runCount() == 1);
+			REQUIRE(reopened.contains(2997));
+			REQUIRE(!reopened.contains(2998));
+		}
+	}
+
+	SECTION("close reports a flush that fails.")
+	{
+		{
+			LsmStore store(directory, 1 << 20);
+			for (int i = 0; i < 100; i++)
+				store.put(i);
+			store.close();
+		}
+		{
+			LsmStore store(directory, 1 << 20);
+			{
+				INFO("A store closed cleanly has its writes on disk.");
+				REQUIRE(store.runCount() == 1);
+				REQUIRE(store.contains(99));
+			}
+			// The next run cannot be written while a directory holds its temporary name
+			REQUIRE(::mkdir((directory + "/run-00000002.sst.tmp").c_str(), 0755) == 0);
+			store.put(1000);
+			INFO("The failure reaches the caller instead of being lost in the destructor.");
+			REQUIRE_THROWS_AS(store.close(), const std::runtime_error &);
+		}
+		::rmdir((directory + "/run-00000002.sst.tmp").c_str());
+	}
+
+	SECTION("Run files carry a Bloom filter.")
+	{
+		::mkdir(directory.c_str(), 0755);
+		const std::string path = directory + "/filter.sst";
+		auto evenKeys = [](auto emit) {
+			for (int i = 0; i < 20000; i += 2)
+				emit(i, LsmEntry::Present);
+		};
+		SortedRun::write(path, evenKeys);
+		int falsePositives = 0;
+		bool allFound = true;
+		{
+			SortedRun run(path);
+			for (int i = 0; i < 20000; i += 2)
+				allFound = allFound && run.mayContain(i) && run.lookup(i) == LsmEntry::Present;
+			for (int i = 1; i < 20000; i += 2)
+				falsePositives += run.mayContain(i) ? 1 : 0;
+		}
+		{
+			INFO("Every key passes the filter and few others do (" << falsePositives << " of 10000).");
+			REQUIRE(allFound);
+			REQUIRE(falsePositives < 500);
+		}
+
+		SortedRun::write(path, evenKeys, 0);
+		SortedRun unfiltered(path);
+		{
+			INFO("A run written without a filter lets every key through to the index.");
+			REQUIRE(unfiltered.mayContain(1));
+			REQUIRE(unfiltered.lookup(1) == LsmEntry::Absent);
+			REQUIRE(unfiltered.lookup(19998) == LsmEntry::Present);
+		}
+
+		bool thrown = false;
+		try {
+			SortedRun::write(directory + "/failed.sst", [](auto emit) {
+				emit(1, LsmEntry::Present);
+				throw std::runtime_error("source failed");
+			});
+		}
+		catch (const std::runtime_error &) {
+			thrown = true;
+		}
+		{
+			INFO("A source that throws leaves neither the run nor its temporary file.");
+			REQUIRE(thrown);
+			REQUIRE(::access((directory + "/failed.sst").c_str(), F_OK) != 0);
+			REQUIRE(::access((directory + "/failed.sst.tmp").c_str(), F_OK) != 0);
+		}
+	}
+
+	SECTION("A merging iterator keeps the newest entry of each key.")
+	{
+		Memtable newer;
+		Memtable older;
+		for (int i = 0; i < 10; i++)
+			older.put(i);
+		newer.erase(3);
+		newer.put(12);
+		newer.erase(20);
+		std::vector<std::unique_ptr<LsmCursor>> sources;
+		sources.emplace_back(new Memtable::Cursor(newer, 2, 15));
+		sources.emplace_back(new Memtable::Cursor(older, 2, 15));
+		std::vector<int> present;
+		std::vector<int> deleted;
+		for (MergingIterator merged(std::move(sources)); merged.valid(); merged.next())
+			(merged.entry() == LsmEntry::Present ? present : deleted).push_back(merged.key());
+		{
+			INFO("Keys in range appear once, the tombstone shadows the older put and is returned itself.");
+			REQUIRE(present == std::vector<int>({ 2, 4, 5, 6, 7, 8, 9, 12 }));
+			REQUIRE(deleted == std::vector<int>({ 3 }));
+		}
+	}
+
+	SECTION("Range scans merge memtables and runs in key order.")
+	{
+		LsmStore store(directory, 4096);
+		for (int i = 0; i < 3000; i++)
+			store.put(i);
+		store.flush();
+		for (int i = 0; i < 3000; i += 3)
+			store.erase(i);
+		store.put(5000);
+		std::vector<int> expected;
+		for (int i = 0; i < 3000; i++)
+			if (i % 3)
+				expected.push_back(i);
+		expected.push_back(5000);
+		{
+			INFO("The full range holds the newest version of every key, once, in order.");
+			REQUIRE(store.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == expected);
+		}
+		std::vector<int> middle(std::lower_bound(expected.begin(), expected.end(), 1000),
+		                        std::upper_bound(expected.begin(), expected.end(), 1999));
+		{
+			INFO("A range starting and ending inside run blocks returns exactly the keys in it.");
+			REQUIRE(store.range(1000, 1999) == middle);
+			REQUIRE(store.range(3001, 4999).empty());
+		}
+	}
+
+	SECTION("Background compaction merges runs of a tier.")
+	{
+		LsmStore store(directory, 4096);
+		for (int i = 0; i < 20000; i++)
+			store.put(i);
+		for (int i = 0; i < 20000; i += 2)
+			store.erase(i);
+		store.flush();
+		// 30000 entries span tiers 0 to 2, and each tier settles with fewer than a fan-in of runs
+		const std::size_t settled = 3 * (LsmStore::CompactionFanIn - 1);
+		for (int wait = 0; wait < 1000 && store.runCount() > settled; wait++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		{
+			INFO("Hundreds of flushed runs were merged down to a few per tier (" << store.runCount() << " runs).");
+			REQUIRE(store.runCount() <= settled);
+		}
+		std::vector<int> expected;
+		for (int i = 1; i < 20000; i += 2)
+			expected.push_back(i);
+		{
+			INFO("Merged runs hold the newest version of every key.");
+			REQUIRE(store.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()) == expected);
+			REQUIRE(!store.contains(0));
+			REQUIRE(store.contains(19999));
+		}
+	}
+
+	SECTION("Full compaction drops shadowed versions and tombstones.")
+	{
+		{
+			LsmStore store(directory, 1 << 20, SortedRun::DefaultBitsPerKey, 1 << 20);
+			for (int i = 0; i < 1000; i++)
+				store.put(i);
+			store.flush();
+			for (int i = 0; i < 1000; i += 2)
+				store.erase(i);
+			store.compact();
+			{
+				INFO("Both runs became one, holding only the keys still present.");
+				REQUIRE(store.runCount() == 1);
+				REQUIRE(store.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()).size() == 500);
+			}
+		}
+		// Put back a flushed run, as if a crash had interrupted the compaction before deleting it
+		SortedRun::write(directory + "/run-00000001.sst", [](auto emit) {
+			for (int i = 0; i < 1000; i++)
+				emit(i, LsmEntry::Present);
+		});
+		LsmStore reopened(directory, 1 << 20);
+		{
+			INFO("A run covered by a merged run is deleted on opening, so erased keys stay erased.");
+			REQUIRE(reopened.runCount() == 1);
+			REQUIRE(!reopened.contains(0));
+			REQUIRE(reopened.contains(1));
+		}
+		for (int i = 1; i < 1000; i += 2)
+			reopened.erase(i);
+		reopened.compact();
+		{
+			INFO("Compacting runs that cancel out leaves no run at all.");
+			REQUIRE(reopened.runCount() == 0);
+			REQUIRE(!reopened.contains(1));
+		}
+	}
+
+	SECTION("A compaction abandoned at shutdown leaves its inputs whole.")
+	{
+		{
+			// Four equal runs start a merge, which the slow rate limiter keeps going past shutdown
+			LsmStore store(directory, 1 << 30, SortedRun::DefaultBitsPerKey, 1 << 16);
+			for (int run = 0; run < 4; run++)
+			{
+				for (int i = 0; i < 10000; i++)
+					store.put(4 * i + run);
+				store.flush();
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		}
+		bool leftovers = false;
+		if (DIR * listing = ::opendir(directory.c_str()))
+		{
+			while (dirent * entry = ::readdir(listing))
+				leftovers = leftovers || std::string(entry->d_name).find('-', 4) != std::string::npos ||
+				            std::string(entry->d_name).find(".tmp") != std::string::npos;
+			::closedir(listing);
+		}
+		{
+			INFO("Neither a merged run nor its temporary file was left behind.");
+			REQUIRE(!leftovers);
+		}
+		LsmStore reopened(directory, 1 << 20);
+		{
+			INFO("The reopened store has the four flushed runs and every key.");
+			REQUIRE(reopened.runCount() == 4);
+			REQUIRE(reopened.range(std::numeric_limits<int>::min(), std::numeric_limits<int>::max()).size() == 40000);
+		}
+	}
+
+	SECTION("The rate limiter spreads out acquisitions.")
+	{
+		RateLimiter limiter(1 << 20);
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < 3; i++)
+			limiter.acquire(100 << 10);
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		{
+			INFO("300 KiB at 1 MiB per second took about 0.29 s or more (" << seconds << " s).");
+			REQUIRE(seconds >= 0.28);
+		}
+	}
+
+	SECTION("Concurrent writers all land.")
+	{
+		const int writers = 4;
+		const int perWriter = 2000;
+		LsmStore store(directory, 8192);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < writers; t++)
+			threads.emplace_back([&store, t]() {
+				for (int i = 0; i < perWriter; i++)
+					store.put(i * writers + t);
+			});
+		for (auto & thread : threads)
+			thread.join();
+		store.flush();
+		bool allFound = true;
+		for (int i = 0; i < writers * perWriter; i++)
+			allFound = allFound && store.contains(i);
+		{
+			INFO("Every key written by every thread is found after flushing.");
+			REQUIRE(allFound);
+		}
+	}
+
+	removeDirectory();
+}
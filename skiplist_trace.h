@@ -0,0 +1,432 @@
+// skiplist_trace.h
+// 18 Oct 2026
+//
+// Header for class TracingInstrumentation
+// An instrumentation policy for BasicSkipList that timestamps every search, insert and remove
+// into per-thread ring buffers, for tail-latency investigations, and dumps them to a compact
+// binary trace that converts to the Chrome trace format.
+// Requires skiplist.h
+
+#ifndef FILE_SKIPLIST_TRACE_H_INCLUDED
+#define FILE_SKIPLIST_TRACE_H_INCLUDED
+
+#include "skiplist.h"	// for SkipListOperation, MaxLevel
+#include <vector>		// for std::vector
+#include <memory>		// for std::shared_ptr, std::make_shared
+#include <atomic>		// for std::atomic
+#include <mutex>		// for std::mutex, std::lock_guard
+#include <string>		// for std::string
+#include <fstream>		// for std::ifstream, std::ofstream
+#include <chrono>		// for std::chrono::steady_clock
+#include <algorithm>	// for std::min, std::sort, std::swap
+#include <utility>		// for std::pair
+#include <stdexcept>	// for std::runtime_error
+#include <cstdint>		// for std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t
+#include <cstring>		// for std::memcpy, std::memcmp
+#include <iterator>		// for std::istreambuf_iterator
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>	// for __rdtsc
+#endif
+
+// struct TraceEvent
+// One traced operation: what it was, a hash of its key, when it started and ended in ticks
+// of TracingInstrumentation::ticks(), and how many levels it walked, counting from the highest
+// level it hopped on.
+struct TraceEvent {
+	std::uint64_t _start;
+	std::uint64_t _end;
+	std::uint32_t _keyHash;
+	std::uint16_t _thread;
+	std::uint8_t _operation;
+	std::uint8_t _levels;
+};
+
+// class TracingInstrumentation
+// Use as BasicSkipList<TracingInstrumentation>. Each Probe reads the time stamp counter when the
+// operation starts and ends, and appends a TraceEvent to the calling thread's ring buffer, which
+// keeps the last RingEvents events. Only the owning thread writes a ring, storing each event as
+// relaxed atomic words and publishing it with a release store of its count, so tracing takes no
+// lock and never waits. A thread's first event for each tracer registers a ring under a mutex,
+// once; each thread remembers its rings by tracer id, so a thread that uses several traced lists
+// has exactly one ring in each. If a ring cannot be allocated the event is dropped, since a Probe
+// records from its destructor. Untraced lists use NoInstrumentation and pay nothing.
+//
+// dump writes the rings to a binary file while the threads run: events that were or may have been
+// overwritten while being copied are dropped rather than written torn. writeChromeTrace converts a
+// dump into the JSON read by chrome://tracing and Perfetto.
+//
+// Trace file layout, little-endian: "SKTR", format version (uint32), ticks per second (uint64),
+// event count (uint64), then for each event in order of start: start (uint64), end (uint64),
+// key hash (uint32), thread (uint16), operation (uint8), levels (uint8).
+//
+// Invariants:
+//		Each Ring's _words[EventWords * (i % RingEvents)] onwards hold event i, for the last RingEvents
+//		events before _count
+//		_startTicks and _startTime were read together when the policy was made
+class TracingInstrumentation {
+// ***** TracingInstrumentation: Types *****
+public:
+	static const std::size_t RingEvents = 1 << 16;
+
+private:
+	static const std::uint32_t TraceFormatVersion = 1;
+	static const std::size_t TraceHeaderBytes = 24;
+	static const std::size_t TraceEventBytes = 24;
+	static const std::size_t EventWords = 3;
+
+	// struct Ring
+	// One thread's last RingEvents events, each packed into EventWords words: start, end, and
+	// key hash, thread, operation and levels from the least significant bits up.
+	struct Ring {
+		std::vector<std::atomic<std::uint64_t>> _words;
+		std::atomic<std::uint64_t> _count{0};
+		std::uint16_t _thread;
+
+		explicit Ring(std::uint16_t thread)
+			: _words(EventWords * RingEvents), _thread(thread)
+		{}
+	};
+
+public:
+	// class Probe
+	// Times one operation and records it when destroyed.
+	class Probe {
+	private:
+		TracingInstrumentation * _tracer;
+		std::uint64_t _start;
+		std::uint32_t _keyHash;
+		std::uint8_t _operation;
+		int _topLevel;
+
+	public:
+		Probe(TracingInstrumentation & tracer, SkipListOperation operation, int key)
+			: _tracer(&tracer), _start(ticks()), _keyHash(hashKey(key)),
+			  _operation(static_cast<std::uint8_t>(operation)), _topLevel(-1)
+		{}
+
+		Probe(const Probe & other) = delete;
+		Probe & operator=(const Probe & other) = delete;
+
+		~Probe() noexcept
+		{
+			TraceEvent event;
+			event._start = _start;
+			event._end = ticks();
+			event._keyHash = _keyHash;
+			event._operation = _operation;
+			event._levels = static_cast<std::uint8_t>(_topLevel + 1);
+			_tracer->record(event);
+		}
+
+		bool less(int a, int b) { return a < b; }
+		bool equal(int a, int b) { return a == b; }
+
+		void hop(int level)
+		{
+			if (_topLevel < 0)
+				_topLevel = level;
+		}
+	};
+
+// ***** TracingInstrumentation: Data Members *****
+private:
+	std::vector<std::shared_ptr<Ring>> _rings;
+	std::mutex _ringsMutex;					// Guards _rings
+	unsigned long long _id;					// Distinguishes this tracer in each thread's ring cache
+	std::uint64_t _startTicks;
+	std::chrono::steady_clock::time_point _startTime;
+
+// ***** TracingInstrumentation: Constructors and Destructors *****
+public:
+	// Default Constructor
+	// Starts tracing with no events.
+	//
+	// Preconditions: None
+	// Strong Guarantee, Exception Neutral
+	TracingInstrumentation()
+		: _id(nextId()), _startTicks(ticks()), _startTime(std::chrono::steady_clock::now())
+	{}
+
+	TracingInstrumentation(const TracingInstrumentation & other) = delete;
+	TracingInstrumentation & operator=(const TracingInstrumentation & other) = delete;
+
+// ***** TracingInstrumentation: Public Member Functions *****
+public:
+	// ticks
+	// Returns the time stamp counter on x86, and steady_clock nanoseconds elsewhere.
+	//
+	// No-Throw Guarantee
+	static std::uint64_t ticks()
+	{
+#if defined(__x86_64__) || defined(__i386__)
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	// dump
+	// Writes the events in every thread's ring to path, in order of start, and returns how many.
+	// Events recorded meanwhile may or may not be included, and a full ring gives up its oldest
+	// event, whose slot is the next to be overwritten.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if path cannot be written
+	// Basic Guarantee, Exception Neutral
+	std::size_t dump(const std::string & path)
+	{
+		std::vector<TraceEvent> events = collect();
+		std::vector<char> bytes(TraceHeaderBytes + TraceEventBytes * events.size());
+		char * out = bytes.data();
+		std::memcpy(out, "SKTR", 4);
+		encode(out + 4, TraceFormatVersion, 4);
+		encode(out + 8, ticksPerSecond(), 8);
+		encode(out + 16, events.size(), 8);
+		out += TraceHeaderBytes;
+		for (const auto & event : events)
+		{
+			encode(out, event._start, 8);
+			encode(out + 8, event._end, 8);
+			encode(out + 16, event._keyHash, 4);
+			encode(out + 20, event._thread, 2);
+			encode(out + 22, event._operation, 1);
+			encode(out + 23, event._levels, 1);
+			out += TraceEventBytes;
+		}
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+		file.flush();
+		if (!file)
+			throw std::runtime_error("TracingInstrumentation::dump: cannot write " + path);
+		return events.size();
+	}
+
+	// readTrace
+	// Returns the events of a file written by dump, and sets ticksPerSecond from its header.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if path cannot be read or is not a trace
+	// Strong Guarantee, Exception Neutral
+	static std::vector<TraceEvent> readTrace(const std::string & path, std::uint64_t & ticksPerSecond)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			throw std::runtime_error("TracingInstrumentation::readTrace: cannot read " + path);
+		std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (bytes.size() < TraceHeaderBytes || std::memcmp(bytes.data(), "SKTR", 4) != 0 ||
+		    decode(bytes.data() + 4, 4) != TraceFormatVersion)
+			throw std::runtime_error("TracingInstrumentation::readTrace: " + path + " is not a trace");
+		std::uint64_t count = decode(bytes.data() + 16, 8);
+		if (count != (bytes.size() - TraceHeaderBytes) / TraceEventBytes ||
+		    (bytes.size() - TraceHeaderBytes) % TraceEventBytes != 0)
+			throw std::runtime_error("TracingInstrumentation::readTrace: " + path + " is truncated");
+		ticksPerSecond = decode(bytes.data() + 8, 8);
+
+		std::vector<TraceEvent> events(count);
+		const char * in = bytes.data() + TraceHeaderBytes;
+		for (auto & event : events)
+		{
+			event._start = decode(in, 8);
+			event._end = decode(in + 8, 8);
+			event._keyHash = static_cast<std::uint32_t>(decode(in + 16, 4));
+			event._thread = static_cast<std::uint16_t>(decode(in + 20, 2));
+			event._operation = static_cast<std::uint8_t>(decode(in + 22, 1));
+			event._levels = static_cast<std::uint8_t>(decode(in + 23, 1));
+			in += TraceEventBytes;
+		}
+		return events;
+	}
+
+	// writeChromeTrace
+	// Converts a file written by dump into Chrome trace event JSON at jsonPath: one complete ("X")
+	// event per operation, on a track per traced thread, with times in microseconds from the first
+	// event, and returns the number of events.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if either file cannot be read or written
+	// Basic Guarantee, Exception Neutral
+	static std::size_t writeChromeTrace(const std::string & tracePath, const std::string & jsonPath)
+	{
+		static const char * const names[SkipListOperations] = { "search", "insert", "remove" };
+		std::uint64_t ticksPerSecond = 0;
+		std::vector<TraceEvent> events = readTrace(tracePath, ticksPerSecond);
+		const double microsecondsPerTick = ticksPerSecond ? 1e6 / static_cast<double>(ticksPerSecond) : 0.0;
+		const std::uint64_t origin = events.empty() ? 0 : events.front()._start;
+
+		std::ofstream json(jsonPath, std::ios::trunc);
+		json << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+		for (std::size_t i = 0; i < events.size(); i++)
+		{
+			const TraceEvent & event = events[i];
+			json << (i ? ",\n" : "\n") << "{\"name\":\""
+			     << (event._operation < SkipListOperations ? names[event._operation] : "unknown")
+			     << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event._thread
+			     << ",\"ts\":" << static_cast<double>(event._start - origin) * microsecondsPerTick
+			     << ",\"dur\":" << static_cast<double>(event._end - event._start) * microsecondsPerTick
+			     << ",\"args\":{\"keyHash\":" << event._keyHash << ",\"levels\":" << unsigned(event._levels) << "}}";
+		}
+		json << "\n]}\n";
+		json.flush();
+		if (!json)
+			throw std::runtime_error("TracingInstrumentation::writeChromeTrace: cannot write " + jsonPath);
+		return events.size();
+	}
+
+// ***** TracingInstrumentation: Private Member Functions *****
+private:
+	// nextId
+	// Returns a number no other TracingInstrumentation in this process has had.
+	//
+	// No-Throw Guarantee
+	static unsigned long long nextId()
+	{
+		static std::atomic<unsigned long long> counter(0);
+		return ++counter;
+	}
+
+	// hashKey
+	// Returns the murmur3 finaliser of key, so traces can tell keys apart without holding them.
+	//
+	// No-Throw Guarantee
+	static std::uint32_t hashKey(int key)
+	{
+		std::uint32_t hash = static_cast<std::uint32_t>(key);
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6B;
+		hash ^= hash >> 13;
+		hash *= 0xC2B2AE35;
+		hash ^= hash >> 16;
+		return hash;
+	}
+
+	// localRing
+	// Returns the calling thread's ring for this tracer, registering one on the thread's first event,
+	// or nullptr if a ring cannot be allocated. Each thread keeps its rings by tracer id, with the
+	// last one used first; ids are never reused, so the entries of destroyed tracers are never matched.
+	//
+	// No-Throw Guarantee
+	Ring * localRing() noexcept
+	{
+		thread_local std::vector<std::pair<unsigned long long, Ring *>> cached;
+		if (!cached.empty() && cached.back().first == _id)
+			return cached.back().second;
+		for (auto entry = cached.begin(); entry != cached.end(); ++entry)
+		{
+			if (entry->first == _id)
+			{
+				std::swap(*entry, cached.back());
+				return cached.back().second;
+			}
+		}
+
+		try {
+			cached.reserve(cached.size() + 1);
+			std::lock_guard<std::mutex> lock(_ringsMutex);
+			auto created = std::make_shared<Ring>(static_cast<std::uint16_t>(_rings.size()));
+			_rings.push_back(created);
+			cached.emplace_back(_id, created.get());
+			return created.get();
+		}
+		catch (...) {
+			return nullptr;
+		}
+	}
+
+	// record
+	// Appends event to the calling thread's ring, overwriting its oldest event once it is full.
+	// Drops event if the thread has no ring and one cannot be allocated.
+	//
+	// Preconditions: None
+	// No-Throw Guarantee
+	void record(const TraceEvent & event) noexcept
+	{
+		Ring * ring = localRing();
+		if (!ring)
+			return;
+		std::uint64_t count = ring->_count.load(std::memory_order_relaxed);
+		std::atomic<std::uint64_t> * words = &ring->_words[EventWords * (count % RingEvents)];
+		words[0].store(event._start, std::memory_order_relaxed);
+		words[1].store(event._end, std::memory_order_relaxed);
+		words[2].store(event._keyHash | std::uint64_t(ring->_thread) << 32 | std::uint64_t(event._operation) << 48 |
+		               std::uint64_t(event._levels) << 56, std::memory_order_relaxed);
+		ring->_count.store(count + 1, std::memory_order_release);
+	}
+
+	// collect
+	// Returns a copy of the events in every ring, sorted by start. An event the owning thread may
+	// have overwritten during the copy is dropped: the copy is checked against the count after it,
+	// allowing for the write of event after, which may be under way in the slot of event
+	// after - RingEvents while the count still reads after.
+	//
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<TraceEvent> collect()
+	{
+		std::vector<std::shared_ptr<Ring>> rings;
+		{
+			std::lock_guard<std::mutex> lock(_ringsMutex);
+			rings = _rings;
+		}
+		std::vector<TraceEvent> events;
+		for (const auto & ring : rings)
+		{
+			std::uint64_t end = ring->_count.load(std::memory_order_acquire);
+			std::uint64_t begin = end > RingEvents ? end - RingEvents : 0;
+			std::vector<TraceEvent> copied;
+			copied.reserve(static_cast<std::size_t>(end - begin));
+			for (std::uint64_t i = begin; i < end; i++)
+			{
+				const std::atomic<std::uint64_t> * words = &ring->_words[EventWords * (i % RingEvents)];
+				std::uint64_t packed = words[2].load(std::memory_order_relaxed);
+				TraceEvent event;
+				event._start = words[0].load(std::memory_order_relaxed);
+				event._end = words[1].load(std::memory_order_relaxed);
+				event._keyHash = static_cast<std::uint32_t>(packed);
+				event._thread = static_cast<std::uint16_t>(packed >> 32);
+				event._operation = static_cast<std::uint8_t>(packed >> 48);
+				event._levels = static_cast<std::uint8_t>(packed >> 56);
+				copied.push_back(event);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			std::uint64_t after = ring->_count.load(std::memory_order_relaxed);
+			std::uint64_t firstIntact = after + 1 > RingEvents ? after + 1 - RingEvents : 0;
+			for (std::uint64_t i = std::max(begin, firstIntact); i < end; i++)
+				events.push_back(copied[static_cast<std::size_t>(i - begin)]);
+		}
+		std::sort(events.begin(), events.end(),
+		          [](const TraceEvent & a, const TraceEvent & b) { return a._start < b._start; });
+		return events;
+	}
+
+	// ticksPerSecond
+	// Returns the rate of ticks(), measured against steady_clock since the policy was made.
+	//
+	// No-Throw Guarantee
+	std::uint64_t ticksPerSecond() const
+	{
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - _startTime).count();
+		std::uint64_t elapsed = ticks() - _startTicks;
+		return seconds > 0.0 ? static_cast<std::uint64_t>(static_cast<double>(elapsed) / seconds) : 0;
+	}
+
+	// encode, decode
+	// Convert between an unsigned integer and its first bytes bytes, least significant first.
+	//
+	// No-Throw Guarantee
+	static void encode(char * out, std::uint64_t value, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+			out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+	}
+
+	static std::uint64_t decode(const char * in, int bytes)
+	{
+		std::uint64_t value = 0;
+		for (int i = 0; i < bytes; i++)
+			value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+		return value;
+	}
+};
+
+#endif // FILE_SKIPLIST_TRACE_H_INCLUDED
@@ -0,0 +1,585 @@
+// skiplist_wal.h
+// 18 Oct 2026
+//
+// Header for classes WriteAheadLog and DurableSkipList
+// An append-only log of inserts and removes with group commit, and a SkipList that replays it on open.
+// Requires skiplist.h and a POSIX system (open, write, fdatasync)
+
+#ifndef FILE_SKIPLIST_WAL_H_INCLUDED
+#define FILE_SKIPLIST_WAL_H_INCLUDED
+
+#include "skiplist.h"			// for class SkipList, struct DurableFile
+#include <string>				// for std::string, std::to_string
+#include <vector>				// for std::vector
+#include <memory>				// for std::unique_ptr
+#include <deque>				// for std::deque
+#include <algorithm>			// for std::copy
+#include <mutex>				// for std::mutex, std::lock_guard, std::unique_lock
+#include <condition_variable>	// for std::condition_variable
+#include <stdexcept>			// for std::runtime_error
+#include <cstring>				// for std::strerror
+#include <cstdint>				// for std::uint32_t
+#include <cerrno>				// for errno
+#include <fcntl.h>				// for open
+#include <unistd.h>				// for read, write, close, fdatasync, ftruncate
+#include <sys/stat.h>			// for fstat
+
+// enum class WalSyncPolicy
+// When WriteAheadLog makes appended records durable with fdatasync.
+//		EveryCommit: before each commit returns. Concurrent commits share one fdatasync.
+//		EveryN:      on every N-th record; a crash may lose up to N - 1 records.
+//		OnClose:     only when the log is closed or sync() is called.
+enum class WalSyncPolicy { EveryCommit, EveryN, OnClose };
+
+// class WriteAheadLog
+// Append-only file of (operation, key) records, each protected by a CRC-32.
+//
+// Record layout, little-endian: operation (uint8), key (int32), CRC-32 of the previous 5 bytes (uint32).
+//
+// Records are appended to an in-memory buffer under _mutex and numbered with a log sequence number.
+// Making them durable is group commit: the first thread to need a sync becomes the leader, takes the
+// whole buffer, writes it and calls fdatasync outside the lock while later committers queue behind it.
+// When it finishes, one of the waiters leads the next group with everything that arrived meanwhile,
+// so a single fdatasync covers many operations under load.
+//
+// A failed write or fdatasync is permanent, as in PostgreSQL: after a failed fdatasync the kernel
+// may have dropped the dirty pages, so a retry that succeeds proves nothing. The leader cuts the
+// file back to the end of the last good group, so that replay recovers every record ever reported
+// durable, and records the failure; from then on append, commit and sync all throw.
+//
+// Invariants:
+//		_durable <= _written <= _appended
+//		_buffer holds records _written + 1 through _appended, in order
+//		_fileBytes is the size of the file once the records up to _written are written
+//		At most one thread writes to _fd at a time (_syncing)
+//		Once _failure is set, _written and _durable never change
+class WriteAheadLog {
+// ***** WriteAheadLog: Types and Constants *****
+public:
+	enum Operation : unsigned char { Insert = 1, Remove = 2 };
+	static const std::size_t RecordBytes = 9;
+
+private:
+	static const std::size_t FlushBytes = 1 << 16;	// Buffered bytes that trigger a write without a sync
+
+// ***** WriteAheadLog: Data Members *****
+private:
+	int _fd;
+	WalSyncPolicy _policy;
+	unsigned long long _syncEvery;
+	std::mutex _mutex;
+	std::condition_variable _groupDone;
+	std::vector<char> _buffer;
+	unsigned long long _appended;	// Log sequence number of the last record appended
+	unsigned long long _written;	// ... of the last record handed to write
+	unsigned long long _durable;	// ... of the last record covered by fdatasync
+	off_t _fileBytes;
+	bool _syncing;
+	unsigned long long _syncCount;
+	std::string _failure;			// Why the log failed, empty while it is healthy
+
+// ***** WriteAheadLog: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Opens path for appending, creating it if necessary, and syncs its directory so that a new
+	// log survives a crash along with the records synced to it. Records already in the file are
+	// not read; use replay for that first.
+	//
+	// Preconditions: syncEvery >= 1
+	// Exceptions: Throws std::runtime_error if the file cannot be opened or its directory synced
+	// Strong Guarantee, Exception Neutral
+	WriteAheadLog(const std::string & path, WalSyncPolicy policy, unsigned long long syncEvery = 1)
+		: _fd(-1), _policy(policy), _syncEvery(syncEvery ? syncEvery : 1),
+		  _appended(0), _written(0), _durable(0), _fileBytes(0), _syncing(false), _syncCount(0)
+	{
+		_fd = ::open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+		if (_fd < 0)
+			throw std::runtime_error("WriteAheadLog: cannot open " + path + ": " + std::strerror(errno));
+		try {
+			DurableFile::syncDirectory(path);
+		}
+		catch (const std::runtime_error & error) {
+			::close(_fd);
+			throw std::runtime_error(std::string("WriteAheadLog: ") + error.what());
+		}
+		struct stat status;
+		if (::fstat(_fd, &status) == 0)
+			_fileBytes = status.st_size;
+		_buffer.reserve(FlushBytes + RecordBytes);
+	}
+
+	WriteAheadLog(const WriteAheadLog & other) = delete;
+	WriteAheadLog & operator=(const WriteAheadLog & other) = delete;
+
+	// Destructor
+	// Makes every appended record durable and closes the file.
+	//
+	// Preconditions: No other thread is using the log
+	// No-Throw Guarantee
+	~WriteAheadLog()
+	{
+		try {
+			sync();
+		}
+		catch (...) {
+			// Nothing can be reported from a destructor; records not yet durable may be lost
+		}
+		::close(_fd);
+	}
+
+// ***** WriteAheadLog: Public Member Functions *****
+public:
+	// append
+	// Buffers a record and returns its log sequence number. The record is not durable until commit.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if the log has failed; throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	unsigned long long append(Operation operation, int key)
+	{
+		char record[RecordBytes];
+		record[0] = static_cast<char>(operation);
+		std::uint32_t bits = static_cast<std::uint32_t>(key);
+		for (int i = 0; i < 4; i++)
+			record[1 + i] = static_cast<char>((bits >> (8 * i)) & 0xFF);
+		std::uint32_t crc = crc32(record, 5);
+		for (int i = 0; i < 4; i++)
+			record[5 + i] = static_cast<char>((crc >> (8 * i)) & 0xFF);
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (!_failure.empty())
+			throw std::runtime_error(_failure);
+		_buffer.insert(_buffer.end(), record, record + RecordBytes);
+		return ++_appended;
+	}
+
+	// commit
+	// Applies the sync policy to the record numbered lsn: under EveryCommit waits until it is durable,
+	// under EveryN syncs if it is an N-th record, and otherwise writes the buffer out once it is large.
+	//
+	// Preconditions: lsn was returned by append
+	// Exceptions: Throws std::runtime_error if writing or syncing fails, now or earlier
+	// Basic Guarantee, Exception Neutral
+	void commit(unsigned long long lsn)
+	{
+		if (_policy == WalSyncPolicy::EveryCommit || (_policy == WalSyncPolicy::EveryN && lsn % _syncEvery == 0))
+		{
+			waitFor(lsn, true);
+			return;
+		}
+		bool large;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			large = _buffer.size() >= FlushBytes;
+		}
+		if (large)
+			waitFor(lsn, false);
+	}
+
+	// sync
+	// Makes every record appended so far durable.
+	//
+	// Preconditions: None
+	// Exceptions: Throws std::runtime_error if writing or syncing fails, now or earlier
+	// Basic Guarantee, Exception Neutral
+	void sync()
+	{
+		unsigned long long lsn;
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			lsn = _appended;
+		}
+		waitFor(lsn, true);
+	}
+
+	// syncCount
+	// Returns the number of fdatasync calls made so far.
+	//
+	// No-Throw Guarantee
+	unsigned long long syncCount()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		return _syncCount;
+	}
+
+	// replay
+	// Calls apply(operation, key) for each intact record of the log at path, in order, then truncates
+	// the file after the last intact record so that a torn write from a crash is discarded, and syncs
+	// the truncation before returning, so records appended afterwards never sit behind a torn tail
+	// that a second crash could bring back. Returns the number of records replayed. A missing file
+	// replays nothing. Damage is only taken for a torn write when nothing intact follows it; a damaged
+	// record with intact records after it is corruption, and the file is left as it was.
+	//
+	// Preconditions: No WriteAheadLog has path open
+	// Exceptions:
+	//		Throws std::runtime_error if the file cannot be read, truncated or synced, or is corrupt
+	//		Throws if apply throws
+	// Basic Guarantee, Exception Neutral
+	template <typename Apply>
+	static unsigned long long replay(const std::string & path, Apply apply)
+	{
+		int fd = ::open(path.c_str(), O_RDWR);
+		if (fd < 0)
+		{
+			if (errno == ENOENT)
+				return 0;
+			throw std::runtime_error("WriteAheadLog: cannot open " + path + ": " + std::strerror(errno));
+		}
+
+		unsigned long long replayed = 0;
+		try {
+			std::vector<char> chunk(FlushBytes / RecordBytes * RecordBytes);
+			std::size_t carried = 0;
+			bool damaged = false;
+			for (;;)
+			{
+				ssize_t got = ::read(fd, chunk.data() + carried, chunk.size() - carried);
+				if (got < 0 && errno == EINTR)
+					continue;
+				if (got < 0)
+					throw std::runtime_error("WriteAheadLog: cannot read " + path + ": " + std::strerror(errno));
+				if (got == 0)
+					break;
+				std::size_t available = carried + static_cast<std::size_t>(got);
+				std::size_t offset = 0;
+				for (; offset + RecordBytes <= available; offset += RecordBytes)
+				{
+					Operation operation;
+					int key;
+					bool intact = decode(chunk.data() + offset, operation, key);
+					if (damaged && intact)
+						throw std::runtime_error("WriteAheadLog: " + path + " is corrupt: record " +
+						                         std::to_string(replayed + 1) + " is damaged but later records are intact");
+					if (!intact)
+					{
+						damaged = true;
+						continue;
+					}
+					apply(operation, key);
+					replayed++;
+				}
+				carried = available - offset;
+				std::copy(chunk.begin() + offset, chunk.begin() + available, chunk.begin());
+			}
+
+			if (damaged || carried > 0)
+			{
+				if (::ftruncate(fd, static_cast<off_t>(replayed * RecordBytes)) != 0)
+					throw std::runtime_error("WriteAheadLog: cannot truncate " + path + ": " + std::strerror(errno));
+				if (::fdatasync(fd) != 0)
+					throw std::runtime_error("WriteAheadLog: cannot sync " + path + ": " + std::strerror(errno));
+			}
+		}
+		catch (...) {
+			::close(fd);
+			throw;
+		}
+		::close(fd);
+		return replayed;
+	}
+
+// ***** WriteAheadLog: Private Member Functions *****
+private:
+	// waitFor
+	// Returns once record lsn has been written and, if durable is true, synced.
+	// Either leads a group itself or waits for the current leader, as described above.
+	// A waiter whose record was in a group that failed throws rather than leading a new group,
+	// since its record is gone.
+	//
+	// Exceptions: Throws std::runtime_error if writing or syncing fails, now or earlier
+	// Basic Guarantee, Exception Neutral
+	void waitFor(unsigned long long lsn, bool durable)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		while ((durable ? _durable : _written) < lsn)
+		{
+			if (!_failure.empty())
+				throw std::runtime_error(_failure);
+			if (_syncing)
+			{
+				_groupDone.wait(lock);
+				continue;
+			}
+			_syncing = true;
+			std::vector<char> group;
+			group.reserve(FlushBytes + RecordBytes);
+			group.swap(_buffer);
+			unsigned long long target = _appended;
+			lock.unlock();
+
+			const char * error = nullptr;
+			std::size_t done = 0;
+			while (!error && done < group.size())
+			{
+				ssize_t wrote = ::write(_fd, group.data() + done, group.size() - done);
+				if (wrote < 0 && errno != EINTR)
+					error = "write";
+				else if (wrote > 0)
+					done += static_cast<std::size_t>(wrote);
+			}
+			if (!error && durable && ::fdatasync(_fd) != 0)
+				error = "fdatasync";
+			int savedErrno = errno;
+			if (error)
+			{
+				// Drop any torn record, so replay reaches everything before this group; best effort
+				if (::ftruncate(_fd, _fileBytes) == 0)
+					::fdatasync(_fd);
+			}
+
+			lock.lock();
+			_syncing = false;
+			_groupDone.notify_all();
+			if (error)
+			{
+				_failure = std::string("WriteAheadLog: ") + error + " failed: " + std::strerror(savedErrno);
+				throw std::runtime_error(_failure);
+			}
+			_fileBytes += static_cast<off_t>(group.size());
+			_written = target;
+			if (durable)
+			{
+				_durable = target;
+				_syncCount++;
+			}
+		}
+	}
+
+	// decode
+	// Reads the operation and key of the record at record. Returns false, leaving them unset, if
+	// its CRC does not match or its operation is unknown.
+	//
+	// No-Throw Guarantee
+	static bool decode(const char * record, Operation & operation, int & key)
+	{
+		std::uint32_t stored = 0;
+		for (int i = 0; i < 4; i++)
+			stored |= static_cast<std::uint32_t>(static_cast<unsigned char>(record[5 + i])) << (8 * i);
+		if (stored != crc32(record, 5) || (record[0] != Insert && record[0] != Remove))
+			return false;
+		std::uint32_t bits = 0;
+		for (int i = 0; i < 4; i++)
+			bits |= static_cast<std::uint32_t>(static_cast<unsigned char>(record[1 + i])) << (8 * i);
+		operation = static_cast<Operation>(record[0]);
+		key = static_cast<int>(bits);
+		return true;
+	}
+
+	// crc32
+	// Returns the CRC-32 (IEEE 802.3 polynomial) of size bytes at data.
+	//
+	// No-Throw Guarantee
+	static std::uint32_t crc32(const char * data, std::size_t size)
+	{
+		static const struct Table {
+			std::uint32_t _entries[256];
+			Table()
+			{
+				for (std::uint32_t i = 0; i < 256; i++)
+				{
+					std::uint32_t value = i;
+					for (int bit = 0; bit < 8; bit++)
+						value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+					_entries[i] = value;
+				}
+			}
+		} table;
+
+		std::uint32_t crc = 0xFFFFFFFFu;
+		for (std::size_t i = 0; i < size; i++)
+			crc = table._entries[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+		return crc ^ 0xFFFFFFFFu;
+	}
+};
+
+// class DurableSkipList
+// A SkipList whose inserts and removes are recorded in a WriteAheadLog before they return.
+// Opening replays the log, so the list comes back as it was after the last durable operation.
+// An operation is appended to the log under _listMutex and committed outside it, letting concurrent
+// writers share a sync, and is applied to the list only once committed, so a reader never sees it
+// before the sync policy has been met. Operations are applied in log order: each waits in _pending
+// until every earlier one is committed or has failed, and whichever writer completes the run
+// applies it. An operation whose commit fails is dropped, never applied.
+//
+// Invariants:
+//		_list is the result of replaying, in order, every record of _log up to _applied whose commit succeeded
+//		_pending holds the records after _applied, in order
+class DurableSkipList {
+// ***** DurableSkipList: Types *****
+private:
+	// struct PendingRecord
+	// A logged operation waiting to be applied, and whether its commit has finished.
+	struct PendingRecord {
+		enum State { Waiting, Committed, Failed };
+
+		WriteAheadLog::Operation _operation;
+		int _key;
+		State _state;
+	};
+
+// ***** DurableSkipList: Data Members *****
+private:
+	SkipList _list;
+	std::mutex _listMutex;
+	std::condition_variable _appliedChanged;
+	std::deque<PendingRecord> _pending;
+	unsigned long long _applied;		// Log sequence number of the last record applied or dropped
+	std::unique_ptr<WriteAheadLog> _log;
+
+// ***** DurableSkipList: Constructors and Destructors *****
+public:
+	// Parameterized Constructor
+	// Replays the log at path into a new list and opens it for further appends.
+	//
+	// Preconditions: syncEvery >= 1
+	// Exceptions: Throws std::runtime_error if the log cannot be read or opened
+	// Strong Guarantee, Exception Neutral
+	explicit DurableSkipList(const std::string & path,
+	                         WalSyncPolicy policy = WalSyncPolicy::EveryCommit,
+	                         unsigned long long syncEvery = 1)
+		: _applied(0)
+	{
+		WriteAheadLog::replay(path, [this](WriteAheadLog::Operation operation, int key) {
+			apply(operation, key);
+		});
+		_log.reset(new WriteAheadLog(path, policy, syncEvery));
+	}
+
+	~DurableSkipList() = default;
+
+// ***** DurableSkipList: Public Member Functions *****
+public:
+	// insert, remove
+	// Log the operation, commit it according to the sync policy, then apply it to the list.
+	// On return the operation is visible to search and range.
+	//
+	// Preconditions: None
+	// Exceptions:
+	//		Throws std::runtime_error if the log cannot be written; the list is then unchanged
+	//		Throws if SkipList throws
+	// Basic Guarantee, Exception Neutral
+	void insert(int key)
+	{
+		write(WriteAheadLog::Insert, key);
+	}
+
+	void remove(int key)
+	{
+		write(WriteAheadLog::Remove, key);
+	}
+
+	// search
+	// Returns true if key is in the list.
+	//
+	// Preconditions: None
+	// No-Throw Guarantee
+	bool search(int key)
+	{
+		std::lock_guard<std::mutex> lock(_listMutex);
+		return static_cast<bool>(_list.search(key));
+	}
+
+	// range
+	// Returns the keys in [lowKey, highKey], in sorted order.
+	//
+	// Preconditions: None
+	// Exceptions: Throws if std::vector throws
+	// Strong Guarantee, Exception Neutral
+	std::vector<int> range(int lowKey, int highKey)
+	{
+		std::lock_guard<std::mutex> lock(_listMutex);
+		return _list.range(lowKey, highKey);
+	}
+
+	// sync, log
+	// Make every logged operation durable; access the underlying log.
+	//
+	// Exceptions: sync throws std::runtime_error if writing or syncing fails
+	void sync()
+	{
+		_log->sync();
+	}
+
+	WriteAheadLog & log()
+	{
+		return *_log;
+	}
+
+// ***** DurableSkipList: Private Member Functions *****
+private:
+	// write
+	// Appends operation on key to the log, commits it and applies it, as described above.
+	//
+	// Exceptions: As insert and remove
+	// Basic Guarantee, Exception Neutral
+	void write(WriteAheadLog::Operation operation, int key)
+	{
+		unsigned long long lsn;
+		{
+			std::lock_guard<std::mutex> lock(_listMutex);
+			_pending.push_back(PendingRecord{ operation, key, PendingRecord::Waiting });
+			try {
+				lsn = _log->append(operation, key);
+			}
+			catch (...) {
+				_pending.pop_back();
+				throw;
+			}
+		}
+		try {
+			_log->commit(lsn);
+		}
+		catch (...) {
+			settle(lsn, PendingRecord::Failed);
+			throw;
+		}
+		settle(lsn, PendingRecord::Committed);
+	}
+
+	// settle
+	// Records that the commit of record lsn finished in state, then applies the run of finished
+	// records at the front of _pending and waits until record lsn has been applied or dropped.
+	//
+	// Exceptions: Throws if SkipList throws; the record stays at the front to be applied by the next writer
+	// Basic Guarantee, Exception Neutral
+	void settle(unsigned long long lsn, PendingRecord::State state)
+	{
+		std::unique_lock<std::mutex> lock(_listMutex);
+		_pending[lsn - _applied - 1]._state = state;
+		while (_applied < lsn)
+		{
+			if (_pending.front()._state == PendingRecord::Waiting)
+			{
+				_appliedChanged.wait(lock);
+				continue;
+			}
+			try {
+				if (_pending.front()._state == PendingRecord::Committed)
+					apply(_pending.front()._operation, _pending.front()._key);
+			}
+			catch (...) {
+				_appliedChanged.notify_all();
+				throw;
+			}
+			_pending.pop_front();
+			_applied++;
+			_appliedChanged.notify_all();
+		}
+	}
+
+	// apply
+	// Makes the list reflect operation on key.
+	//
+	// Preconditions: Caller holds _listMutex, or no other thread is using the list
+	// Exceptions: Throws if SkipList throws
+	// Strong Guarantee, Exception Neutral
+	void apply(WriteAheadLog::Operation operation, int key)
+	{
+		if (operation == WriteAheadLog::Insert)
+			_list.insert(key);
+		else
+			_list.remove(key);
+	}
+};
+
+#endif // #ifndef FILE_SKIPLIST_WAL_H_INCLUDED